@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "app-list-model.c"
+
+#include "bench.h"
+
+#define N_APPS 200
+
+
+static void
+bench_rebuild (guint64 n_iterations, gpointer user_data)
+{
+  PhoshAppListModel *model = PHOSH_APP_LIST_MODEL (user_data);
+
+  for (guint64 i = 0; i < n_iterations; i++)
+    items_changed (model);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_autoptr (PhoshAppListModel) model = NULL;
+  PhoshAppListModelPrivate *priv;
+
+  phosh_bench_init (&argc, &argv);
+  phosh_bench_create_apps (N_APPS);
+
+  model = g_object_ref (phosh_app_list_model_get_default ());
+  priv = phosh_app_list_model_get_instance_private (model);
+  /* We rebuild explicitly */
+  g_clear_handle_id (&priv->debounce, g_source_remove);
+
+  items_changed (model);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, N_APPS);
+
+  phosh_bench_add ("app-list-model/rebuild/200-apps", bench_rebuild, model);
+
+  return phosh_bench_run ();
+}
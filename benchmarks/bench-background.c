@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "background.c"
+
+#include "bench.h"
+
+#define SCREEN_WIDTH 1080
+#define SCREEN_HEIGHT 2340
+
+static GdkPixbuf *wallpaper;
+
+
+static void
+bench_scale_to_min (guint64 n_iterations, gpointer user_data)
+{
+  for (guint64 i = 0; i < n_iterations; i++) {
+    g_autoptr (GdkPixbuf) scaled = pb_scale_to_min (wallpaper, SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    phosh_bench_keep (scaled);
+  }
+}
+
+
+static void
+bench_scale_to_fit (guint64 n_iterations, gpointer user_data)
+{
+  GdkRGBA color = { 0.2, 0.2, 0.2, 1.0 };
+
+  for (guint64 i = 0; i < n_iterations; i++) {
+    g_autoptr (GdkPixbuf) scaled = pb_scale_to_fit (wallpaper, SCREEN_WIDTH, SCREEN_HEIGHT, &color);
+
+    phosh_bench_keep (scaled);
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int ret;
+
+  phosh_bench_init (&argc, &argv);
+
+  /* A typical landscape photo */
+  wallpaper = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 4000, 3000);
+  gdk_pixbuf_fill (wallpaper, 0x336699ff);
+
+  phosh_bench_add ("background/scale-to-min/4000x3000", bench_scale_to_min, NULL);
+  phosh_bench_add ("background/scale-to-fit/4000x3000", bench_scale_to_fit, NULL);
+
+  ret = phosh_bench_run ();
+
+  g_object_unref (wallpaper);
+
+  return ret;
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "bench.h"
+
+#include "monitor/gamma-table.h"
+
+#define MAX_RAMP_SIZE 4096
+
+
+static void
+bench_gamma_table_fill (guint64 n_iterations, gpointer user_data)
+{
+  guint32 ramp_size = GPOINTER_TO_UINT (user_data);
+  guint16 table[MAX_RAMP_SIZE * 3];
+
+  for (guint64 i = 0; i < n_iterations; i++) {
+    /* Cycle through the temperatures night light uses */
+    phosh_gamma_table_fill (table, ramp_size, 1700 + (i % 48) * 100);
+    phosh_bench_keep (table);
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  phosh_bench_init (&argc, &argv);
+
+  phosh_bench_add ("gamma-table/fill/256", bench_gamma_table_fill, GUINT_TO_POINTER (256));
+  phosh_bench_add ("gamma-table/fill/4096", bench_gamma_table_fill,
+                   GUINT_TO_POINTER (MAX_RAMP_SIZE));
+
+  return phosh_bench_run ();
+}
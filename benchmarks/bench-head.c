@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "bench.h"
+
+#include "monitor/head-priv.h"
+
+/* A monitor with lots of modes like a typical 4K display */
+static const struct {
+  int width, height;
+} resolutions[] = {
+  { 3840, 2160 }, { 3200, 1800 }, { 2880, 1620 }, { 2560, 1600 }, { 2560, 1440 },
+  { 2048, 1536 }, { 1920, 1200 }, { 1920, 1080 }, { 1680, 1050 }, { 1600, 1200 },
+  { 1600, 900 },  { 1440, 900 },  { 1400, 1050 }, { 1366, 768 },  { 1280, 1024 },
+  { 1280, 960 },  { 1280, 800 },  { 1280, 720 },  { 1024, 768 },  { 800, 600 },
+};
+static const int refresh_rates[] = { 60000, 50000 };
+
+static GPtrArray *modes;
+
+
+static void
+bench_calculate_supported_scales (guint64 n_iterations, gpointer user_data)
+{
+  for (guint64 i = 0; i < n_iterations; i++) {
+    for (guint j = 0; j < modes->len; j++) {
+      g_autofree float *scales = NULL;
+      int n;
+
+      scales = phosh_head_calculate_supported_mode_scales (NULL, g_ptr_array_index (modes, j),
+                                                           &n, TRUE);
+      phosh_bench_keep (scales);
+    }
+  }
+}
+
+
+static void
+bench_get_supported_scales (guint64 n_iterations, gpointer user_data)
+{
+  for (guint64 i = 0; i < n_iterations; i++) {
+    for (guint j = 0; j < modes->len; j++) {
+      int n;
+
+      phosh_bench_keep (phosh_head_mode_get_supported_scales (g_ptr_array_index (modes, j), &n));
+    }
+  }
+}
+
+/*
+ * Serialize the modes like GetCurrentState does. The full reply needs
+ * a wlr output manager so we only look at the per mode part which
+ * dominates for monitors with many modes.
+ */
+static void
+bench_serialize_modes (guint64 n_iterations, gpointer user_data)
+{
+  for (guint64 i = 0; i < n_iterations; i++) {
+    g_autoptr (GVariant) variant = NULL;
+
+    variant = g_variant_ref_sink (phosh_head_modes_to_variant (modes,
+                                                               g_ptr_array_index (modes, 0)));
+    phosh_bench_keep (variant);
+  }
+}
+
+
+static void
+mode_free (PhoshHeadMode *mode)
+{
+  g_free (mode->name);
+  g_free (mode->supported_scales);
+  g_free (mode);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int ret;
+
+  phosh_bench_init (&argc, &argv);
+
+  modes = g_ptr_array_new_with_free_func ((GDestroyNotify) mode_free);
+  for (int i = 0; i < G_N_ELEMENTS (resolutions); i++) {
+    for (int j = 0; j < G_N_ELEMENTS (refresh_rates); j++) {
+      PhoshHeadMode *mode = g_new0 (PhoshHeadMode, 1);
+
+      mode->width = resolutions[i].width;
+      mode->height = resolutions[i].height;
+      mode->refresh = refresh_rates[j];
+      mode->preferred = (i == 0 && j == 0);
+      mode->name = g_strdup_printf ("%dx%d@%.0f", mode->width, mode->height,
+                                    mode->refresh / 1000.0);
+      g_ptr_array_add (modes, mode);
+    }
+  }
+
+  phosh_bench_add ("head/supported-scales/40-modes", bench_calculate_supported_scales, NULL);
+  phosh_bench_add ("head/supported-scales-cached/40-modes", bench_get_supported_scales, NULL);
+  phosh_bench_add ("head/serialize-modes/40-modes", bench_serialize_modes, NULL);
+
+  ret = phosh_bench_run ();
+
+  g_ptr_array_unref (modes);
+
+  return ret;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "bench.h"
+
+#include "notifications/notification-list.h"
+
+#define N_SOURCES 20
+#define N_NOTIFICATIONS 200
+#define BURST_SIZE 100
+
+static guint next_id = 1;
+
+
+static PhoshNotification *
+add_notification (PhoshNotificationList *list, GDateTime *now)
+{
+  g_autoptr (PhoshNotification) noti = NULL;
+  g_autofree char *source_id = g_strdup_printf ("org.phosh.Bench%u", next_id % N_SOURCES);
+
+  noti = phosh_notification_new (next_id++,
+                                 NULL,
+                                 NULL,
+                                 "Benchmark",
+                                 "Measuring notification list performance",
+                                 NULL,
+                                 NULL,
+                                 PHOSH_NOTIFICATION_URGENCY_NORMAL,
+                                 NULL,
+                                 FALSE,
+                                 FALSE,
+                                 NULL,
+                                 NULL,
+                                 now);
+  phosh_notification_list_add (list, source_id, noti);
+
+  return noti;
+}
+
+
+static void
+bench_add_close (guint64 n_iterations, gpointer user_data)
+{
+  PhoshNotificationList *list = PHOSH_NOTIFICATION_LIST (user_data);
+  g_autoptr (GDateTime) now = g_date_time_new_now_local ();
+
+  for (guint64 i = 0; i < n_iterations; i++) {
+    PhoshNotification *noti = add_notification (list, now);
+
+    phosh_notification_close (noti, PHOSH_NOTIFICATION_REASON_CLOSED);
+  }
+}
+
+
+static void
+bench_burst (guint64 n_iterations, gpointer user_data)
+{
+  PhoshNotificationList *list = PHOSH_NOTIFICATION_LIST (user_data);
+  g_autoptr (GDateTime) now = g_date_time_new_now_local ();
+  g_autoptr (GPtrArray) burst = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint64 i = 0; i < n_iterations; i++) {
+    for (int j = 0; j < BURST_SIZE; j++)
+      g_ptr_array_add (burst, g_object_ref (add_notification (list, now)));
+
+    for (int j = 0; j < BURST_SIZE; j++)
+      phosh_notification_close (g_ptr_array_index (burst, j), PHOSH_NOTIFICATION_REASON_CLOSED);
+
+    g_ptr_array_set_size (burst, 0);
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_autoptr (PhoshNotificationList) list = NULL;
+  g_autoptr (GDateTime) now = g_date_time_new_now_local ();
+
+  phosh_bench_init (&argc, &argv);
+
+  /* Keep a realistic backlog of notifications around */
+  list = phosh_notification_list_new ();
+  for (int i = 0; i < N_NOTIFICATIONS; i++)
+    add_notification (list, now);
+
+  phosh_bench_add ("notification-list/add-close/200-notifications", bench_add_close, list);
+  phosh_bench_add ("notification-list/burst-100/200-notifications", bench_burst, list);
+
+  return phosh_bench_run ();
+}
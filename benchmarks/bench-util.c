@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "bench.h"
+
+#include "util.h"
+
+#include <gio/gdesktopappinfo.h>
+
+#define N_APPS 200
+#define SCREEN_WIDTH 1080
+#define SCREEN_HEIGHT 2340
+
+static GList *apps;
+static guint8 *buffer;
+
+
+static void
+bench_matches_app_info (guint64 n_iterations, gpointer user_data)
+{
+  const char *search = user_data;
+
+  for (guint64 i = 0; i < n_iterations; i++) {
+    for (GList *l = apps; l; l = l->next) {
+      gboolean match = phosh_util_matches_app_info (l->data, search);
+
+      phosh_bench_keep (GINT_TO_POINTER (match));
+    }
+  }
+}
+
+
+static void
+bench_convert_buffer (guint64 n_iterations, gpointer user_data)
+{
+  for (guint64 i = 0; i < n_iterations; i++) {
+    phosh_convert_buffer (buffer, WL_SHM_FORMAT_ABGR8888, SCREEN_WIDTH, SCREEN_HEIGHT,
+                          SCREEN_WIDTH * 4);
+    phosh_bench_keep (buffer);
+  }
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  int ret;
+
+  phosh_bench_init (&argc, &argv);
+  phosh_bench_create_apps (N_APPS);
+  apps = g_app_info_get_all ();
+  g_assert_cmpint (g_list_length (apps), ==, N_APPS);
+  buffer = g_malloc0 (SCREEN_WIDTH * 4 * SCREEN_HEIGHT);
+
+  /* Matches the first attribute of every app */
+  phosh_bench_add ("util/matches-app-info/hit", bench_matches_app_info, "benchmark");
+  /* Only matches a single app via its keywords */
+  phosh_bench_add ("util/matches-app-info/keyword", bench_matches_app_info, "app199");
+  /* Checks all attributes of every app */
+  phosh_bench_add ("util/matches-app-info/miss", bench_matches_app_info, "nothing");
+  phosh_bench_add ("util/convert-buffer/1080x2340", bench_convert_buffer, NULL);
+
+  ret = phosh_bench_run ();
+
+  g_list_free_full (apps, g_object_unref);
+  g_free (buffer);
+
+  return ret;
+}
@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "bench.h"
+
+#include <gio/gio.h>
+
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * A tiny micro benchmark harness. Each benchmark is calibrated so a
+ * run takes at least --min-time, then run --repeats times. The median
+ * time per operation is reported together with the number of
+ * allocations per operation.
+ */
+
+#define MAX_REPEATS 25
+
+typedef struct {
+  char           *name;
+  PhoshBenchFunc  func;
+  gpointer        user_data;
+
+  guint64         n_iterations;
+  double          ns_per_op;
+  double          allocs_per_op;
+} PhoshBench;
+
+static GPtrArray *benches;
+static char *apps_dir;
+
+static char *opt_json;
+static char *opt_baseline;
+static char *opt_filter;
+static double opt_threshold = 10.0;
+static int opt_min_time = 200;
+static int opt_repeats = 5;
+
+static GOptionEntry entries[] = {
+  { "json", 0, 0, G_OPTION_ARG_FILENAME, &opt_json,
+    "Write results as JSON to FILE ('-' for stdout)", "FILE" },
+  { "baseline", 0, 0, G_OPTION_ARG_FILENAME, &opt_baseline,
+    "Fail if a benchmark got slower than in the JSON results in FILE", "FILE" },
+  { "threshold", 0, 0, G_OPTION_ARG_DOUBLE, &opt_threshold,
+    "Allowed slowdown against the baseline in percent (default: 10)", "PERCENT" },
+  { "filter", 0, 0, G_OPTION_ARG_STRING, &opt_filter,
+    "Only run benchmarks whose name contains STRING", "STRING" },
+  { "min-time", 0, 0, G_OPTION_ARG_INT, &opt_min_time,
+    "Minimum time of a single run in milliseconds (default: 200)", "MS" },
+  { "repeats", 0, 0, G_OPTION_ARG_INT, &opt_repeats,
+    "Number of measured runs (default: 5)", "N" },
+  { NULL }
+};
+
+
+#if defined (__GLIBC__) && !defined (__SANITIZE_ADDRESS__)
+/* Count allocations by interposing glibc's allocator */
+#define HAVE_ALLOC_COUNTER 1
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static guint64 n_allocs;
+
+void *
+malloc (size_t size)
+{
+  __atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_malloc (size);
+}
+
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  __atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_calloc (nmemb, size);
+}
+
+
+void *
+realloc (void *ptr, size_t size)
+{
+  __atomic_fetch_add (&n_allocs, 1, __ATOMIC_RELAXED);
+  return __libc_realloc (ptr, size);
+}
+
+
+static guint64
+get_n_allocs (void)
+{
+  return __atomic_load_n (&n_allocs, __ATOMIC_RELAXED);
+}
+
+#else
+
+static guint64
+get_n_allocs (void)
+{
+  return 0;
+}
+
+#endif
+
+
+static gint64
+get_time_ns (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+
+static int
+compare_double (gconstpointer a, gconstpointer b)
+{
+  double da = *(const double *)a;
+  double db = *(const double *)b;
+
+  return (da > db) - (da < db);
+}
+
+
+static void
+phosh_bench_free (PhoshBench *bench)
+{
+  g_free (bench->name);
+  g_free (bench);
+}
+
+
+static void
+run_bench (PhoshBench *bench)
+{
+  gint64 min_time = (gint64)opt_min_time * G_GINT64_CONSTANT (1000000);
+  double samples[MAX_REPEATS];
+  guint64 allocs = 0;
+  guint64 n = 1;
+
+  /* Warm up while looking for an iteration count that takes min_time */
+  while (TRUE) {
+    gint64 start = get_time_ns ();
+    gint64 elapsed;
+
+    bench->func (n, bench->user_data);
+    elapsed = get_time_ns () - start;
+
+    if (elapsed >= min_time || n >= G_MAXUINT64 / 100)
+      break;
+
+    if (elapsed <= 0)
+      n *= 100;
+    else
+      n = CLAMP ((guint64)(n * 1.2 * min_time / elapsed), n + 1, n * 100);
+  }
+
+  for (int i = 0; i < opt_repeats; i++) {
+    guint64 allocs_before = get_n_allocs ();
+    gint64 start = get_time_ns ();
+
+    bench->func (n, bench->user_data);
+    samples[i] = (double)(get_time_ns () - start) / n;
+    allocs += get_n_allocs () - allocs_before;
+  }
+
+  qsort (samples, opt_repeats, sizeof (double), compare_double);
+  bench->n_iterations = n;
+  bench->ns_per_op = samples[opt_repeats / 2];
+#ifdef HAVE_ALLOC_COUNTER
+  bench->allocs_per_op = (double)allocs / (n * opt_repeats);
+#else
+  bench->allocs_per_op = -1.0;
+#endif
+}
+
+
+static gboolean
+write_json (GPtrArray *results, GError **error)
+{
+  g_autoptr (GString) json = g_string_new ("{\n  \"benchmarks\": [\n");
+
+  for (guint i = 0; i < results->len; i++) {
+    PhoshBench *bench = g_ptr_array_index (results, i);
+    char ns[G_ASCII_DTOSTR_BUF_SIZE], allocs[G_ASCII_DTOSTR_BUF_SIZE];
+
+    g_ascii_formatd (ns, sizeof (ns), "%.2f", bench->ns_per_op);
+    g_ascii_formatd (allocs, sizeof (allocs), "%.2f", bench->allocs_per_op);
+    g_string_append_printf (json,
+                            "    {\"name\": \"%s\", \"ns_per_op\": %s, "
+                            "\"allocs_per_op\": %s, \"iterations\": %" G_GUINT64_FORMAT "}%s\n",
+                            bench->name,
+                            ns,
+                            bench->allocs_per_op < 0 ? "null" : allocs,
+                            bench->n_iterations,
+                            i + 1 < results->len ? "," : "");
+  }
+  g_string_append (json, "  ]\n}\n");
+
+  if (g_strcmp0 (opt_json, "-") == 0) {
+    g_print ("%s", json->str);
+    return TRUE;
+  }
+
+  return g_file_set_contents (opt_json, json->str, json->len, error);
+}
+
+
+static GHashTable *
+read_baseline (GError **error)
+{
+  g_autoptr (GHashTable) baseline = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  g_autoptr (GRegex) regex = NULL;
+  g_autoptr (GMatchInfo) match = NULL;
+  g_autofree char *contents = NULL;
+
+  if (!g_file_get_contents (opt_baseline, &contents, NULL, error))
+    return NULL;
+
+  /* Good enough to parse what write_json() produces */
+  regex = g_regex_new ("\"name\":\\s*\"([^\"]+)\",\\s*\"ns_per_op\":\\s*([0-9.eE+-]+)", 0, 0, error);
+  if (regex == NULL)
+    return NULL;
+
+  g_regex_match (regex, contents, 0, &match);
+  while (g_match_info_matches (match)) {
+    g_autofree char *value = g_match_info_fetch (match, 2);
+    double *ns = g_new (double, 1);
+
+    *ns = g_ascii_strtod (value, NULL);
+    g_hash_table_insert (baseline, g_match_info_fetch (match, 1), ns);
+    g_match_info_next (match, NULL);
+  }
+
+  return g_steal_pointer (&baseline);
+}
+
+
+static gboolean
+check_baseline (GPtrArray *results, GError **error)
+{
+  g_autoptr (GHashTable) baseline = read_baseline (error);
+  gboolean ok = TRUE;
+
+  if (baseline == NULL)
+    return FALSE;
+
+  for (guint i = 0; i < results->len; i++) {
+    PhoshBench *bench = g_ptr_array_index (results, i);
+    double *base = g_hash_table_lookup (baseline, bench->name);
+    double change;
+
+    if (base == NULL || *base <= 0.0) {
+      g_printerr ("%-44s no baseline\n", bench->name);
+      continue;
+    }
+
+    change = (bench->ns_per_op / *base - 1.0) * 100.0;
+    if (change > opt_threshold) {
+      g_printerr ("%-44s REGRESSION %+.1f%% (%.1f ns/op → %.1f ns/op)\n",
+                  bench->name, change, *base, bench->ns_per_op);
+      ok = FALSE;
+    } else {
+      g_printerr ("%-44s %+.1f%%\n", bench->name, change);
+    }
+  }
+
+  if (!ok) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                 "Benchmarks regressed by more than %.1f%%", opt_threshold);
+  }
+
+  return ok;
+}
+
+static void
+remove_recursive (GFile *file)
+{
+  g_autoptr (GFileEnumerator) enumerator = NULL;
+
+  enumerator = g_file_enumerate_children (file, G_FILE_ATTRIBUTE_STANDARD_NAME,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, NULL, NULL);
+  while (enumerator) {
+    GFile *child;
+
+    if (!g_file_enumerator_iterate (enumerator, NULL, &child, NULL, NULL) || child == NULL)
+      break;
+
+    remove_recursive (child);
+  }
+
+  g_file_delete (file, NULL, NULL);
+}
+
+/**
+ * phosh_bench_init:
+ * @argc: Address of the argc parameter of main()
+ * @argv: Address of the argv parameter of main()
+ *
+ * Initializes the benchmark harness and parses the command line.
+ */
+void
+phosh_bench_init (int *argc, char ***argv)
+{
+  g_autoptr (GOptionContext) context = g_option_context_new ("- run benchmarks");
+  g_autoptr (GError) err = NULL;
+
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, argc, argv, &err)) {
+    g_printerr ("%s\n", err->message);
+    exit (EXIT_FAILURE);
+  }
+
+  opt_repeats = CLAMP (opt_repeats, 1, MAX_REPEATS);
+  opt_min_time = MAX (opt_min_time, 1);
+
+  benches = g_ptr_array_new_with_free_func ((GDestroyNotify) phosh_bench_free);
+}
+
+/**
+ * phosh_bench_add:
+ * @name: The benchmark's name like `util/convert-buffer`
+ * @func: The function to benchmark
+ * @user_data: Data passed to @func
+ *
+ * Registers a benchmark.
+ */
+void
+phosh_bench_add (const char *name, PhoshBenchFunc func, gpointer user_data)
+{
+  PhoshBench *bench;
+
+  g_return_if_fail (benches);
+
+  bench = g_new0 (PhoshBench, 1);
+  bench->name = g_strdup (name);
+  bench->func = func;
+  bench->user_data = user_data;
+  g_ptr_array_add (benches, bench);
+}
+
+/**
+ * phosh_bench_run:
+ *
+ * Runs all registered benchmarks, writes the results and compares
+ * them against the baseline if requested.
+ *
+ * Returns: The exit status for main()
+ */
+int
+phosh_bench_run (void)
+{
+  g_autoptr (GPtrArray) results = g_ptr_array_new ();
+  g_autoptr (GError) err = NULL;
+  int ret = EXIT_SUCCESS;
+
+  g_return_val_if_fail (benches, EXIT_FAILURE);
+
+  for (guint i = 0; i < benches->len; i++) {
+    PhoshBench *bench = g_ptr_array_index (benches, i);
+
+    if (opt_filter && !strstr (bench->name, opt_filter))
+      continue;
+
+    run_bench (bench);
+    g_ptr_array_add (results, bench);
+
+    if (bench->allocs_per_op < 0) {
+      g_printerr ("%-44s %12.1f ns/op\n", bench->name, bench->ns_per_op);
+    } else {
+      g_printerr ("%-44s %12.1f ns/op %10.2f allocs/op\n",
+                  bench->name, bench->ns_per_op, bench->allocs_per_op);
+    }
+  }
+
+  if (opt_json && !write_json (results, &err)) {
+    g_printerr ("Failed to write results: %s\n", err->message);
+    ret = EXIT_FAILURE;
+  }
+  g_clear_error (&err);
+
+  if (opt_baseline && !check_baseline (results, &err)) {
+    g_printerr ("%s\n", err->message);
+    ret = EXIT_FAILURE;
+  }
+
+  if (apps_dir) {
+    g_autoptr (GFile) dir = g_file_new_for_path (apps_dir);
+
+    remove_recursive (dir);
+    g_clear_pointer (&apps_dir, g_free);
+  }
+
+  g_clear_pointer (&benches, g_ptr_array_unref);
+  g_clear_pointer (&opt_json, g_free);
+  g_clear_pointer (&opt_baseline, g_free);
+  g_clear_pointer (&opt_filter, g_free);
+
+  return ret;
+}
+
+/**
+ * phosh_bench_keep:
+ * @value: A value
+ *
+ * Keeps the compiler from optimizing away the computation of @value.
+ */
+void
+phosh_bench_keep (gconstpointer value)
+{
+  static gconstpointer volatile sink;
+
+  sink = value;
+}
+
+/**
+ * phosh_bench_create_apps:
+ * @n_apps: The number of apps to create
+ *
+ * Creates @n_apps desktop files in a temporary directory and points
+ * the XDG data dirs there so benchmarks don't depend on the apps
+ * installed on the machine. Needs to be invoked before GIO looks up
+ * any apps.
+ */
+void
+phosh_bench_create_apps (guint n_apps)
+{
+  g_autofree char *applications = NULL;
+  g_autoptr (GError) err = NULL;
+
+  g_return_if_fail (apps_dir == NULL);
+
+  apps_dir = g_dir_make_tmp ("phosh-bench-XXXXXX", &err);
+  if (apps_dir == NULL)
+    g_error ("Failed to create app dir: %s", err->message);
+
+  applications = g_build_filename (apps_dir, "applications", NULL);
+  g_mkdir (applications, 0700);
+
+  for (guint i = 0; i < n_apps; i++) {
+    g_autofree char *filename = g_strdup_printf ("%s/org.phosh.Bench%u.desktop", applications, i);
+    g_autofree char *contents = NULL;
+
+    contents = g_strdup_printf ("[Desktop Entry]\n"
+                                "Type=Application\n"
+                                "Name=Benchmark App %u\n"
+                                "GenericName=Generic Benchmark Tool %u\n"
+                                "Comment=An app to measure how fast searching through apps is\n"
+                                "Exec=true\n"
+                                "Icon=org.phosh.Bench%u\n"
+                                "Keywords=bench;measure;speed;app%u;\n",
+                                i, i, i, i);
+    if (!g_file_set_contents (filename, contents, -1, &err))
+      g_error ("Failed to create %s: %s", filename, err->message);
+  }
+
+  /* Keep finding the system's schemas (e.g. for app folders) */
+  if (g_getenv ("GSETTINGS_SCHEMA_DIR") == NULL) {
+    const char *data_dirs = g_getenv ("XDG_DATA_DIRS") ?: "/usr/local/share/:/usr/share/";
+    g_auto (GStrv) dirs = g_strsplit (data_dirs, G_SEARCHPATH_SEPARATOR_S, -1);
+    g_autoptr (GStrvBuilder) schema_dirs = g_strv_builder_new ();
+    g_auto (GStrv) paths = NULL;
+    g_autofree char *schema_path = NULL;
+
+    for (int i = 0; dirs[i]; i++) {
+      g_autofree char *schema_dir = g_build_filename (dirs[i], "glib-2.0", "schemas", NULL);
+
+      g_strv_builder_add (schema_dirs, schema_dir);
+    }
+
+    paths = g_strv_builder_end (schema_dirs);
+    schema_path = g_strjoinv (G_SEARCHPATH_SEPARATOR_S, paths);
+    g_setenv ("GSETTINGS_SCHEMA_DIR", schema_path, TRUE);
+  }
+
+  g_setenv ("XDG_DATA_HOME", apps_dir, TRUE);
+  g_setenv ("XDG_DATA_DIRS", apps_dir, TRUE);
+}
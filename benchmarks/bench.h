@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PhoshBenchFunc:
+ * @n_iterations: How often to run the measured operation
+ * @user_data: The data passed to phosh_bench_add()
+ *
+ * Runs the operation under test @n_iterations times.
+ */
+typedef void (*PhoshBenchFunc) (guint64 n_iterations, gpointer user_data);
+
+void     phosh_bench_init          (int *argc, char ***argv);
+void     phosh_bench_add           (const char     *name,
+                                    PhoshBenchFunc  func,
+                                    gpointer        user_data);
+int      phosh_bench_run           (void);
+void     phosh_bench_keep          (gconstpointer   value);
+void     phosh_bench_create_apps   (guint           n_apps);
+
+G_END_DECLS
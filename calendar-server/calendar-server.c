@@ -32,6 +32,14 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 
 #define BUS_NAME PHOSH_APP_ID ".CalendarServer"
 
+/* Recurrence expansion happens in worker threads. Bound the work
+ * done per object so a pathological RRULE can't keep a worker busy
+ * forever and stream out results in batches. */
+#define EXPAND_MAX_THREADS      2
+#define EXPAND_MAX_INSTANCES    1000
+#define EXPAND_MAX_TIME_US      (G_USEC_PER_SEC / 2)
+#define EXPAND_BATCH_SIZE       50
+
 static const gchar introspection_xml[] =
   "<node>"
   "  <interface name='" PHOSH_APP_ID ".CalendarServer'>"
@@ -87,12 +95,6 @@ create_event_id (const gchar *source_uid,
     NULL);
 }
 
-typedef struct
-{
-  ECalClient *client;
-  GSList **pappointments; /* CalendarAppointment * */
-} CollectAppointmentsData;
-
 typedef struct
 {
   gchar  *id;
@@ -277,6 +279,198 @@ timet_from_ical_time (ICalTime     *time,
   return i_cal_time_as_timet_with_zone (time, timezone);
 }
 
+/* ---------------------------------------------------------------------------------------------------- */
+
+struct _App
+{
+  GDBusConnection *connection;
+
+  time_t since;
+  time_t until;
+
+  ICalTimezone *zone;
+
+  CalendarSources *sources;
+  gulong client_appeared_signal_id;
+  gulong client_disappeared_signal_id;
+
+  gchar *timezone_location;
+
+  GSList *notify_appointments; /* CalendarAppointment *, for EventsAdded */
+  GSList *notify_ids; /* gchar *, for EventsRemoved */
+
+  GSList *live_views;
+
+  GThreadPool  *expand_pool;
+  /* Object key to the GCancellable of its pending expansion. Cancelled when
+   * the object changes, goes away or the time range changes */
+  GHashTable   *expand_jobs;
+};
+
+static void app_notify_events_added (App *app);
+
+/* ---------------------------------------------------------------------------------------------------- */
+
+typedef struct
+{
+  App           *app;
+  char          *key;
+  ECalClient    *client;
+  ICalComponent *icomp;
+  time_t         since;
+  time_t         until;
+  GCancellable  *cancellable;
+
+  /* Only touched from the worker thread */
+  GSList        *batch; /* CalendarAppointment * */
+  guint          batch_len;
+  guint          n_instances;
+  gint64         deadline;
+  gboolean       truncated;
+} ExpandJob;
+
+typedef struct
+{
+  App          *app;
+  char         *key;
+  GCancellable *cancellable;
+  GSList       *appointments; /* CalendarAppointment * */
+  gboolean      last;
+} ExpandBatch;
+
+static char *
+expand_job_key (ECalClient *client, const char *uid)
+{
+  return create_event_id (e_source_get_uid (e_client_get_source (E_CLIENT (client))), uid, NULL);
+}
+
+/* Make sure results of an expansion of the given object never reach the bus */
+static void
+app_cancel_expansion (App *app, const char *key)
+{
+  GCancellable *cancellable = g_hash_table_lookup (app->expand_jobs, key);
+
+  if (cancellable == NULL)
+    return;
+
+  g_cancellable_cancel (cancellable);
+  g_hash_table_remove (app->expand_jobs, key);
+}
+
+/* Cancel the expansions of a calendar's objects or all of them if @source_uid is %NULL */
+static void
+app_cancel_expansions (App *app, const char *source_uid)
+{
+  g_autofree char *prefix = source_uid ? g_strconcat (source_uid, "\n", NULL) : NULL;
+  GHashTableIter iter;
+  GCancellable *cancellable;
+  const char *key;
+
+  g_hash_table_iter_init (&iter, app->expand_jobs);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&key, (gpointer *)&cancellable))
+    {
+      if (prefix && !g_str_has_prefix (key, prefix))
+        continue;
+
+      g_cancellable_cancel (cancellable);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
+static ExpandJob *
+expand_job_new (App           *app,
+                ECalClient    *client,
+                ICalComponent *icomp)
+{
+  ExpandJob *job = g_new0 (ExpandJob, 1);
+
+  job->app = app;
+  job->key = expand_job_key (client, i_cal_component_get_uid (icomp));
+  job->client = g_object_ref (client);
+  job->icomp = i_cal_component_clone (icomp);
+  job->since = app->since;
+  job->until = app->until;
+  job->cancellable = g_cancellable_new ();
+
+  /* A newer version of the object supersedes a pending expansion */
+  app_cancel_expansion (app, job->key);
+  g_hash_table_insert (app->expand_jobs, g_strdup (job->key), g_object_ref (job->cancellable));
+
+  return job;
+}
+
+static void
+expand_job_free (gpointer data)
+{
+  ExpandJob *job = data;
+
+  g_slist_free_full (job->batch, calendar_appointment_free);
+  g_free (job->key);
+  g_clear_object (&job->icomp);
+  g_clear_object (&job->client);
+  g_clear_object (&job->cancellable);
+  g_free (job);
+}
+
+static void
+expand_batch_free (gpointer data)
+{
+  ExpandBatch *batch = data;
+
+  g_slist_free_full (batch->appointments, calendar_appointment_free);
+  g_free (batch->key);
+  g_clear_object (&batch->cancellable);
+  g_free (batch);
+}
+
+static gboolean
+on_expand_batch_ready (gpointer data)
+{
+  ExpandBatch *batch = data;
+  App *app = batch->app;
+
+  /* Results for an outdated object or time range. This is checked on the
+   * main thread so nothing gets emitted after the object got removed. */
+  if (g_cancellable_is_cancelled (batch->cancellable))
+    return G_SOURCE_REMOVE;
+
+  if (batch->last)
+    g_hash_table_remove (app->expand_jobs, batch->key);
+
+  if (batch->appointments == NULL)
+    return G_SOURCE_REMOVE;
+
+  app->notify_appointments = g_slist_concat (g_steal_pointer (&batch->appointments),
+                                             app->notify_appointments);
+  app_notify_events_added (app);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Hand the instances collected so far over to the main thread */
+static void
+expand_job_flush (ExpandJob *job, gboolean last)
+{
+  ExpandBatch *batch;
+
+  if (job->batch == NULL && !last)
+    return;
+
+  batch = g_new0 (ExpandBatch, 1);
+  batch->app = job->app;
+  batch->key = g_strdup (job->key);
+  batch->cancellable = g_object_ref (job->cancellable);
+  batch->appointments = g_steal_pointer (&job->batch);
+  batch->last = last;
+  job->batch_len = 0;
+
+  g_main_context_invoke_full (NULL,
+                              G_PRIORITY_DEFAULT,
+                              on_expand_batch_ready,
+                              batch,
+                              expand_batch_free);
+}
+
 static gboolean
 generate_instances_cb (ICalComponent *icomp,
                        ICalTime *instance_start,
@@ -285,47 +479,69 @@ generate_instances_cb (ICalComponent *icomp,
                        GCancellable *cancellable,
                        GError **error)
 {
-  CollectAppointmentsData *data = user_data;
+  ExpandJob *job = user_data;
   CalendarAppointment *appointment;
   ECalComponent *comp;
   ICalTimezone *default_zone;
 
-  default_zone = e_cal_client_get_default_timezone (data->client);
+  if (g_cancellable_is_cancelled (cancellable))
+    return FALSE;
+
+  if (job->n_instances >= EXPAND_MAX_INSTANCES || g_get_monotonic_time () > job->deadline)
+    {
+      job->truncated = TRUE;
+      return FALSE;
+    }
+
+  default_zone = e_cal_client_get_default_timezone (job->client);
   comp = e_cal_component_new_from_icalcomponent (i_cal_component_clone (icomp));
 
-  appointment             = calendar_appointment_new (data->client, comp);
+  appointment             = calendar_appointment_new (job->client, comp);
   appointment->start_time = timet_from_ical_time (instance_start, default_zone);
   appointment->end_time   = timet_from_ical_time (instance_end, default_zone);
 
-  *(data->pappointments) = g_slist_prepend (*(data->pappointments), appointment);
+  job->batch = g_slist_prepend (job->batch, appointment);
+  job->batch_len++;
+  job->n_instances++;
 
   g_clear_object (&comp);
 
+  if (job->batch_len >= EXPAND_BATCH_SIZE)
+    expand_job_flush (job, FALSE);
+
   return TRUE;
 }
 
-/* ---------------------------------------------------------------------------------------------------- */
-
-struct _App
+static void
+expand_job_run (gpointer data, gpointer user_data)
 {
-  GDBusConnection *connection;
-
-  time_t since;
-  time_t until;
-
-  ICalTimezone *zone;
-
-  CalendarSources *sources;
-  gulong client_appeared_signal_id;
-  gulong client_disappeared_signal_id;
+  ExpandJob *job = data;
+
+  if (g_cancellable_is_cancelled (job->cancellable))
+    goto out;
+
+  job->deadline = g_get_monotonic_time () + EXPAND_MAX_TIME_US;
+  e_cal_client_generate_instances_for_object_sync (job->client,
+                                                   job->icomp,
+                                                   job->since,
+                                                   job->until,
+                                                   job->cancellable,
+                                                   generate_instances_cb,
+                                                   job);
+  if (job->truncated)
+    {
+      print_debug ("Expansion of '%s' stopped after %u instances",
+                   i_cal_component_get_uid (job->icomp), job->n_instances);
+    }
 
-  gchar *timezone_location;
+  if (!g_cancellable_is_cancelled (job->cancellable))
+    expand_job_flush (job, TRUE);
 
-  GSList *notify_appointments; /* CalendarAppointment *, for EventsAdded */
-  GSList *notify_ids; /* gchar *, for EventsRemoved */
+ out:
+  expand_job_free (job);
+}
 
-  GSList *live_views;
-};
+/* ---------------------------------------------------------------------------------------------------- */
 
 static void
 app_update_timezone (App *app)
@@ -462,17 +678,20 @@ app_process_added_modified_objects (App *app,
       if (!icomp || !i_cal_component_get_uid (icomp))
         continue;
 
+      if (!e_cal_util_component_is_instance (icomp))
+        {
+          g_autofree char *key = expand_job_key (cal_client, i_cal_component_get_uid (icomp));
+
+          /* The object changed so a pending expansion is outdated */
+          app_cancel_expansion (app, key);
+        }
+
       if (expand_recurrences &&
           !e_cal_util_component_is_instance (icomp) &&
           e_cal_util_component_has_recurrences (icomp))
         {
-          CollectAppointmentsData data;
-
-          data.client = cal_client;
-          data.pappointments = &app->notify_appointments;
-
-          e_cal_client_generate_instances_for_object_sync (cal_client, icomp, app->since, app->until, NULL,
-                                                           generate_instances_cb, &data);
+          /* Expanding recurrences can take a long time so do it off the main thread */
+          g_thread_pool_push (app->expand_pool, expand_job_new (app, cal_client, icomp), NULL);
         }
       else
         {
@@ -544,6 +763,14 @@ on_objects_removed (ECalClientView *view,
       if (!id)
         continue;
 
+      /* Removing the whole object (rather than a detached instance) */
+      if (!e_cal_component_id_get_rid (id) || !*e_cal_component_id_get_rid (id))
+        {
+          g_autofree char *key = create_event_id (source_uid, e_cal_component_id_get_uid (id), NULL);
+
+          app_cancel_expansion (app, key);
+        }
+
       app->notify_ids = g_slist_prepend (app->notify_ids,
                                          create_event_id (source_uid,
                                          e_cal_component_id_get_uid (id),
@@ -668,6 +895,9 @@ app_update_views (App *app)
 
   had_views = app->live_views != NULL;
 
+  /* Drop pending and in flight expansions for the old time range */
+  app_cancel_expansions (app, NULL);
+
   for (link = app->live_views; link; link = g_slist_next (link))
     {
       app_stop_view (app, link->data);
@@ -725,6 +955,7 @@ on_client_appeared_cb (CalendarSources *sources,
       if (g_strcmp0 (source_uid, e_source_get_uid (source)) == 0)
         {
           g_clear_object (&cal_client);
+          app_cancel_expansions (app, source_uid);
           return;
         }
 
@@ -765,6 +996,7 @@ on_client_disappeared_cb (CalendarSources *sources,
       if (g_strcmp0 (source_uid, e_source_get_uid (source)) == 0)
         {
           g_clear_object (&cal_client);
+          app_cancel_expansions (app, source_uid);
           app_stop_view (app, view);
           app->live_views = g_slist_remove (app->live_views, view);
           g_object_unref (view);
@@ -807,6 +1039,14 @@ app_new (GDBusConnection *connection)
                                                         G_CALLBACK (on_client_disappeared_cb),
                                                         app);
 
+  app->expand_jobs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  app->expand_pool = g_thread_pool_new_full (expand_job_run,
+                                             app,
+                                             expand_job_free,
+                                             EXPAND_MAX_THREADS,
+                                             FALSE,
+                                             NULL);
+
   app_update_timezone (app);
 
   return app;
@@ -817,6 +1057,10 @@ app_free (App *app)
 {
   GSList *ll;
 
+  app_cancel_expansions (app, NULL);
+  g_thread_pool_free (app->expand_pool, TRUE, TRUE);
+  g_clear_pointer (&app->expand_jobs, g_hash_table_unref);
+
   for (ll = app->live_views; ll != NULL; ll = g_slist_next (ll))
     {
       ECalClientView *view = E_CAL_CLIENT_VIEW (ll->data);
@@ -15,12 +15,24 @@
 
 #define TICKET_BOX_SCHEMA_ID "sm.puri.phosh.plugins.ticket-box"
 #define TICKET_BOX_FOLDER_KEY "folder"
+#define TICKET_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME ","             \
+                          G_FILE_ATTRIBUTE_STANDARD_SYMBOLIC_ICON ","    \
+                          G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","     \
+                          G_FILE_ATTRIBUTE_TIME_MODIFIED ","             \
+                          G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE
+#define N_FILES_PER_BATCH 32
+#define MAX_LOADED_DOCUMENTS 2
 
 /**
  * PhoshTicketBox
  *
  * Show tickets in a folder. For now we do PDF but
  * should add PNG and pass.
+ *
+ * The folder is listed once and then kept up to date via a file
+ * monitor. The most recent ticket is preloaded so it shows up
+ * right away. Only the documents of the last few shown tickets
+ * are kept in memory.
  */
 struct _PhoshTicketBox {
   GtkBox        parent;
@@ -31,6 +43,10 @@ struct _PhoshTicketBox {
   GCancellable *cancel;
 
   GListStore   *model;
+  /* File path to PhoshTicket */
+  GHashTable   *tickets;
+  /* Tickets with a loaded document, most recently used first */
+  GQueue        loaded_tickets;
   GtkListBox   *lb_tickets;
   GtkStack     *stack_tickets;
 
@@ -41,15 +57,66 @@ G_DEFINE_TYPE (PhoshTicketBox, phosh_ticket_box, GTK_TYPE_BOX);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC (EvDocument, g_object_unref)
 
+static void
+track_loaded_ticket (PhoshTicketBox *self, PhoshTicket *ticket)
+{
+  GList *link = g_queue_find (&self->loaded_tickets, ticket);
+
+  if (link) {
+    g_queue_unlink (&self->loaded_tickets, link);
+    g_queue_push_head_link (&self->loaded_tickets, link);
+    return;
+  }
+
+  g_queue_push_head (&self->loaded_tickets, g_object_ref (ticket));
+  while (g_queue_get_length (&self->loaded_tickets) > MAX_LOADED_DOCUMENTS) {
+    g_autoptr (PhoshTicket) oldest = g_queue_pop_tail (&self->loaded_tickets);
+
+    /* A shown document is kept alive by the view's model */
+    phosh_ticket_drop_document (oldest);
+  }
+}
+
+
+static void
+show_document (PhoshTicketBox *self, EvDocument *doc)
+{
+  g_autoptr (EvDocumentModel) model = NULL;
+
+  model = ev_document_model_new_with_document (doc);
+  /* Render at the final size right away */
+  ev_document_model_set_sizing_mode (model, EV_SIZING_FIT_WIDTH);
+  ev_view_set_model (self->view, model);
+
+  gtk_stack_set_visible_child_name (self->stack_tickets, "ticket-view");
+}
+
+
+static void
+on_document_loaded (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshTicket *ticket = PHOSH_TICKET (source_object);
+  g_autoptr (GError) err = NULL;
+  g_autoptr (EvDocument) doc = NULL;
+
+  doc = phosh_ticket_load_document_finish (ticket, res, &err);
+  if (doc == NULL) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("Failed to load %s: %s", phosh_ticket_get_display_name (ticket), err->message);
+    return;
+  }
+
+  track_loaded_ticket (PHOSH_TICKET_BOX (user_data), ticket);
+  show_document (PHOSH_TICKET_BOX (user_data), doc);
+}
+
+
 static void
 on_row_selected (PhoshTicketBox *self,
                  GtkListBoxRow  *row,
                  GtkListBox     *box)
 {
-  g_autoptr (GError) err = NULL;
   g_autoptr (PhoshTicket) ticket = NULL;
-  g_autoptr (EvDocument) doc = NULL;
-  g_autoptr (EvDocumentModel) model = NULL;
 
   if (row == NULL)
     return;
@@ -57,18 +124,11 @@ on_row_selected (PhoshTicketBox *self,
   g_object_get (row, "ticket", &ticket, NULL);
   g_debug ("row selected: %s", phosh_ticket_get_display_name (ticket));
 
-  doc = ev_document_factory_get_document_for_gfile (phosh_ticket_get_file (ticket),
-                                                    EV_DOCUMENT_LOAD_FLAG_NONE,
-                                                    self->cancel,
-                                                    &err);
-  if (doc == NULL) {
-    g_warning ("Failed to load %s: %s", phosh_ticket_get_display_name (ticket), err->message);
-    return;
-  }
-  model = ev_document_model_new_with_document (doc);
-  ev_view_set_model (self->view, model);
-
-  gtk_stack_set_visible_child_name (self->stack_tickets, "ticket-view");
+  if (phosh_ticket_get_document (ticket)) {
+    track_loaded_ticket (self, ticket);
+    show_document (self, phosh_ticket_get_document (ticket));
+  } else
+    phosh_ticket_load_document_async (ticket, self->cancel, on_document_loaded, self);
 
   gtk_list_box_select_row (box, NULL);
 }
@@ -82,13 +142,25 @@ on_view_close_clicked (PhoshTicketBox *self)
 
 
 static void
-phosh_ticket_box_finalize (GObject *object)
+phosh_ticket_box_dispose (GObject *object)
 {
   PhoshTicketBox *self = PHOSH_TICKET_BOX (object);
 
   g_cancellable_cancel (self->cancel);
   g_clear_object (&self->cancel);
+  g_queue_clear_full (&self->loaded_tickets, g_object_unref);
+
+  G_OBJECT_CLASS (phosh_ticket_box_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_ticket_box_finalize (GObject *object)
+{
+  PhoshTicketBox *self = PHOSH_TICKET_BOX (object);
+
   g_clear_object (&self->model);
+  g_clear_pointer (&self->tickets, g_hash_table_unref);
 
   g_clear_object (&self->monitor);
   g_clear_object (&self->dir);
@@ -104,6 +176,7 @@ phosh_ticket_box_class_init (PhoshTicketBoxClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
+  object_class->dispose = phosh_ticket_box_dispose;
   object_class->finalize = phosh_ticket_box_finalize;
 
   g_type_ensure (EV_TYPE_VIEW);
@@ -141,46 +214,209 @@ ticket_compare (gconstpointer a, gconstpointer b, gpointer user_data)
 
 
 static void
-on_file_child_enumerated (GObject *source_object, GAsyncResult *res, gpointer user_data)
+update_stack (PhoshTicketBox *self)
+{
+  const char *stack_child = "tickets";
+
+  if (g_strcmp0 (gtk_stack_get_visible_child_name (self->stack_tickets), "ticket-view") == 0)
+    return;
+
+  if (g_list_model_get_n_items (G_LIST_MODEL (self->model)) == 0)
+    stack_child = "no-tickets";
+
+  gtk_stack_set_visible_child_name (self->stack_tickets, stack_child);
+}
+
+
+static void
+remove_ticket (PhoshTicketBox *self, GFile *file)
+{
+  g_autofree char *path = g_file_get_path (file);
+  PhoshTicket *ticket;
+  guint pos;
+
+  ticket = g_hash_table_lookup (self->tickets, path);
+  if (ticket == NULL)
+    return;
+
+  if (g_list_store_find (self->model, ticket, &pos))
+    g_list_store_remove (self->model, pos);
+  g_hash_table_remove (self->tickets, path);
+}
+
+
+static void
+add_ticket (PhoshTicketBox *self, GFile *file, GFileInfo *info)
 {
+  g_autoptr (PhoshTicket) ticket = NULL;
+
+  if (g_strcmp0 (g_file_info_get_content_type (info), "application/pdf") != 0)
+    return;
+
+  /* Changed tickets get replaced so thumbnails get refreshed */
+  remove_ticket (self, file);
+
+  ticket = phosh_ticket_new (file, info);
+  g_hash_table_insert (self->tickets, g_file_get_path (file), g_object_ref (ticket));
+  g_list_store_insert_sorted (self->model, ticket, ticket_compare, NULL);
+}
+
+
+static void
+on_document_preloaded (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshTicket *ticket = PHOSH_TICKET (source_object);
   g_autoptr (GError) err = NULL;
-  GFile *dir = G_FILE (source_object);
-  GFileEnumerator *enumerator;
+  g_autoptr (EvDocument) doc = NULL;
+
+  /* The ticket keeps the document around */
+  doc = phosh_ticket_load_document_finish (ticket, res, &err);
+  if (doc == NULL) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_debug ("Failed to preload %s: %s", phosh_ticket_get_display_name (ticket), err->message);
+    return;
+  }
+
+  track_loaded_ticket (PHOSH_TICKET_BOX (user_data), ticket);
+}
+
+
+static void
+preload_newest_ticket (PhoshTicketBox *self)
+{
+  g_autoptr (PhoshTicket) ticket = g_list_model_get_item (G_LIST_MODEL (self->model), 0);
+
+  if (ticket == NULL)
+    return;
+
+  phosh_ticket_load_document_async (ticket, self->cancel, on_document_preloaded, self);
+}
+
+
+static void
+on_file_info_queried (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GFileInfo) info = NULL;
+  GFile *file = G_FILE (source_object);
   PhoshTicketBox *self;
-  const char *stack_child = "tickets";
 
-  enumerator = g_file_enumerate_children_finish (dir, res, &err);
-  if (enumerator == NULL) {
-    g_warning ("Failed to list %s", g_file_get_basename (dir));
+  info = g_file_query_info_finish (file, res, &err);
+  if (info == NULL) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_debug ("Failed to query ticket info: %s", err->message);
     return;
   }
 
   self = PHOSH_TICKET_BOX (user_data);
+  add_ticket (self, file, info);
+  update_stack (self);
+}
 
-  while (TRUE) {
-    GFile *file;
-    GFileInfo *info;
-    g_autoptr (PhoshTicket) ticket = NULL;
 
-    if (!g_file_enumerator_iterate (enumerator, &info, &file, self->cancel, &err)) {
-      g_warning ("Failed to list contents of ticket dir %s: $%s", self->ticket_box_path, err->message);
-      return;
-    }
+static void
+on_dir_changed (PhoshTicketBox    *self,
+                GFile             *file,
+                GFile             *other_file,
+                GFileMonitorEvent  event,
+                GFileMonitor      *monitor)
+{
+  switch (event) {
+  case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+  case G_FILE_MONITOR_EVENT_MOVED_IN:
+    g_file_query_info_async (file,
+                             TICKET_ATTRIBUTES,
+                             G_FILE_QUERY_INFO_NONE,
+                             G_PRIORITY_LOW,
+                             self->cancel,
+                             on_file_info_queried,
+                             self);
+    break;
+  case G_FILE_MONITOR_EVENT_RENAMED:
+    remove_ticket (self, file);
+    g_file_query_info_async (other_file,
+                             TICKET_ATTRIBUTES,
+                             G_FILE_QUERY_INFO_NONE,
+                             G_PRIORITY_LOW,
+                             self->cancel,
+                             on_file_info_queried,
+                             self);
+    break;
+  case G_FILE_MONITOR_EVENT_DELETED:
+  case G_FILE_MONITOR_EVENT_MOVED_OUT:
+    remove_ticket (self, file);
+    update_stack (self);
+    break;
+  default:
+    break;
+  }
+}
 
-    if (!file)
-      break;
 
-    if (g_strcmp0 (g_file_info_get_content_type (info), "application/pdf") != 0)
-      continue;
+static void
+on_next_files (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GError) err = NULL;
+  GFileEnumerator *enumerator = G_FILE_ENUMERATOR (source_object);
+  PhoshTicketBox *self;
+  GList *infos;
 
-    ticket = phosh_ticket_new (file, info);
-    g_list_store_insert_sorted (self->model, ticket, ticket_compare, NULL);
+  infos = g_file_enumerator_next_files_finish (enumerator, res, &err);
+  if (err) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("Failed to list contents of ticket dir: %s", err->message);
+    return;
   }
 
-  if (g_list_model_get_n_items (G_LIST_MODEL (self->model)) == 0)
-    stack_child = "no-tickets";
+  self = PHOSH_TICKET_BOX (user_data);
 
-  gtk_stack_set_visible_child_name (self->stack_tickets, stack_child);
+  for (GList *l = infos; l; l = l->next) {
+    GFileInfo *info = G_FILE_INFO (l->data);
+    g_autoptr (GFile) file = g_file_enumerator_get_child (enumerator, info);
+
+    add_ticket (self, file, info);
+  }
+
+  if (infos) {
+    g_list_free_full (infos, g_object_unref);
+    /* List the directory in batches to not block the main loop */
+    g_file_enumerator_next_files_async (enumerator,
+                                        N_FILES_PER_BATCH,
+                                        G_PRIORITY_LOW,
+                                        self->cancel,
+                                        on_next_files,
+                                        self);
+    return;
+  }
+
+  update_stack (self);
+  preload_newest_ticket (self);
+  phosh_ticket_prune_thumbnails (G_LIST_MODEL (self->model));
+}
+
+
+static void
+on_file_child_enumerated (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GFileEnumerator) enumerator = NULL;
+  GFile *dir = G_FILE (source_object);
+  PhoshTicketBox *self;
+
+  enumerator = g_file_enumerate_children_finish (dir, res, &err);
+  if (enumerator == NULL) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("Failed to list %s: %s", g_file_peek_path (dir), err->message);
+    return;
+  }
+
+  self = PHOSH_TICKET_BOX (user_data);
+  g_file_enumerator_next_files_async (enumerator,
+                                      N_FILES_PER_BATCH,
+                                      G_PRIORITY_LOW,
+                                      self->cancel,
+                                      on_next_files,
+                                      self);
 }
 
 
@@ -188,6 +424,7 @@ static void
 load_tickets (PhoshTicketBox *self)
 {
   g_autoptr (GSettings) settings = g_settings_new (TICKET_BOX_SCHEMA_ID);
+  g_autoptr (GError) err = NULL;
   g_autofree char *folder = NULL;
 
   folder = g_settings_get_string (settings, TICKET_BOX_FOLDER_KEY);
@@ -198,16 +435,20 @@ load_tickets (PhoshTicketBox *self)
 
   self->dir = g_file_new_for_path (self->ticket_box_path);
 
-  /*
-   * Since the lockscreen is rebuilt on lock we don't worry about changes in directory contesnt,
-   *  should we do, we can add a GFileMonitor later on
-   */
+  /* Set up the monitor first so we don't miss any changes while listing */
+  self->monitor = g_file_monitor_directory (self->dir, G_FILE_MONITOR_WATCH_MOVES, self->cancel, &err);
+  if (self->monitor) {
+    g_signal_connect_object (self->monitor,
+                             "changed",
+                             G_CALLBACK (on_dir_changed),
+                             self,
+                             G_CONNECT_SWAPPED);
+  } else {
+    g_warning ("Failed to monitor %s: %s", self->ticket_box_path, err->message);
+  }
+
   g_file_enumerate_children_async (self->dir,
-                                   G_FILE_ATTRIBUTE_STANDARD_NAME ","
-                                   G_FILE_ATTRIBUTE_STANDARD_SYMBOLIC_ICON ","
-                                   G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME ","
-                                   G_FILE_ATTRIBUTE_TIME_MODIFIED ","
-                                   G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
+                                   TICKET_ATTRIBUTES,
                                    G_FILE_QUERY_INFO_NONE,
                                    G_PRIORITY_LOW,
                                    self->cancel,
@@ -225,7 +466,9 @@ phosh_ticket_box_init (PhoshTicketBox *self)
 
   gtk_widget_init_template (GTK_WIDGET (self));
 
+  self->cancel = g_cancellable_new ();
   self->model = g_list_store_new (PHOSH_TYPE_TICKET);
+  self->tickets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
 
   css_provider = gtk_css_provider_new ();
   gtk_css_provider_load_from_resource (css_provider,
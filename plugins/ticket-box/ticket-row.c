@@ -13,6 +13,8 @@
 #include <glib/gi18n.h>
 #include <handy.h>
 
+#define THUMBNAIL_SIZE 48
+
 enum {
   PROP_0,
   PROP_TICKET,
@@ -25,10 +27,31 @@ struct _PhoshTicketRow {
   HdyActionRow parent;
 
   PhoshTicket *ticket;
+  GtkWidget   *thumbnail;
 };
 G_DEFINE_TYPE (PhoshTicketRow, phosh_ticket_row, HDY_TYPE_ACTION_ROW)
 
 
+static void
+on_thumbnail_changed (PhoshTicketRow *self)
+{
+  GdkPixbuf *pixbuf = phosh_ticket_get_thumbnail (self->ticket);
+  cairo_surface_t *surface;
+  int scale;
+
+  if (pixbuf == NULL)
+    return;
+
+  scale = gtk_widget_get_scale_factor (GTK_WIDGET (self));
+  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, NULL);
+  gtk_image_set_from_surface (GTK_IMAGE (self->thumbnail), surface);
+  cairo_surface_destroy (surface);
+
+  hdy_action_row_set_icon_name (HDY_ACTION_ROW (self), NULL);
+  gtk_widget_show (self->thumbnail);
+}
+
+
 static void
 phosh_ticket_row_set_property (GObject      *object,
                                guint         property_id,
@@ -44,6 +67,12 @@ phosh_ticket_row_set_property (GObject      *object,
                                    phosh_ticket_get_display_name (self->ticket));
 /* TODO: by document type */
     hdy_action_row_set_icon_name (HDY_ACTION_ROW (self), "x-office-document-symbolic");
+    g_signal_connect_object (self->ticket,
+                             "notify::thumbnail",
+                             G_CALLBACK (on_thumbnail_changed),
+                             self,
+                             G_CONNECT_SWAPPED);
+    on_thumbnail_changed (self);
     break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -71,6 +100,18 @@ phosh_ticket_row_get_property (GObject    *object,
 }
 
 
+static void
+phosh_ticket_row_map (GtkWidget *widget)
+{
+  PhoshTicketRow *self = PHOSH_TICKET_ROW (widget);
+
+  GTK_WIDGET_CLASS (phosh_ticket_row_parent_class)->map (widget);
+
+  /* Only now we know the scale */
+  phosh_ticket_ensure_thumbnail (self->ticket, THUMBNAIL_SIZE * gtk_widget_get_scale_factor (widget));
+}
+
+
 static void
 phosh_ticket_row_finalize (GObject *object)
 {
@@ -92,6 +133,8 @@ phosh_ticket_row_class_init (PhoshTicketRowClass *klass)
   object_class->set_property = phosh_ticket_row_set_property;
   object_class->finalize = phosh_ticket_row_finalize;
 
+  widget_class->map = phosh_ticket_row_map;
+
   props[PROP_TICKET] =
     g_param_spec_object ("ticket", "", "",
                          PHOSH_TYPE_TICKET,
@@ -106,6 +149,8 @@ phosh_ticket_row_class_init (PhoshTicketRowClass *klass)
 static void
 phosh_ticket_row_init (PhoshTicketRow *self)
 {
+  self->thumbnail = gtk_image_new ();
+  hdy_action_row_add_prefix (HDY_ACTION_ROW (self), self->thumbnail);
 }
 
 
@@ -8,22 +8,69 @@
 
 #include "ticket.h"
 
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+/**
+ * PhoshTicket:
+ *
+ * A ticket in the ticket box
+ *
+ * Thumbnails of the first page are rendered in a worker thread and
+ * cached on disk keyed by the file's URI and modification time. The
+ * document itself can be preloaded so it can be shown right away.
+ *
+ * Thumbnails are rendered one at a time so that they don't contend
+ * on the document mutex with the ticket that is currently shown.
+ */
+
 enum {
   PROP_0,
   PROP_FILE,
   PROP_INFO,
+  PROP_THUMBNAIL,
   PROP_LAST_PROP
 };
 static GParamSpec *props[PROP_LAST_PROP];
 
 struct _PhoshTicket {
-  GObject    parent;
+  GObject       parent;
+
+  GFile        *file;
+  GFileInfo    *info;
 
-  GFile     *file;
-  GFileInfo *info;
+  GdkPixbuf    *thumbnail;
+  int           thumbnail_size;
+  EvDocument   *document;
+  GCancellable *cancel;
 };
 G_DEFINE_TYPE (PhoshTicket, phosh_ticket, G_TYPE_OBJECT)
 
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (EvDocument, g_object_unref)
+
+typedef struct {
+  GFile *file;
+  char  *cache_path;
+  int    size;
+} ThumbnailData;
+
+/* Tickets waiting for their thumbnail. Not referenced, tickets remove
+ * themselves on dispose */
+static GQueue   thumbnail_queue = G_QUEUE_INIT;
+static gboolean thumbnail_busy;
+
+static void run_next_thumbnail (void);
+
+
+static void
+thumbnail_data_free (ThumbnailData *data)
+{
+  g_clear_object (&data->file);
+  g_free (data->cache_path);
+  g_free (data);
+}
+
 
 static void
 phosh_ticket_set_property (GObject      *object,
@@ -62,6 +109,9 @@ phosh_ticket_get_property (GObject    *object,
   case PROP_INFO:
     g_value_set_object (value, self->info);
     break;
+  case PROP_THUMBNAIL:
+    g_value_set_object (value, self->thumbnail);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     break;
@@ -69,6 +119,218 @@ phosh_ticket_get_property (GObject    *object,
 }
 
 
+static char *
+get_cache_dir (void)
+{
+  return g_build_filename (g_get_user_cache_dir (), "phosh", "ticket-box", NULL);
+}
+
+
+/* Identifies the ticket's content, thumbnails of all sizes share it */
+static char *
+get_cache_key (PhoshTicket *self)
+{
+  g_autofree char *uri = g_file_get_uri (self->file);
+  g_autofree char *hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, uri, -1);
+  guint64 mtime;
+
+  mtime = g_file_info_get_attribute_uint64 (self->info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+  return g_strdup_printf ("%s-%" G_GUINT64_FORMAT, hash, mtime);
+}
+
+
+static char *
+get_cache_path (PhoshTicket *self, int size)
+{
+  g_autofree char *dir = get_cache_dir ();
+  g_autofree char *key = get_cache_key (self);
+  g_autofree char *filename = g_strdup_printf ("%s-%d.png", key, size);
+
+  return g_build_filename (dir, filename, NULL);
+}
+
+
+static GdkPixbuf *
+render_thumbnail (GFile *file, int size, GCancellable *cancel, GError **err)
+{
+  g_autoptr (EvDocument) doc = NULL;
+  EvPage *page;
+  EvRenderContext *rc;
+  GdkPixbuf *pixbuf;
+  double width, height;
+
+  ev_document_fc_mutex_lock ();
+  doc = ev_document_factory_get_document_for_gfile (file, EV_DOCUMENT_LOAD_FLAG_NONE, cancel, err);
+  ev_document_fc_mutex_unlock ();
+  if (doc == NULL)
+    return NULL;
+
+  ev_document_doc_mutex_lock ();
+  page = ev_document_get_page (doc, 0);
+  ev_document_get_page_size (doc, 0, &width, &height);
+  rc = ev_render_context_new (page, 0, size / MAX (width, height));
+  pixbuf = ev_document_get_thumbnail (doc, rc);
+  ev_document_doc_mutex_unlock ();
+
+  g_object_unref (rc);
+  g_object_unref (page);
+
+  if (pixbuf == NULL)
+    g_set_error (err, G_IO_ERROR, G_IO_ERROR_FAILED, "Failed to render thumbnail");
+
+  return pixbuf;
+}
+
+
+static void
+thumbnail_thread (GTask        *task,
+                  gpointer      source_object,
+                  gpointer      task_data,
+                  GCancellable *cancel)
+{
+  ThumbnailData *data = task_data;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+  g_autofree char *dir = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  if (g_file_test (data->cache_path, G_FILE_TEST_EXISTS)) {
+    pixbuf = gdk_pixbuf_new_from_file (data->cache_path, NULL);
+    if (pixbuf) {
+      g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+      return;
+    }
+  }
+
+  pixbuf = render_thumbnail (data->file, data->size, cancel, &err);
+  if (pixbuf == NULL) {
+    g_task_return_error (task, g_steal_pointer (&err));
+    return;
+  }
+
+  dir = g_path_get_dirname (data->cache_path);
+  if (g_mkdir_with_parents (dir, 0700) == 0) {
+    if (!gdk_pixbuf_save (pixbuf, data->cache_path, "png", &err, NULL))
+      g_debug ("Failed to cache thumbnail at %s: %s", data->cache_path, err->message);
+  }
+
+  g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+}
+
+
+static void
+on_thumbnail_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshTicket *self = PHOSH_TICKET (source_object);
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+
+  thumbnail_busy = FALSE;
+  run_next_thumbnail ();
+
+  pixbuf = g_task_propagate_pointer (G_TASK (res), &err);
+  if (pixbuf == NULL) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("Failed to get thumbnail for %s: %s",
+                 phosh_ticket_get_display_name (self), err->message);
+    return;
+  }
+
+  if (g_set_object (&self->thumbnail, pixbuf))
+    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_THUMBNAIL]);
+}
+
+
+static void
+run_next_thumbnail (void)
+{
+  g_autoptr (GTask) task = NULL;
+  PhoshTicket *self;
+  ThumbnailData *data;
+
+  if (thumbnail_busy)
+    return;
+
+  self = g_queue_pop_head (&thumbnail_queue);
+  if (self == NULL)
+    return;
+
+  data = g_new0 (ThumbnailData, 1);
+  data->file = g_object_ref (self->file);
+  data->cache_path = get_cache_path (self, self->thumbnail_size);
+  data->size = self->thumbnail_size;
+
+  task = g_task_new (self, self->cancel, on_thumbnail_ready, NULL);
+  g_task_set_task_data (task, data, (GDestroyNotify) thumbnail_data_free);
+  g_task_set_priority (task, G_PRIORITY_LOW);
+  thumbnail_busy = TRUE;
+  g_task_run_in_thread (task, thumbnail_thread);
+}
+
+
+static void
+prune_thread (GTask        *task,
+              gpointer      source_object,
+              gpointer      task_data,
+              GCancellable *cancel)
+{
+  GHashTable *keep = task_data;
+  g_autofree char *cache_dir = get_cache_dir ();
+  g_autoptr (GDir) dir = NULL;
+  const char *name;
+
+  dir = g_dir_open (cache_dir, 0, NULL);
+  if (dir == NULL) {
+    g_task_return_boolean (task, TRUE);
+    return;
+  }
+
+  while ((name = g_dir_read_name (dir))) {
+    g_autofree char *key = g_strdup (name);
+    g_autofree char *path = NULL;
+    char *sep = strrchr (key, '-');
+
+    /* Strip the size suffix to get the key */
+    if (sep)
+      *sep = '\0';
+
+    if (g_hash_table_contains (keep, key))
+      continue;
+
+    path = g_build_filename (cache_dir, name, NULL);
+    if (g_unlink (path) != 0)
+      g_debug ("Failed to remove stale thumbnail %s", path);
+  }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+static void
+document_thread (GTask        *task,
+                 gpointer      source_object,
+                 gpointer      task_data,
+                 GCancellable *cancel)
+{
+  GFile *file = G_FILE (task_data);
+  g_autoptr (EvDocument) doc = NULL;
+  GError *err = NULL;
+
+  ev_document_fc_mutex_lock ();
+  doc = ev_document_factory_get_document_for_gfile (file, EV_DOCUMENT_LOAD_FLAG_NONE, cancel, &err);
+  ev_document_fc_mutex_unlock ();
+  if (doc == NULL) {
+    g_task_return_error (task, err);
+    return;
+  }
+
+  g_task_return_pointer (task, g_steal_pointer (&doc), g_object_unref);
+}
+
+
 static void
 phosh_ticket_finalize (GObject *object)
 {
@@ -76,11 +338,26 @@ phosh_ticket_finalize (GObject *object)
 
   g_clear_object (&self->file);
   g_clear_object (&self->info);
+  g_clear_object (&self->thumbnail);
+  g_clear_object (&self->document);
 
   G_OBJECT_CLASS (phosh_ticket_parent_class)->finalize (object);
 }
 
 
+static void
+phosh_ticket_dispose (GObject *object)
+{
+  PhoshTicket *self = PHOSH_TICKET (object);
+
+  g_queue_remove (&thumbnail_queue, self);
+  g_cancellable_cancel (self->cancel);
+  g_clear_object (&self->cancel);
+
+  G_OBJECT_CLASS (phosh_ticket_parent_class)->dispose (object);
+}
+
+
 static void
 phosh_ticket_class_init (PhoshTicketClass *klass)
 {
@@ -88,6 +365,7 @@ phosh_ticket_class_init (PhoshTicketClass *klass)
 
   object_class->get_property = phosh_ticket_get_property;
   object_class->set_property = phosh_ticket_set_property;
+  object_class->dispose = phosh_ticket_dispose;
   object_class->finalize = phosh_ticket_finalize;
 
   props[PROP_FILE] =
@@ -100,6 +378,11 @@ phosh_ticket_class_init (PhoshTicketClass *klass)
                          G_TYPE_FILE_INFO,
                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
 
+  props[PROP_THUMBNAIL] =
+    g_param_spec_object ("thumbnail", "", "",
+                         GDK_TYPE_PIXBUF,
+                         G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
   g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
 }
 
@@ -107,6 +390,7 @@ phosh_ticket_class_init (PhoshTicketClass *klass)
 static void
 phosh_ticket_init (PhoshTicket *self)
 {
+  self->cancel = g_cancellable_new ();
 }
 
 
@@ -153,3 +437,147 @@ phosh_ticket_get_mod_time (PhoshTicket *self)
 
   return g_file_info_get_modification_date_time (self->info);
 }
+
+
+GdkPixbuf *
+phosh_ticket_get_thumbnail (PhoshTicket *self)
+{
+  g_return_val_if_fail (PHOSH_IS_TICKET (self), NULL);
+
+  return self->thumbnail;
+}
+
+/**
+ * phosh_ticket_ensure_thumbnail:
+ * @self: The ticket
+ * @size: The thumbnail size in pixels
+ *
+ * Render a thumbnail of the first page or load it from the cache. Once
+ * done `PhoshTicket:thumbnail` is updated.
+ */
+void
+phosh_ticket_ensure_thumbnail (PhoshTicket *self, int size)
+{
+  g_return_if_fail (PHOSH_IS_TICKET (self));
+
+  if (self->thumbnail_size == size)
+    return;
+  self->thumbnail_size = size;
+
+  /* Queued already, the size is picked up once it's its turn */
+  if (g_queue_find (&thumbnail_queue, self) == NULL)
+    g_queue_push_tail (&thumbnail_queue, self);
+
+  run_next_thumbnail ();
+}
+
+/**
+ * phosh_ticket_prune_thumbnails:
+ * @tickets: The current tickets
+ *
+ * Remove cached thumbnails that don't belong to any of the given
+ * tickets, e.g. of deleted or modified tickets.
+ */
+void
+phosh_ticket_prune_thumbnails (GListModel *tickets)
+{
+  g_autoptr (GTask) task = NULL;
+  GHashTable *keep;
+
+  g_return_if_fail (G_IS_LIST_MODEL (tickets));
+
+  keep = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (guint i = 0; i < g_list_model_get_n_items (tickets); i++) {
+    g_autoptr (PhoshTicket) ticket = g_list_model_get_item (tickets, i);
+
+    g_hash_table_add (keep, get_cache_key (ticket));
+  }
+
+  task = g_task_new (NULL, NULL, NULL, NULL);
+  g_task_set_task_data (task, keep, (GDestroyNotify) g_hash_table_unref);
+  g_task_set_priority (task, G_PRIORITY_LOW);
+  g_task_run_in_thread (task, prune_thread);
+}
+
+/**
+ * phosh_ticket_get_document:
+ * @self: The ticket
+ *
+ * Get the document if it was loaded already.
+ *
+ * Returns:(transfer none)(nullable): The document
+ */
+EvDocument *
+phosh_ticket_get_document (PhoshTicket *self)
+{
+  g_return_val_if_fail (PHOSH_IS_TICKET (self), NULL);
+
+  return self->document;
+}
+
+
+void
+phosh_ticket_load_document_async (PhoshTicket         *self,
+                                  GCancellable        *cancel,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+
+  g_return_if_fail (PHOSH_IS_TICKET (self));
+
+  task = g_task_new (self, cancel, callback, user_data);
+  g_task_set_source_tag (task, phosh_ticket_load_document_async);
+
+  if (self->document) {
+    g_task_return_pointer (task, g_object_ref (self->document), g_object_unref);
+    return;
+  }
+
+  g_task_set_task_data (task, g_object_ref (self->file), g_object_unref);
+  g_task_run_in_thread (task, document_thread);
+}
+
+/**
+ * phosh_ticket_load_document_finish:
+ * @self: The ticket
+ * @res: The result
+ * @err: The error location
+ *
+ * Finish loading the document. The document is kept so further
+ * loads complete right away until [method@Ticket.drop_document]
+ * is invoked.
+ *
+ * Returns:(transfer full): The document
+ */
+EvDocument *
+phosh_ticket_load_document_finish (PhoshTicket   *self,
+                                   GAsyncResult  *res,
+                                   GError       **err)
+{
+  EvDocument *doc;
+
+  g_return_val_if_fail (PHOSH_IS_TICKET (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  doc = g_task_propagate_pointer (G_TASK (res), err);
+  if (doc)
+    g_set_object (&self->document, doc);
+
+  return doc;
+}
+
+/**
+ * phosh_ticket_drop_document:
+ * @self: The ticket
+ *
+ * Drop the loaded document to free its memory. It's loaded again
+ * on the next [method@Ticket.load_document_async].
+ */
+void
+phosh_ticket_drop_document (PhoshTicket *self)
+{
+  g_return_if_fail (PHOSH_IS_TICKET (self));
+
+  g_clear_object (&self->document);
+}
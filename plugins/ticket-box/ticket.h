@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <evince-document.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gio/gio.h>
 
 G_BEGIN_DECLS
@@ -19,5 +21,17 @@ GFile             *phosh_ticket_get_file (PhoshTicket *self);
 const char        *phosh_ticket_get_display_name (PhoshTicket *self);
 GIcon             *phosh_ticket_get_icon (PhoshTicket *self);
 GDateTime         *phosh_ticket_get_mod_time (PhoshTicket *self);
+GdkPixbuf         *phosh_ticket_get_thumbnail (PhoshTicket *self);
+void               phosh_ticket_ensure_thumbnail (PhoshTicket *self, int size);
+void               phosh_ticket_prune_thumbnails (GListModel *tickets);
+EvDocument        *phosh_ticket_get_document (PhoshTicket *self);
+void               phosh_ticket_load_document_async (PhoshTicket         *self,
+                                                     GCancellable        *cancel,
+                                                     GAsyncReadyCallback  callback,
+                                                     gpointer             user_data);
+EvDocument        *phosh_ticket_load_document_finish (PhoshTicket   *self,
+                                                      GAsyncResult  *res,
+                                                      GError       **err);
+void               phosh_ticket_drop_document (PhoshTicket *self);
 
 G_END_DECLS
@@ -725,3 +725,26 @@ phosh_activity_get_thumbnail_allocation (PhoshActivity *self, GtkAllocation *all
 
   *allocation = priv->allocation;
 }
+
+/**
+ * phosh_activity_reset:
+ * @self: The activity
+ *
+ * Undo a previous swipe away and drop the thumbnail so an unused
+ * activity can be shown again for a different toplevel.
+ */
+void
+phosh_activity_reset (PhoshActivity *self)
+{
+  PhoshActivityPrivate *priv;
+
+  g_return_if_fail (PHOSH_IS_ACTIVITY (self));
+  priv = phosh_activity_get_instance_private (self);
+
+  g_clear_handle_id (&priv->remove_timeout_id, g_source_remove);
+  phosh_swipe_away_bin_undo (PHOSH_SWIPE_AWAY_BIN (priv->swipe_bin));
+
+  g_clear_pointer (&priv->surface, cairo_surface_destroy);
+  g_clear_object (&priv->thumbnail);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
@@ -12,9 +12,11 @@
 #include "animation.h"
 #include "fader.h"
 #include "ambient.h"
+#include "property-coalescer.h"
 #include "shell.h"
 #include "sensor-proxy-manager.h"
 #include "util.h"
+#include "wakeup-scheduler.h"
 
 #define INTERFACE_SETTINGS      "org.gnome.desktop.interface"
 #define HIGH_CONTRAST_THEME     "HighContrast"
@@ -26,6 +28,10 @@
 #define KEY_AUTOMATIC_HC_THRESHOLD  "automatic-high-contrast-threshold"
 
 #define NUM_VALUES              3
+/* Light level updates can come in at sensor rate */
+#define LIGHT_LEVEL_INTERVAL    500 /* ms */
+/* Switch the theme anyway when the fader doesn't get frames, e.g. when unmapped */
+#define FADER_FALLBACK_TIMEOUT  500 /* ms */
 
 /**
  * PhoshAmbient:
@@ -49,6 +55,7 @@ typedef struct _PhoshAmbient {
 
   gboolean                 claimed;
   PhoshSensorProxyManager *sensor_proxy_manager;
+  PhoshPropertyCoalescer  *coalescer;
   GCancellable            *cancel;
 
   GSettings               *phosh_settings;
@@ -60,6 +67,8 @@ typedef struct _PhoshAmbient {
 
   PhoshFader              *fader;
   guint                    fader_id;
+  guint                    fader_timeout_id;
+  gint64                   fader_start;
 } PhoshAmbient;
 
 G_DEFINE_TYPE (PhoshAmbient, phosh_ambient, G_TYPE_OBJECT);
@@ -104,9 +113,21 @@ phosh_ambient_get_property (GObject    *object,
 }
 
 
-static gboolean
-on_fade_in_done (PhoshAmbient *self)
+static void
+clear_fader_wait (PhoshAmbient *self)
 {
+  if (self->fader && self->fader_id)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (self->fader), self->fader_id);
+  self->fader_id = 0;
+  g_clear_handle_id (&self->fader_timeout_id, g_source_remove);
+}
+
+
+static void
+apply_theme (PhoshAmbient *self)
+{
+  clear_fader_wait (self);
+
   if (self->use_hc) {
     g_settings_set_string (self->interface_settings, KEY_GTK_THEME, HIGH_CONTRAST_THEME);
   } else {
@@ -115,6 +136,38 @@ on_fade_in_done (PhoshAmbient *self)
   }
 
   phosh_fader_hide (self->fader);
+}
+
+
+static gboolean
+on_fader_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+  PhoshAmbient *self = PHOSH_AMBIENT (user_data);
+  gint64 frame_time = gdk_frame_clock_get_frame_time (frame_clock) / 1000;
+
+  /* Wait for the fader to be on screen before switching the theme */
+  if (self->fader_start == 0)
+    self->fader_start = frame_time;
+
+  if (frame_time - self->fader_start < 100 * PHOSH_ANIMATION_SLOWDOWN)
+    return G_SOURCE_CONTINUE;
+
+  /* Removed by us already */
+  self->fader_id = 0;
+  apply_theme (self);
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+on_fader_timeout (gpointer user_data)
+{
+  PhoshAmbient *self = PHOSH_AMBIENT (user_data);
+
+  g_debug ("Fader didn't get any frames, switching theme anyway");
+  self->fader_timeout_id = 0;
+  apply_theme (self);
+
   return G_SOURCE_REMOVE;
 }
 
@@ -135,10 +188,16 @@ switch_theme (PhoshAmbient *self, gboolean use_hc)
                               NULL);
   gtk_widget_show (GTK_WIDGET (self->fader));
 
-  self->fader_id = g_timeout_add (100 * PHOSH_ANIMATION_SLOWDOWN,
-                                  G_SOURCE_FUNC (on_fade_in_done),
-                                  self);
-  g_source_set_name_by_id (self->fader_id, "[phosh] ambient fader");
+  self->fader_start = 0;
+  self->fader_id = gtk_widget_add_tick_callback (GTK_WIDGET (self->fader),
+                                                 on_fader_tick,
+                                                 self,
+                                                 NULL);
+  /* Tick callbacks only run while the fader is mapped */
+  self->fader_timeout_id = g_timeout_add (FADER_FALLBACK_TIMEOUT * PHOSH_ANIMATION_SLOWDOWN,
+                                          on_fader_timeout,
+                                          self);
+  g_source_set_name_by_id (self->fader_timeout_id, "[phosh] ambient fader");
 
   self->use_hc = use_hc;
 }
@@ -215,8 +274,12 @@ on_ambient_light_level_changed (PhoshAmbient            *self,
   g_return_if_fail (self->sample_id == 0);
   g_return_if_fail (self->values->len == 0);
   g_array_append_val (self->values, level);
-  self->sample_id = g_timeout_add_seconds (1, on_ambient_light_level_sample, self);
-  g_source_set_name_by_id (self->sample_id, "[phosh] ambient_sample");
+  self->sample_id = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                                "[phosh] ambient_sample",
+                                                1,
+                                                PHOSH_WAKEUP_FLAG_UI,
+                                                on_ambient_light_level_sample,
+                                                self);
 }
 
 
@@ -350,6 +413,21 @@ on_shell_state_changed (PhoshAmbient  *self,
 }
 
 
+static void
+on_sensor_props_changed (PhoshAmbient           *self,
+                         GObject                *object,
+                         GStrv                   properties,
+                         PhoshPropertyCoalescer *coalescer)
+{
+  /* Both can change in the same batch, handle the sensor showing up first */
+  if (g_strv_contains ((const char * const *)properties, "HasAmbientLight"))
+    on_has_ambient_light_changed (self, NULL, self->sensor_proxy_manager);
+
+  if (g_strv_contains ((const char * const *)properties, "LightLevel"))
+    on_ambient_light_level_changed (self, NULL, self->sensor_proxy_manager);
+}
+
+
 static void
 phosh_ambient_constructed (GObject *object)
 {
@@ -357,14 +435,13 @@ phosh_ambient_constructed (GObject *object)
 
   G_OBJECT_CLASS (phosh_ambient_parent_class)->constructed (object);
 
-  g_object_connect (self->sensor_proxy_manager,
-                    "swapped-signal::notify::light-level",
-                    on_ambient_light_level_changed,
-                    self,
-                    "swapped-signal::notify::has-ambient-light",
-                    on_has_ambient_light_changed,
-                    self,
-                    NULL);
+  self->coalescer = phosh_property_coalescer_new ();
+  phosh_property_coalescer_set_interval (self->coalescer, LIGHT_LEVEL_INTERVAL, "LightLevel", NULL);
+  g_signal_connect_swapped (self->coalescer,
+                            "changed",
+                            G_CALLBACK (on_sensor_props_changed),
+                            self);
+  phosh_property_coalescer_watch (self->coalescer, G_DBUS_PROXY (self->sensor_proxy_manager));
 
   g_object_connect (self->phosh_settings,
                     "swapped-signal::changed::" KEY_AUTOMATIC_HC,
@@ -396,6 +473,10 @@ phosh_ambient_dispose (GObject *object)
   g_clear_handle_id (&self->sample_id, g_source_remove);
   g_clear_pointer (&self->values, g_array_unref);
 
+  if (self->coalescer)
+    g_signal_handlers_disconnect_by_data (self->coalescer, self);
+  g_clear_object (&self->coalescer);
+
   if (self->sensor_proxy_manager) {
     g_signal_handlers_disconnect_by_data (self->sensor_proxy_manager, self);
     phosh_dbus_sensor_proxy_call_release_light_sync (
@@ -406,7 +487,7 @@ phosh_ambient_dispose (GObject *object)
   g_clear_object (&self->phosh_settings);
   g_clear_object (&self->interface_settings);
 
-  g_clear_handle_id (&self->fader_id, g_source_remove);
+  clear_fader_wait (self);
   g_clear_pointer (&self->fader, phosh_cp_widget_destroy);
 
   G_OBJECT_CLASS (phosh_ambient_parent_class)->dispose (object);
@@ -9,10 +9,27 @@
 #include "phosh-config.h"
 
 #include "animation.h"
+#include "wakeup-scheduler.h"
 #include <handy.h>
 
+/**
+ * PhoshAnimation:
+ *
+ * A simple animation driven by the widget's frame clock
+ *
+ * All animations running on the same frame clock are driven by a
+ * single timeline. On each frame the timeline first computes the
+ * values of all its animations and then applies them in one go
+ * before layout happens.
+ *
+ * Animations started while the screen is off jump to their end value
+ * right away so they don't request frames nobody sees.
+ */
+
 G_DEFINE_BOXED_TYPE (PhoshAnimation, phosh_animation, phosh_animation_ref, phosh_animation_unref)
 
+typedef struct _PhoshTimeline PhoshTimeline;
+
 struct _PhoshAnimation
 {
   gatomicrefcount ref_count;
@@ -27,13 +44,24 @@ struct _PhoshAnimation
   PhoshAnimationType type;
 
   gint64 start_time;
-  guint tick_cb_id;
+  /* The timeline driving the animation while it's running */
+  PhoshTimeline *timeline;
+  gboolean finished;
 
   PhoshAnimationValueCallback value_cb;
   PhoshAnimationDoneCallback done_cb;
   gpointer user_data;
 };
 
+struct _PhoshTimeline
+{
+  GdkFrameClock *frame_clock;
+  GPtrArray     *animations;
+  gulong         update_id;
+};
+
+static GQuark timeline_quark;
+
 static void
 set_value (PhoshAnimation *self,
            double          value)
@@ -104,36 +132,135 @@ interpolate (PhoshAnimationType type, double t)
   case PHOSH_ANIMATION_TYPE_EASE_OUT_BOUNCE:
     return ease_out_bounce (t);
 
+  case PHOSH_ANIMATION_TYPE_LINEAR:
+    return t;
+
   default:
     g_assert_not_reached ();
   }
 }
 
-static gboolean
-tick_cb (GtkWidget       *widget,
-         GdkFrameClock   *frame_clock,
-         PhoshAnimation  *self)
+static void
+timeline_free (PhoshTimeline *timeline)
 {
-  gint64 frame_time = gdk_frame_clock_get_frame_time (frame_clock) / 1000;
-  double t = (double) (frame_time - self->start_time) / self->duration;
+  /* Animations get removed on unmap so there shouldn't be any left */
+  g_warn_if_fail (timeline->animations->len == 0);
 
-  if (t >= 1) {
-    self->tick_cb_id = 0;
+  for (guint i = 0; i < timeline->animations->len; i++) {
+    PhoshAnimation *animation = g_ptr_array_index (timeline->animations, i);
 
-    set_value (self, self->value_to);
+    animation->timeline = NULL;
+  }
+
+  /* The frame clock is gone so there's no handler to disconnect */
+  g_ptr_array_free (timeline->animations, TRUE);
+  g_free (timeline);
+}
 
-    g_signal_handlers_disconnect_by_func (self->widget, phosh_animation_stop, self);
 
-    self->done_cb (self->user_data);
+static void
+timeline_remove (PhoshTimeline *timeline, PhoshAnimation *animation)
+{
+  g_ptr_array_remove_fast (timeline->animations, animation);
+  animation->timeline = NULL;
+
+  if (timeline->animations->len == 0 && timeline->update_id) {
+    g_clear_signal_handler (&timeline->update_id, timeline->frame_clock);
+    gdk_frame_clock_end_updating (timeline->frame_clock);
+  }
+}
+
+
+static void
+finish (PhoshAnimation *self)
+{
+  timeline_remove (self->timeline, self);
+  g_signal_handlers_disconnect_by_func (self->widget, phosh_animation_stop, self);
+
+  self->done_cb (self->user_data);
+}
+
+
+static void
+on_frame_clock_update (GdkFrameClock *frame_clock, PhoshTimeline *timeline)
+{
+  g_autoptr (GPtrArray) animations = NULL;
+  gint64 frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+
+  /* Callbacks might start or stop animations so work on a copy */
+  animations = g_ptr_array_new_full (timeline->animations->len,
+                                     (GDestroyNotify) phosh_animation_unref);
+  for (guint i = 0; i < timeline->animations->len; i++)
+    g_ptr_array_add (animations, phosh_animation_ref (g_ptr_array_index (timeline->animations, i)));
+
+  /* Compute all values first… */
+  for (guint i = 0; i < animations->len; i++) {
+    PhoshAnimation *self = g_ptr_array_index (animations, i);
+    double t = (double) (frame_time / 1000 - self->start_time) / self->duration;
+
+    if (t >= 1) {
+      self->finished = TRUE;
+      self->value = self->value_to;
+    } else {
+      self->value = LERP (self->value_from, self->value_to, interpolate (self->type, t));
+    }
+  }
 
-    return G_SOURCE_REMOVE;
+  /* …then apply them in one batch before layout… */
+  for (guint i = 0; i < animations->len; i++) {
+    PhoshAnimation *self = g_ptr_array_index (animations, i);
+
+    if (self->timeline == timeline)
+      self->value_cb (self->value, self->user_data);
   }
 
-  set_value (self, LERP (self->value_from, self->value_to, interpolate (self->type, t)));
+  /* …and finally notify about completed animations */
+  for (guint i = 0; i < animations->len; i++) {
+    PhoshAnimation *self = g_ptr_array_index (animations, i);
 
-  return G_SOURCE_CONTINUE;
+    if (self->timeline == timeline && self->finished)
+      finish (self);
+  }
 }
 
+
+static PhoshTimeline *
+get_timeline (GdkFrameClock *frame_clock)
+{
+  PhoshTimeline *timeline;
+
+  if (G_UNLIKELY (timeline_quark == 0))
+    timeline_quark = g_quark_from_static_string ("phosh-animation-timeline");
+
+  timeline = g_object_get_qdata (G_OBJECT (frame_clock), timeline_quark);
+  if (timeline)
+    return timeline;
+
+  timeline = g_new0 (PhoshTimeline, 1);
+  timeline->frame_clock = frame_clock;
+  timeline->animations = g_ptr_array_new ();
+  g_object_set_qdata_full (G_OBJECT (frame_clock), timeline_quark, timeline,
+                           (GDestroyNotify) timeline_free);
+
+  return timeline;
+}
+
+
+static void
+timeline_add (PhoshTimeline *timeline, PhoshAnimation *animation)
+{
+  g_ptr_array_add (timeline->animations, animation);
+  animation->timeline = timeline;
+
+  if (timeline->update_id == 0) {
+    timeline->update_id = g_signal_connect (timeline->frame_clock, "update",
+                                            G_CALLBACK (on_frame_clock_update),
+                                            timeline);
+    gdk_frame_clock_begin_updating (timeline->frame_clock);
+  }
+}
+
+
 static void
 phosh_animation_free (PhoshAnimation *self)
 {
@@ -217,10 +344,13 @@ phosh_animation_unref (PhoshAnimation *self)
 void
 phosh_animation_start (PhoshAnimation *self)
 {
+  GdkFrameClock *frame_clock;
+
   g_return_if_fail (self != NULL);
 
   if (!hdy_get_enable_animations (self->widget) ||
       !gtk_widget_get_mapped (self->widget) ||
+      phosh_wakeup_scheduler_get_screen_off (phosh_wakeup_scheduler_get_default ()) ||
       self->duration <= 0) {
     set_value (self, self->value_to);
 
@@ -229,14 +359,16 @@ phosh_animation_start (PhoshAnimation *self)
     return;
   }
 
-  if (self->tick_cb_id)
-    gtk_widget_remove_tick_callback (self->widget, self->tick_cb_id);
+  if (self->timeline)
+    timeline_remove (self->timeline, self);
   else
     g_signal_connect_swapped (self->widget, "unmap",
                               G_CALLBACK (phosh_animation_stop), self);
 
-  self->start_time = gdk_frame_clock_get_frame_time (gtk_widget_get_frame_clock (self->widget)) / 1000;
-  self->tick_cb_id = gtk_widget_add_tick_callback (self->widget, (GtkTickCallback) tick_cb, self, NULL);
+  frame_clock = gtk_widget_get_frame_clock (self->widget);
+  self->start_time = gdk_frame_clock_get_frame_time (frame_clock) / 1000;
+  self->finished = FALSE;
+  timeline_add (get_timeline (frame_clock), self);
 }
 
 void
@@ -244,11 +376,10 @@ phosh_animation_stop (PhoshAnimation *self)
 {
   g_return_if_fail (self != NULL);
 
-  if (!self->tick_cb_id)
+  if (!self->timeline)
     return;
 
-  gtk_widget_remove_tick_callback (self->widget, self->tick_cb_id);
-  self->tick_cb_id = 0;
+  timeline_remove (self->timeline, self);
 
   g_signal_handlers_disconnect_by_func (self->widget, phosh_animation_stop, self);
 
@@ -19,6 +19,7 @@ G_BEGIN_DECLS
  * @PHOSH_ANIMATION_TYPE_EASE_IN_QUINTIC: Use ease in quintic interpolation.
  * @PHOSH_ANIMATION_TYPE_EASE_OUT_QUINTIC: Use ease out quintic interpolation.
  * @PHOSH_ANIMATION_TYPE_EASE_OUT_BOUNCE: Use easeOutBounce interpolation.
+ * @PHOSH_ANIMATION_TYPE_LINEAR: Use linear interpolation.
  *
  * The animation type of #PhoshAnimationType.
  */
@@ -27,6 +28,7 @@ typedef enum {
   PHOSH_ANIMATION_TYPE_EASE_IN_QUINTIC,
   PHOSH_ANIMATION_TYPE_EASE_OUT_QUINTIC,
   PHOSH_ANIMATION_TYPE_EASE_OUT_BOUNCE,
+  PHOSH_ANIMATION_TYPE_LINEAR,
 } PhoshAnimationType;
 
 typedef struct _PhoshAnimation PhoshAnimation;
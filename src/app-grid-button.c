@@ -9,6 +9,7 @@
 #include "phosh-config.h"
 #include "app-tracker.h"
 #include "app-grid-button.h"
+#include "app-icon-cache.h"
 #include "clamp.h"
 #include "fading-label.h"
 #include "phosh-enums.h"
@@ -638,20 +639,11 @@ phosh_app_grid_button_set_app_info (PhoshAppGridButton *self,
     name = g_app_info_get_name (G_APP_INFO (priv->info));
     phosh_app_grid_base_button_set_label (PHOSH_APP_GRID_BASE_BUTTON (self), name);
 
-    icon = g_app_info_get_icon (priv->info);
-    if (G_UNLIKELY (icon == NULL)) {
-      gtk_image_set_from_icon_name (GTK_IMAGE (priv->icon),
-                                    PHOSH_APP_UNKNOWN_ICON,
-                                    GTK_ICON_SIZE_DIALOG);
-    } else {
-      if (G_IS_THEMED_ICON (icon)) {
-        g_themed_icon_append_name (G_THEMED_ICON (icon),
-                                   PHOSH_APP_UNKNOWN_ICON);
-      }
-      gtk_image_set_from_gicon (GTK_IMAGE (priv->icon),
-                                icon,
-                                GTK_ICON_SIZE_DIALOG);
-    }
+    icon = phosh_app_icon_cache_get_app_icon (priv->info);
+    phosh_app_icon_cache_set_image (phosh_app_icon_cache_get_default (),
+                                    GTK_IMAGE (priv->icon),
+                                    icon,
+                                    gtk_image_get_pixel_size (GTK_IMAGE (priv->icon)));
 
     gtk_widget_set_sensitive (GTK_WIDGET (self), TRUE);
 
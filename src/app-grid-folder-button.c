@@ -10,6 +10,7 @@
 
 #include "app-grid-button.h"
 #include "app-grid-folder-button.h"
+#include "app-icon-cache.h"
 
 /**
  * PhoshAppGridFolderButton:
@@ -103,24 +104,15 @@ build_2x2_grid_icon (PhoshAppGridFolderButton *self)
     GtkWidget *image = NULL;
     app_info = g_list_model_get_item (apps, i);
 
-    icon = g_app_info_get_icon (app_info);
-
-    if (icon == NULL) {
-      image = gtk_image_new_from_icon_name (PHOSH_APP_UNKNOWN_ICON,
-                                            GTK_ICON_SIZE_DND);
-    } else {
-      if (G_IS_THEMED_ICON (icon)) {
-        g_themed_icon_append_name (G_THEMED_ICON (icon),
-                                   PHOSH_APP_UNKNOWN_ICON);
-      }
-      image = gtk_image_new_from_gicon (icon, GTK_ICON_SIZE_DND);
-    }
+    icon = phosh_app_icon_cache_get_app_icon (app_info);
 
     /* app-grid-button uses 64px for its icon.
      * Our grid has two rows and two columns, with 8px for spacing.
      * So 2x + 8 = 64.
      * It means x = 28. But we use 24 as icons usually have a 2px padding. */
+    image = gtk_image_new ();
     gtk_image_set_pixel_size (GTK_IMAGE (image), 24);
+    phosh_app_icon_cache_set_image (phosh_app_icon_cache_get_default (), GTK_IMAGE (image), icon, 24);
     gtk_widget_set_visible (image, TRUE);
     gtk_grid_attach (self->grid, image, i % 2, i >= 2, 1, 1);
   }
@@ -11,6 +11,14 @@
 #define SEARCH_DEBOUNCE 350
 #define DEFAULT_GTK_DEBOUNCE 150
 
+/* Launchers created right away, the rest is added in batches when idle */
+#define EAGER_LAUNCHERS 24
+#define LAUNCHER_FILL_BATCH 16
+/* Unused buttons to keep around for reuse */
+#define MAX_POOLED_LAUNCHERS 48
+/* The icon size of app-grid-button.ui */
+#define APP_ICON_SIZE 64
+
 #define _GNU_SOURCE
 #include <string.h>
 
@@ -18,12 +26,13 @@
 #include "app-grid.h"
 #include "app-grid-button.h"
 #include "app-grid-folder-button.h"
+#include "app-icon-cache.h"
 #include "app-list-model.h"
 #include "favorite-list-model.h"
 #include "shell.h"
+#include "sorted-app-list-model.h"
 #include "util.h"
 
-#include "gtk-list-models/gtksortlistmodel.h"
 #include "gtk-list-models/gtkfilterlistmodel.h"
 
 #include <gmobile.h>
@@ -73,6 +82,16 @@ struct _PhoshAppGridPrivate {
   GSimpleActionGroup *actions;
   PhoshAppFilterModeFlags filter_mode;
   guint debounce;
+
+  /* Model items [0, n_launchers) have a button in @apps */
+  guint       n_launchers;
+  guint       fill_id;
+  /* Buttons no longer in @apps, by app id */
+  GHashTable *launcher_pool;
+  /* App ids in @launcher_pool, least recently pooled first */
+  GQueue      launcher_pool_order;
+  /* Scale factor app icons got preloaded for */
+  int         preloaded_scale;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhoshAppGrid, phosh_app_grid, GTK_TYPE_BOX)
@@ -236,22 +255,6 @@ folder_launched_cb (GtkWidget       *widget,
 }
 
 
-static int
-sort_apps (gconstpointer a,
-           gconstpointer b,
-           gpointer      data)
-{
-  const char *empty = "";
-  GAppInfo *info1 = G_APP_INFO (a);
-  GAppInfo *info2 = G_APP_INFO (b);
-
-  g_autofree char *s1 = g_utf8_casefold (g_app_info_get_name (info1), -1);
-  g_autofree char *s2 = g_utf8_casefold (g_app_info_get_name (info2), -1);
-
-  return g_utf8_collate (s1 ?: empty, s2 ?: empty);
-}
-
-
 static void
 update_filter_adaptive_button (PhoshAppGrid *self)
 {
@@ -430,11 +433,307 @@ create_launcher (gpointer item,
 }
 
 
+static void
+drop_pooled_launcher (PhoshAppGrid *self, const char *id)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  GList *link;
+
+  link = g_queue_find_custom (&priv->launcher_pool_order, id, (GCompareFunc)g_strcmp0);
+  if (link) {
+    g_free (link->data);
+    g_queue_delete_link (&priv->launcher_pool_order, link);
+  }
+  g_hash_table_remove (priv->launcher_pool, id);
+}
+
+
+static void
+insert_launcher (PhoshAppGrid *self, GAppInfo *info, int position)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  g_autofree char *id = NULL;
+  GtkWidget *btn = NULL;
+
+  /* Rebind a pooled button rather than building a new one */
+  if (!PHOSH_IS_FOLDER_INFO (info) && g_app_info_get_id (info) &&
+      g_hash_table_steal_extended (priv->launcher_pool, g_app_info_get_id (info),
+                                   (gpointer *)&id, (gpointer *)&btn)) {
+    drop_pooled_launcher (self, id);
+    phosh_app_grid_button_set_app_info (PHOSH_APP_GRID_BUTTON (btn), info);
+    gtk_flow_box_insert (GTK_FLOW_BOX (priv->apps), btn, position);
+    g_object_unref (btn);
+    return;
+  }
+
+  btn = create_launcher (info, self);
+  gtk_flow_box_insert (GTK_FLOW_BOX (priv->apps), btn, position);
+}
+
+
+static void
+release_launcher (PhoshAppGrid *self, GtkWidget *btn)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+
+  if (PHOSH_IS_APP_GRID_BUTTON (btn)) {
+    GAppInfo *info = phosh_app_grid_button_get_app_info (PHOSH_APP_GRID_BUTTON (btn));
+    const char *id = info ? g_app_info_get_id (info) : NULL;
+
+    if (id) {
+      drop_pooled_launcher (self, id);
+      g_hash_table_insert (priv->launcher_pool, g_strdup (id), g_object_ref (btn));
+      g_queue_push_tail (&priv->launcher_pool_order, g_strdup (id));
+
+      while (priv->launcher_pool_order.length > MAX_POOLED_LAUNCHERS) {
+        g_autofree char *oldest = g_queue_pop_head (&priv->launcher_pool_order);
+
+        g_hash_table_remove (priv->launcher_pool, oldest);
+      }
+    }
+  }
+
+  gtk_container_remove (GTK_CONTAINER (priv->apps), btn);
+}
+
+
+static void
+preload_icons (PhoshAppGrid *self)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  int scale = gtk_widget_get_scale_factor (GTK_WIDGET (self));
+
+  if (priv->preloaded_scale == scale)
+    return;
+
+  priv->preloaded_scale = scale;
+  phosh_app_icon_cache_preload (phosh_app_icon_cache_get_default (),
+                                G_LIST_MODEL (phosh_app_list_model_get_default ()),
+                                APP_ICON_SIZE,
+                                scale);
+}
+
+
+/* Drop pooled buttons of apps that got uninstalled */
+static void
+on_installed_apps_changed (PhoshAppGrid *self,
+                           guint         position,
+                           guint         removed,
+                           guint         added,
+                           GListModel   *apps)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  g_autoptr (GHashTable) installed = NULL;
+  GList *link, *next;
+  guint n_items;
+
+  /* Render new apps' icons before they get shown */
+  priv->preloaded_scale = 0;
+  if (gtk_widget_get_mapped (GTK_WIDGET (self)))
+    preload_icons (self);
+
+  if (g_hash_table_size (priv->launcher_pool) == 0)
+    return;
+
+  installed = g_hash_table_new (g_str_hash, g_str_equal);
+  n_items = g_list_model_get_n_items (apps);
+  for (guint i = 0; i < n_items; i++) {
+    g_autoptr (GObject) item = g_list_model_get_item (apps, i);
+
+    /* Ids are owned by the model's items which outlive this function */
+    if (G_IS_APP_INFO (item) && g_app_info_get_id (G_APP_INFO (item)))
+      g_hash_table_add (installed, (gpointer)g_app_info_get_id (G_APP_INFO (item)));
+  }
+
+  for (link = priv->launcher_pool_order.head; link; link = next) {
+    next = link->next;
+
+    if (g_hash_table_contains (installed, link->data))
+      continue;
+
+    g_debug ("Dropping launcher of uninstalled app %s", (char *)link->data);
+    g_hash_table_remove (priv->launcher_pool, link->data);
+    g_free (link->data);
+    g_queue_delete_link (&priv->launcher_pool_order, link);
+  }
+}
+
+
+/* Whether more buttons are needed to fill the visible area and the next page */
+static gboolean
+needs_more_launchers (PhoshAppGrid *self)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  GtkAdjustment *adjustment;
+  GtkFlowBoxChild *last;
+  double page_size;
+  int x, y;
+
+  if (priv->n_launchers >= g_list_model_get_n_items (G_LIST_MODEL (priv->model)))
+    return FALSE;
+
+  if (priv->n_launchers < EAGER_LAUNCHERS)
+    return TRUE;
+
+  /* Not laid out yet, can't tell what is visible */
+  if (!gtk_widget_get_mapped (GTK_WIDGET (self)))
+    return FALSE;
+
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (priv->scrolled_window));
+  page_size = gtk_adjustment_get_page_size (adjustment);
+  last = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (priv->apps), priv->n_launchers - 1);
+  if (last == NULL || !gtk_widget_get_child_visible (GTK_WIDGET (last)))
+    return TRUE;
+
+  if (!gtk_widget_translate_coordinates (GTK_WIDGET (last), priv->scrolled_window, 0, 0, &x, &y))
+    return TRUE;
+
+  return y < 2 * page_size;
+}
+
+
+static gboolean
+on_fill_launchers_idle (gpointer data)
+{
+  PhoshAppGrid *self = PHOSH_APP_GRID (data);
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  guint n_items, end;
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->model));
+  end = MIN (n_items, priv->n_launchers + LAUNCHER_FILL_BATCH);
+
+  for (guint i = priv->n_launchers; i < end; i++) {
+    g_autoptr (GAppInfo) info = g_list_model_get_item (G_LIST_MODEL (priv->model), i);
+
+    insert_launcher (self, info, i);
+  }
+  priv->n_launchers = end;
+
+  /* The rest gets filled in as the user scrolls */
+  priv->fill_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+schedule_fill_launchers (PhoshAppGrid *self)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+
+  if (priv->fill_id)
+    return;
+
+  if (!needs_more_launchers (self))
+    return;
+
+  priv->fill_id = g_idle_add (on_fill_launchers_idle, self);
+  g_source_set_name_by_id (priv->fill_id, "[phosh] fill app grid");
+}
+
+
+static void
+on_apps_items_changed (PhoshAppGrid *self,
+                       guint         position,
+                       guint         removed,
+                       guint         added,
+                       GListModel   *model)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  guint n_removed, n_added, window;
+
+  /* Not created yet, will be picked up when filling */
+  if (position >= priv->n_launchers) {
+    schedule_fill_launchers (self);
+    return;
+  }
+
+  /* Only create buttons up to what was shown so far (e.g. when a search
+   * gets cleared), filling in the rest happens as needed */
+  window = MAX (priv->n_launchers, EAGER_LAUNCHERS);
+
+  n_removed = MIN (position + removed, priv->n_launchers) - position;
+  for (guint i = 0; i < n_removed; i++) {
+    GtkFlowBoxChild *child = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (priv->apps), position);
+
+    release_launcher (self, GTK_WIDGET (child));
+  }
+  priv->n_launchers -= n_removed;
+
+  n_added = MIN (added, window - position);
+  for (guint i = 0; i < n_added; i++) {
+    g_autoptr (GAppInfo) info = g_list_model_get_item (model, position + i);
+
+    insert_launcher (self, info, position + i);
+  }
+
+  if (n_added < added) {
+    /* The buttons after the insertion no longer match the model */
+    for (; priv->n_launchers > position; priv->n_launchers--) {
+      GtkFlowBoxChild *child;
+
+      child = gtk_flow_box_get_child_at_index (GTK_FLOW_BOX (priv->apps),
+                                               priv->n_launchers + n_added - 1);
+      release_launcher (self, GTK_WIDGET (child));
+    }
+  }
+
+  priv->n_launchers += n_added;
+  schedule_fill_launchers (self);
+}
+
+
+static void
+bind_launchers (PhoshAppGrid *self)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  GtkAdjustment *adjustment;
+  guint n_items;
+
+  g_signal_connect_object (priv->model,
+                           "items-changed",
+                           G_CALLBACK (on_apps_items_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (phosh_app_list_model_get_default (),
+                           "items-changed",
+                           G_CALLBACK (on_installed_apps_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  /* Fill in more buttons when scrolling or after a batch got laid out */
+  adjustment = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (priv->scrolled_window));
+  g_signal_connect_object (adjustment,
+                           "value-changed",
+                           G_CALLBACK (schedule_fill_launchers),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect_object (adjustment,
+                           "changed",
+                           G_CALLBACK (schedule_fill_launchers),
+                           self,
+                           G_CONNECT_SWAPPED);
+  g_signal_connect (self, "map", G_CALLBACK (schedule_fill_launchers), NULL);
+  /* Only preload once the scale factor is known */
+  g_signal_connect (self, "map", G_CALLBACK (preload_icons), NULL);
+
+  /* Only fill what is likely visible right away */
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (priv->model));
+  priv->n_launchers = MIN (n_items, EAGER_LAUNCHERS);
+  for (guint i = 0; i < priv->n_launchers; i++) {
+    g_autoptr (GAppInfo) info = g_list_model_get_item (G_LIST_MODEL (priv->model), i);
+
+    insert_launcher (self, info, i);
+  }
+
+  schedule_fill_launchers (self);
+}
+
+
 static void
 phosh_app_grid_init (PhoshAppGrid *self)
 {
   PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
-  GtkSortListModel *sorted;
+  PhoshSortedAppListModel *sorted;
   PhoshFavoriteListModel *favorites;
   g_autoptr (GAction) action = NULL;
 
@@ -451,18 +750,15 @@ phosh_app_grid_init (PhoshAppGrid *self)
                     self);
 
   /* fill the grid with apps */
-  sorted = gtk_sort_list_model_new (G_LIST_MODEL (phosh_app_list_model_get_default ()),
-                                    sort_apps,
-                                    NULL,
-                                    NULL);
+  sorted = phosh_sorted_app_list_model_new (G_LIST_MODEL (phosh_app_list_model_get_default ()));
   priv->model = gtk_filter_list_model_new (G_LIST_MODEL (sorted),
                                            search_apps,
                                            self,
                                            NULL);
   g_object_unref (sorted);
-  gtk_flow_box_bind_model (GTK_FLOW_BOX (priv->apps),
-                           G_LIST_MODEL (priv->model),
-                           create_launcher, self, NULL);
+  /* Not using gtk_flow_box_bind_model () so buttons can be reused */
+  priv->launcher_pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  bind_launchers (self);
 
   priv->settings = g_settings_new ("sm.puri.phosh");
   g_object_connect (priv->settings,
@@ -494,6 +790,9 @@ phosh_app_grid_dispose (GObject *object)
   g_clear_object (&priv->model);
   g_clear_object (&priv->settings);
   g_clear_handle_id (&priv->debounce, g_source_remove);
+  g_clear_handle_id (&priv->fill_id, g_source_remove);
+  g_clear_pointer (&priv->launcher_pool, g_hash_table_unref);
+  g_queue_clear_full (&priv->launcher_pool_order, g_free);
 
   G_OBJECT_CLASS (phosh_app_grid_parent_class)->dispose (object);
 }
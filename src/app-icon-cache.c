@@ -0,0 +1,936 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-app-icon-cache"
+
+#include "phosh-config.h"
+
+#include "app-grid-button.h"
+#include "app-icon-cache.h"
+#include "memory-accounting.h"
+
+#include <glib/gstdio.h>
+
+#define ICON_KEY_DATA "phosh-app-icon-cache-key"
+#define ICON_DATA "phosh-app-icon-cache-icon"
+#define ICON_SIZE_DATA "phosh-app-icon-cache-size"
+/* Number of icons to look up per preload iteration */
+#define PRELOAD_BATCH 8
+
+/**
+ * PhoshAppIconCache:
+ *
+ * A cache of pre-rendered app icons
+ *
+ * App icons are rendered once per size and scale and kept as cairo
+ * surfaces that can be shared between all the images showing the same
+ * icon. The icon theme lookup happens on the main thread while
+ * rendering happens asynchronously in a worker thread. Images show a
+ * blank placeholder of the icon's size until the surface is ready.
+ *
+ * Rendered icons are also stored as PNGs in the user's cache
+ * directory so they don't need to be rendered from e.g. SVGs again on
+ * the next start. The on disk cache is dropped whenever the icon
+ * theme's cache or an icon directory changes. Checking this happens in
+ * a worker thread as well, loads from disk wait for it to finish.
+ */
+
+struct _PhoshAppIconCache {
+  GObject       parent;
+
+  GtkIconTheme *icon_theme;
+  char         *cache_dir;
+  GCancellable *cancel;
+
+  /* key -> cairo_surface_t */
+  GHashTable   *surfaces;
+  /* key -> GPtrArray of GtkImage waiting for that key */
+  GHashTable   *pending;
+  /* size@scale -> transparent cairo_surface_t */
+  GHashTable   *placeholders;
+  /* GtkImages showing an icon from the cache */
+  GHashTable   *images;
+
+  /* GIcon, size and scale of icons to preload */
+  GQueue        preload;
+  guint         preload_id;
+
+  /* Fetches waiting for the on disk cache to be validated */
+  gboolean      validating;
+  gboolean      revalidate;
+  GQueue        deferred_fetches;
+};
+G_DEFINE_TYPE (PhoshAppIconCache, phosh_app_icon_cache, G_TYPE_OBJECT)
+
+
+typedef struct {
+  GIcon *icon;
+  int    size;
+  int    scale;
+} IconPreload;
+
+
+typedef struct {
+  char              *cache_dir;
+  char              *theme_name;
+  GStrv              search_path;
+} DiskCacheValidation;
+
+
+typedef struct {
+  PhoshAppIconCache *self;
+  char              *key;
+  char              *path;
+  GIcon             *icon;
+  int                size;
+  int                scale;
+  GdkPixbuf         *pixbuf;
+} IconFetch;
+
+
+static void
+icon_fetch_free (IconFetch *fetch)
+{
+  g_clear_object (&fetch->self);
+  g_free (fetch->key);
+  g_free (fetch->path);
+  g_clear_object (&fetch->icon);
+  g_clear_object (&fetch->pixbuf);
+  g_free (fetch);
+}
+
+
+static void
+disk_cache_validation_free (DiskCacheValidation *validation)
+{
+  g_free (validation->cache_dir);
+  g_free (validation->theme_name);
+  g_strfreev (validation->search_path);
+  g_free (validation);
+}
+
+
+static void
+icon_preload_free (IconPreload *preload)
+{
+  g_clear_object (&preload->icon);
+  g_free (preload);
+}
+
+
+static gint64
+get_mtime (const char *path)
+{
+  GStatBuf st;
+
+  if (g_stat (path, &st) != 0)
+    return 0;
+
+  return st.st_mtime;
+}
+
+
+/*
+ * The icon theme caches get updated whenever icons get installed or
+ * removed. Directory mtimes catch icons added to themes without a
+ * cache and to flat icon directories like /usr/share/pixmaps.
+ */
+static char *
+get_theme_stamp (DiskCacheValidation *validation)
+{
+  const char *themes[] = { validation->theme_name, "hicolor", NULL };
+  GStrv search_path = validation->search_path;
+  gint64 mtime = 0;
+
+  for (int i = 0; search_path && search_path[i]; i++) {
+    mtime = MAX (mtime, get_mtime (search_path[i]));
+
+    for (int j = 0; themes[j]; j++) {
+      g_autofree char *path = g_build_filename (search_path[i], themes[j], NULL);
+      g_autofree char *cache = g_build_filename (path, "icon-theme.cache", NULL);
+
+      mtime = MAX (mtime, get_mtime (path));
+      mtime = MAX (mtime, get_mtime (cache));
+    }
+  }
+
+  return g_strdup_printf ("%s:%" G_GINT64_FORMAT, themes[0], mtime);
+}
+
+
+static char *
+get_icon_key (GIcon *icon, int size, int scale)
+{
+  g_autofree char *icon_str = g_icon_to_string (icon);
+
+  /* Icons that can't be serialized, e.g. loadable ones, don't get cached */
+  if (icon_str == NULL)
+    return NULL;
+
+  return g_strdup_printf ("%s@%d@%d", icon_str, size, scale);
+}
+
+
+/*
+ * Icons backed by a file get stored on disk keyed on the file's mtime
+ * so updates get picked up. Called from the worker thread as it needs
+ * to stat the file.
+ */
+static char *
+get_disk_cache_path (const char *cache_dir, const char *key, GIcon *icon)
+{
+  g_autofree char *checksum = NULL;
+  g_autofree char *filename = NULL;
+  g_autofree char *disk_key = NULL;
+  gint64 mtime = 0;
+
+  if (G_IS_FILE_ICON (icon)) {
+    g_autofree char *path = g_file_get_path (g_file_icon_get_file (G_FILE_ICON (icon)));
+
+    if (path)
+      mtime = get_mtime (path);
+  }
+
+  disk_key = g_strdup_printf ("%s@%" G_GINT64_FORMAT, key, mtime);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, disk_key, -1);
+  filename = g_strdup_printf ("%s.png", checksum);
+
+  return g_build_filename (cache_dir, filename, NULL);
+}
+
+
+static cairo_surface_t *
+get_placeholder (PhoshAppIconCache *self, int size, int scale)
+{
+  g_autofree char *key = g_strdup_printf ("%d@%d", size, scale);
+  cairo_surface_t *surface;
+
+  surface = g_hash_table_lookup (self->placeholders, key);
+  if (surface == NULL) {
+    /* A new image surface is fully transparent */
+    surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size * scale, size * scale);
+    cairo_surface_set_device_scale (surface, scale, scale);
+    g_hash_table_insert (self->placeholders, g_steal_pointer (&key), surface);
+  }
+
+  return surface;
+}
+
+
+static void
+remove_dir (const char *dirname)
+{
+  g_autoptr (GDir) dir = NULL;
+  const char *name;
+
+  dir = g_dir_open (dirname, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir))) {
+    g_autofree char *path = g_build_filename (dirname, name, NULL);
+
+    g_unlink (path);
+  }
+  g_rmdir (dirname);
+}
+
+
+static void
+complete_fetch (PhoshAppIconCache *self, const char *key, cairo_surface_t *surface)
+{
+  g_autoptr (GPtrArray) images = NULL;
+
+  images = g_hash_table_lookup (self->pending, key);
+  if (images == NULL)
+    return;
+
+  g_ptr_array_ref (images);
+  g_hash_table_remove (self->pending, key);
+
+  for (guint i = 0; i < images->len; i++) {
+    GtkImage *image = g_ptr_array_index (images, i);
+
+    /* The image might show a different icon by now */
+    if (g_strcmp0 (g_object_get_data (G_OBJECT (image), ICON_KEY_DATA), key) != 0)
+      continue;
+
+    if (surface)
+      gtk_image_set_from_surface (image, surface);
+    else
+      gtk_image_set_from_icon_name (image, PHOSH_APP_UNKNOWN_ICON, GTK_ICON_SIZE_DIALOG);
+  }
+}
+
+
+static void
+add_pixbuf (PhoshAppIconCache *self, IconFetch *fetch, GdkPixbuf *pixbuf)
+{
+  cairo_surface_t *surface;
+
+  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, fetch->scale, NULL);
+  g_hash_table_insert (self->surfaces, g_strdup (fetch->key), surface);
+
+  complete_fetch (self, fetch->key, surface);
+}
+
+
+static void
+save_to_disk_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancel)
+{
+  IconFetch *fetch = task_data;
+  g_autofree char *tmp_path = g_strdup_printf ("%s.tmp", fetch->path);
+  g_autoptr (GError) err = NULL;
+
+  if (!gdk_pixbuf_save (fetch->pixbuf, tmp_path, "png", &err, NULL)) {
+    g_task_return_error (task, g_steal_pointer (&err));
+    return;
+  }
+
+  if (g_rename (tmp_path, fetch->path) != 0) {
+    g_unlink (tmp_path);
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "Failed to rename %s", tmp_path);
+    return;
+  }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+static void
+on_saved_to_disk (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GError) err = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (res), &err))
+    g_debug ("Failed to store icon: %s", err->message);
+}
+
+
+static void
+on_icon_rendered (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  IconFetch *fetch = user_data;
+  PhoshAppIconCache *self = fetch->self;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GTask) task = NULL;
+
+  pixbuf = gtk_icon_info_load_icon_finish (GTK_ICON_INFO (source_object), res, &err);
+  if (pixbuf == NULL) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+      g_debug ("Failed to render icon %s: %s", fetch->key, err->message);
+      complete_fetch (self, fetch->key, NULL);
+    }
+    icon_fetch_free (fetch);
+    return;
+  }
+
+  add_pixbuf (self, fetch, pixbuf);
+
+  /* Store on disk for the next session, the task takes over the fetch */
+  fetch->pixbuf = g_steal_pointer (&pixbuf);
+  task = g_task_new (self, self->cancel, on_saved_to_disk, NULL);
+  g_task_set_task_data (task, fetch, (GDestroyNotify) icon_fetch_free);
+  g_task_run_in_thread (task, save_to_disk_thread);
+}
+
+
+static void
+render_icon (PhoshAppIconCache *self, IconFetch *fetch)
+{
+  g_autoptr (GtkIconInfo) info = NULL;
+
+  info = gtk_icon_theme_lookup_by_gicon_for_scale (self->icon_theme,
+                                                   fetch->icon,
+                                                   fetch->size,
+                                                   fetch->scale,
+                                                   GTK_ICON_LOOKUP_FORCE_SIZE);
+  if (info == NULL) {
+    g_debug ("No icon for %s", fetch->key);
+    complete_fetch (self, fetch->key, NULL);
+    icon_fetch_free (fetch);
+    return;
+  }
+
+  /* Rendering happens in a thread */
+  gtk_icon_info_load_icon_async (info, self->cancel, on_icon_rendered, fetch);
+}
+
+
+static void
+load_from_disk_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancel)
+{
+  IconFetch *fetch = task_data;
+  GdkPixbuf *pixbuf;
+
+  fetch->path = get_disk_cache_path (fetch->self->cache_dir, fetch->key, fetch->icon);
+  if (!g_file_test (fetch->path, G_FILE_TEST_IS_REGULAR)) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  pixbuf = gdk_pixbuf_new_from_file (fetch->path, NULL);
+  g_task_return_pointer (task, pixbuf, g_object_unref);
+}
+
+
+static void
+on_loaded_from_disk (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (source_object);
+  IconFetch *fetch = user_data;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+
+  pixbuf = g_task_propagate_pointer (G_TASK (res), &err);
+  if (err) {
+    icon_fetch_free (fetch);
+    return;
+  }
+
+  if (pixbuf) {
+    add_pixbuf (self, fetch, pixbuf);
+    icon_fetch_free (fetch);
+    return;
+  }
+
+  /* Not on disk yet, render the icon */
+  render_icon (self, fetch);
+}
+
+
+static void
+fetch_from_disk (PhoshAppIconCache *self, IconFetch *fetch)
+{
+  g_autoptr (GTask) task = NULL;
+
+  if (self->validating) {
+    g_queue_push_tail (&self->deferred_fetches, fetch);
+    return;
+  }
+
+  /* The callback takes over the fetch */
+  task = g_task_new (self, self->cancel, on_loaded_from_disk, fetch);
+  g_task_set_task_data (task, fetch, NULL);
+  g_task_run_in_thread (task, load_from_disk_thread);
+}
+
+
+static void
+fetch_icon (PhoshAppIconCache *self,
+            const char        *key,
+            GIcon             *icon,
+            int                size,
+            int                scale,
+            GtkImage          *image)
+{
+  GPtrArray *images;
+  IconFetch *fetch;
+
+  images = g_hash_table_lookup (self->pending, key);
+  if (images) {
+    if (image)
+      g_ptr_array_add (images, g_object_ref (image));
+    return;
+  }
+
+  images = g_ptr_array_new_with_free_func (g_object_unref);
+  if (image)
+    g_ptr_array_add (images, g_object_ref (image));
+  g_hash_table_insert (self->pending, g_strdup (key), images);
+
+  fetch = g_new0 (IconFetch, 1);
+  fetch->self = g_object_ref (self);
+  fetch->key = g_strdup (key);
+  fetch->icon = g_object_ref (icon);
+  fetch->size = size;
+  fetch->scale = scale;
+
+  fetch_from_disk (self, fetch);
+}
+
+
+/* Drop the on disk cache in case the icon theme changed since it was written */
+static void
+validate_disk_cache_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancel)
+{
+  DiskCacheValidation *validation = task_data;
+  g_autofree char *stamp = get_theme_stamp (validation);
+  g_autofree char *stamp_path = g_build_filename (validation->cache_dir, "stamp", NULL);
+  g_autofree char *old_stamp = NULL;
+  g_autofree char *stale_dir = NULL;
+  g_autoptr (GError) err = NULL;
+
+  if (g_file_get_contents (stamp_path, &old_stamp, NULL, NULL) &&
+      g_strcmp0 (old_stamp, stamp) == 0) {
+    g_task_return_boolean (task, TRUE);
+    return;
+  }
+
+  g_debug ("Icon theme changed (%s), dropping on disk icon cache", stamp);
+
+  if (g_file_test (validation->cache_dir, G_FILE_TEST_IS_DIR)) {
+    stale_dir = g_strdup_printf ("%s.stale-%" G_GINT64_FORMAT,
+                                 validation->cache_dir, g_get_real_time ());
+
+    if (g_rename (validation->cache_dir, stale_dir) != 0)
+      g_clear_pointer (&stale_dir, g_free);
+  }
+
+  if (g_mkdir_with_parents (validation->cache_dir, 0700) != 0) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_FAILED,
+                             "Failed to create icon cache dir %s", validation->cache_dir);
+  } else if (!g_file_set_contents (stamp_path, stamp, -1, &err)) {
+    g_task_return_error (task, g_steal_pointer (&err));
+  } else {
+    g_task_return_boolean (task, TRUE);
+  }
+
+  /* Loads from disk don't need to wait for the old files to go away */
+  if (stale_dir)
+    remove_dir (stale_dir);
+}
+
+
+static void validate_disk_cache (PhoshAppIconCache *self);
+
+
+static void
+on_disk_cache_validated (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (source_object);
+  g_autoptr (GError) err = NULL;
+  IconFetch *fetch;
+
+  if (!g_task_propagate_boolean (G_TASK (res), &err))
+    g_warning ("Failed to validate icon cache: %s", err->message);
+
+  self->validating = FALSE;
+  if (self->revalidate) {
+    validate_disk_cache (self);
+    return;
+  }
+
+  while ((fetch = g_queue_pop_head (&self->deferred_fetches)))
+    fetch_from_disk (self, fetch);
+}
+
+
+static void
+validate_disk_cache (PhoshAppIconCache *self)
+{
+  g_autoptr (GTask) task = NULL;
+  DiskCacheValidation *validation;
+
+  /* Only one validation at a time as they move the cache around */
+  if (self->validating) {
+    self->revalidate = TRUE;
+    return;
+  }
+  self->validating = TRUE;
+  self->revalidate = FALSE;
+
+  validation = g_new0 (DiskCacheValidation, 1);
+  validation->cache_dir = g_strdup (self->cache_dir);
+  g_object_get (gtk_settings_get_default (), "gtk-icon-theme-name", &validation->theme_name, NULL);
+  if (validation->theme_name == NULL)
+    validation->theme_name = g_strdup ("hicolor");
+  gtk_icon_theme_get_search_path (self->icon_theme, &validation->search_path, NULL);
+
+  task = g_task_new (self, NULL, on_disk_cache_validated, NULL);
+  g_task_set_task_data (task, validation, (GDestroyNotify) disk_cache_validation_free);
+  g_task_run_in_thread (task, validate_disk_cache_thread);
+}
+
+
+static void
+on_icon_theme_changed (PhoshAppIconCache *self)
+{
+  g_autoptr (GList) images = NULL;
+
+  validate_disk_cache (self);
+  phosh_app_icon_cache_clear_all (self);
+
+  /* Renders in flight use the old theme */
+  g_cancellable_cancel (self->cancel);
+  g_object_unref (self->cancel);
+  self->cancel = g_cancellable_new ();
+  g_queue_clear_full (&self->deferred_fetches, (GDestroyNotify) icon_fetch_free);
+  g_hash_table_remove_all (self->pending);
+
+  /* Render the icons on screen again from the new theme */
+  images = g_hash_table_get_keys (self->images);
+  for (GList *l = images; l; l = l->next) {
+    GtkImage *image = l->data;
+    GIcon *icon = g_object_get_data (G_OBJECT (image), ICON_DATA);
+    int size = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (image), ICON_SIZE_DATA));
+
+    g_object_set_data (G_OBJECT (image), ICON_KEY_DATA, NULL);
+    phosh_app_icon_cache_set_image (self, image, icon, size);
+  }
+}
+
+
+static void
+on_image_destroy (PhoshAppIconCache *self, GtkImage *image)
+{
+  g_hash_table_remove (self->images, image);
+}
+
+
+static gboolean
+on_preload_idle (gpointer data)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (data);
+
+  for (int i = 0; i < PRELOAD_BATCH; i++) {
+    IconPreload *preload = g_queue_pop_head (&self->preload);
+    g_autofree char *key = NULL;
+
+    if (preload == NULL)
+      break;
+
+    key = get_icon_key (preload->icon, preload->size, preload->scale);
+    if (key &&
+        !g_hash_table_contains (self->surfaces, key) &&
+        !g_hash_table_contains (self->pending, key)) {
+      fetch_icon (self, key, preload->icon, preload->size, preload->scale, NULL);
+    }
+    icon_preload_free (preload);
+  }
+
+  if (!g_queue_is_empty (&self->preload))
+    return G_SOURCE_CONTINUE;
+
+  self->preload_id = 0;
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+on_image_scale_factor_changed (GtkImage *image)
+{
+  GIcon *icon = g_object_get_data (G_OBJECT (image), ICON_DATA);
+  int size = GPOINTER_TO_INT (g_object_get_data (G_OBJECT (image), ICON_SIZE_DATA));
+
+  if (icon == NULL)
+    return;
+
+  phosh_app_icon_cache_set_image (phosh_app_icon_cache_get_default (), image, icon, size);
+}
+
+
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (owner);
+  GHashTableIter iter;
+  cairo_surface_t *surface;
+
+  g_hash_table_iter_init (&iter, self->surfaces);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&surface)) {
+    if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE) {
+      report->bytes += (guint64) cairo_image_surface_get_stride (surface) *
+        cairo_image_surface_get_height (surface);
+    }
+    report->objects++;
+  }
+}
+
+
+static gboolean
+is_unused (gpointer key, gpointer value, gpointer user_data)
+{
+  /* Only the cache holds a reference, no image shows it */
+  return cairo_surface_get_reference_count (value) == 1;
+}
+
+
+static void
+evict_memory (GObject *owner, PhoshMemoryPressure pressure)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (owner);
+  guint n_removed;
+
+  if (pressure >= PHOSH_MEMORY_PRESSURE_MEDIUM) {
+    phosh_app_icon_cache_clear_all (self);
+    return;
+  }
+
+  n_removed = g_hash_table_foreach_remove (self->surfaces, is_unused, NULL);
+  g_debug ("Dropped %u unused app icons", n_removed);
+}
+
+
+static void
+phosh_app_icon_cache_dispose (GObject *object)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (object);
+
+  g_cancellable_cancel (self->cancel);
+  g_clear_object (&self->cancel);
+  g_clear_handle_id (&self->preload_id, g_source_remove);
+  g_queue_clear_full (&self->preload, (GDestroyNotify) icon_preload_free);
+  g_queue_clear_full (&self->deferred_fetches, (GDestroyNotify) icon_fetch_free);
+
+  if (self->icon_theme)
+    g_signal_handlers_disconnect_by_data (self->icon_theme, self);
+  g_clear_object (&self->icon_theme);
+
+  G_OBJECT_CLASS (phosh_app_icon_cache_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_app_icon_cache_finalize (GObject *object)
+{
+  PhoshAppIconCache *self = PHOSH_APP_ICON_CACHE (object);
+
+  g_clear_pointer (&self->surfaces, g_hash_table_destroy);
+  g_clear_pointer (&self->pending, g_hash_table_destroy);
+  g_clear_pointer (&self->placeholders, g_hash_table_destroy);
+  g_clear_pointer (&self->images, g_hash_table_destroy);
+  g_clear_pointer (&self->cache_dir, g_free);
+
+  G_OBJECT_CLASS (phosh_app_icon_cache_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_app_icon_cache_class_init (PhoshAppIconCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = phosh_app_icon_cache_dispose;
+  object_class->finalize = phosh_app_icon_cache_finalize;
+}
+
+
+static void
+phosh_app_icon_cache_init (PhoshAppIconCache *self)
+{
+  self->surfaces = g_hash_table_new_full (g_str_hash,
+                                          g_str_equal,
+                                          g_free,
+                                          (GDestroyNotify) cairo_surface_destroy);
+  self->pending = g_hash_table_new_full (g_str_hash,
+                                         g_str_equal,
+                                         g_free,
+                                         (GDestroyNotify) g_ptr_array_unref);
+  self->placeholders = g_hash_table_new_full (g_str_hash,
+                                              g_str_equal,
+                                              g_free,
+                                              (GDestroyNotify) cairo_surface_destroy);
+  self->images = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->cancel = g_cancellable_new ();
+  self->cache_dir = g_build_filename (g_get_user_cache_dir (), "phosh", "app-icons", NULL);
+
+  self->icon_theme = g_object_ref (gtk_icon_theme_get_default ());
+  g_signal_connect_object (self->icon_theme,
+                           "changed",
+                           G_CALLBACK (on_icon_theme_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  validate_disk_cache (self);
+
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "app-icon-cache",
+                                        G_OBJECT (self),
+                                        report_memory,
+                                        evict_memory);
+}
+
+/**
+ * phosh_app_icon_cache_get_default:
+ *
+ * Gets the app icon cache singleton.
+ *
+ * Returns:(transfer none): The app icon cache singleton.
+ */
+PhoshAppIconCache *
+phosh_app_icon_cache_get_default (void)
+{
+  static PhoshAppIconCache *instance;
+
+  if (instance == NULL) {
+    g_debug ("Creating app icon cache");
+    instance = g_object_new (PHOSH_TYPE_APP_ICON_CACHE, NULL);
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+  return instance;
+}
+
+/**
+ * phosh_app_icon_cache_get_app_icon:
+ * @info: The app
+ *
+ * Gets the icon to show for an app. Themed icons fall back to
+ * `PHOSH_APP_UNKNOWN_ICON`.
+ *
+ * Returns:(transfer none)(nullable): The app's icon
+ */
+GIcon *
+phosh_app_icon_cache_get_app_icon (GAppInfo *info)
+{
+  GIcon *icon;
+
+  g_return_val_if_fail (G_IS_APP_INFO (info), NULL);
+
+  icon = g_app_info_get_icon (info);
+  if (icon && G_IS_THEMED_ICON (icon) &&
+      !g_strv_contains (g_themed_icon_get_names (G_THEMED_ICON (icon)), PHOSH_APP_UNKNOWN_ICON)) {
+    g_themed_icon_append_name (G_THEMED_ICON (icon), PHOSH_APP_UNKNOWN_ICON);
+  }
+
+  return icon;
+}
+
+/**
+ * phosh_app_icon_cache_set_image:
+ * @self: The app icon cache
+ * @image: The image to show the icon in
+ * @icon: (nullable): The icon to show
+ * @pixel_size: The icon's size in application pixels
+ *
+ * Shows the given icon in @image using a pre-rendered surface for the
+ * image's scale factor. If the icon wasn't rendered yet, the image
+ * shows a blank placeholder and is updated once rendering finished.
+ */
+void
+phosh_app_icon_cache_set_image (PhoshAppIconCache *self,
+                                GtkImage          *image,
+                                GIcon             *icon,
+                                int                pixel_size)
+{
+  g_autofree char *key = NULL;
+  cairo_surface_t *surface;
+  int scale;
+
+  g_return_if_fail (PHOSH_IS_APP_ICON_CACHE (self));
+  g_return_if_fail (GTK_IS_IMAGE (image));
+  g_return_if_fail (icon == NULL || G_IS_ICON (icon));
+
+  if (g_object_get_data (G_OBJECT (image), ICON_SIZE_DATA) == NULL) {
+    g_signal_connect (image,
+                      "notify::scale-factor",
+                      G_CALLBACK (on_image_scale_factor_changed),
+                      NULL);
+    g_signal_connect_object (image,
+                             "destroy",
+                             G_CALLBACK (on_image_destroy),
+                             self,
+                             G_CONNECT_SWAPPED);
+    g_hash_table_add (self->images, image);
+  }
+  g_object_set_data (G_OBJECT (image), ICON_SIZE_DATA, GINT_TO_POINTER (pixel_size));
+
+  if (icon == NULL) {
+    g_object_set_data (G_OBJECT (image), ICON_DATA, NULL);
+    g_object_set_data (G_OBJECT (image), ICON_KEY_DATA, NULL);
+    gtk_image_set_from_icon_name (image, PHOSH_APP_UNKNOWN_ICON, GTK_ICON_SIZE_DIALOG);
+    return;
+  }
+  g_object_set_data_full (G_OBJECT (image), ICON_DATA, g_object_ref (icon), g_object_unref);
+
+  scale = gtk_widget_get_scale_factor (GTK_WIDGET (image));
+  key = get_icon_key (icon, pixel_size, scale);
+  if (key == NULL) {
+    g_object_set_data (G_OBJECT (image), ICON_KEY_DATA, NULL);
+    gtk_image_set_from_gicon (image, icon, GTK_ICON_SIZE_DIALOG);
+    return;
+  }
+
+  surface = g_hash_table_lookup (self->surfaces, key);
+  if (surface) {
+    if (g_strcmp0 (g_object_get_data (G_OBJECT (image), ICON_KEY_DATA), key) == 0 &&
+        gtk_image_get_storage_type (image) == GTK_IMAGE_SURFACE)
+      return;
+
+    g_object_set_data_full (G_OBJECT (image), ICON_KEY_DATA, g_steal_pointer (&key), g_free);
+    gtk_image_set_from_surface (image, surface);
+    return;
+  }
+
+  g_object_set_data_full (G_OBJECT (image), ICON_KEY_DATA, g_strdup (key), g_free);
+  /* Keep the layout stable until the pre-rendered icon is ready */
+  gtk_image_set_from_surface (image, get_placeholder (self, pixel_size, scale));
+  fetch_icon (self, key, icon, pixel_size, scale, image);
+}
+
+/**
+ * phosh_app_icon_cache_preload:
+ * @self: The app icon cache
+ * @apps: A list model of `GAppInfo`s
+ * @pixel_size: The icons' size in application pixels
+ * @scale: The scale factor to render for
+ *
+ * Renders the icons of the given apps in the background so they can be
+ * shown right away once needed. Items that aren't apps are skipped.
+ */
+void
+phosh_app_icon_cache_preload (PhoshAppIconCache *self,
+                              GListModel        *apps,
+                              int                pixel_size,
+                              int                scale)
+{
+  guint n_items;
+
+  g_return_if_fail (PHOSH_IS_APP_ICON_CACHE (self));
+  g_return_if_fail (G_IS_LIST_MODEL (apps));
+
+  n_items = g_list_model_get_n_items (apps);
+  for (guint i = 0; i < n_items; i++) {
+    g_autoptr (GObject) item = g_list_model_get_item (apps, i);
+    IconPreload *preload;
+    GIcon *icon;
+
+    if (!G_IS_APP_INFO (item))
+      continue;
+
+    icon = phosh_app_icon_cache_get_app_icon (G_APP_INFO (item));
+    if (icon == NULL)
+      continue;
+
+    preload = g_new0 (IconPreload, 1);
+    preload->icon = g_object_ref (icon);
+    preload->size = pixel_size;
+    preload->scale = scale;
+    g_queue_push_tail (&self->preload, preload);
+  }
+
+  if (self->preload_id || g_queue_is_empty (&self->preload))
+    return;
+
+  self->preload_id = g_idle_add_full (G_PRIORITY_LOW, on_preload_idle, self, NULL);
+  g_source_set_name_by_id (self->preload_id, "[phosh] preload app icons");
+}
+
+/**
+ * phosh_app_icon_cache_clear_all:
+ * @self: The app icon cache
+ *
+ * Drops all rendered icons from memory. The on disk cache is kept.
+ */
+void
+phosh_app_icon_cache_clear_all (PhoshAppIconCache *self)
+{
+  g_return_if_fail (PHOSH_IS_APP_ICON_CACHE (self));
+
+  g_debug ("Clearing app icon cache");
+  g_hash_table_remove_all (self->surfaces);
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_APP_ICON_CACHE (phosh_app_icon_cache_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshAppIconCache, phosh_app_icon_cache, PHOSH, APP_ICON_CACHE, GObject)
+
+PhoshAppIconCache *phosh_app_icon_cache_get_default (void);
+void               phosh_app_icon_cache_set_image   (PhoshAppIconCache *self,
+                                                     GtkImage          *image,
+                                                     GIcon             *icon,
+                                                     int                pixel_size);
+void               phosh_app_icon_cache_preload     (PhoshAppIconCache *self,
+                                                     GListModel        *apps,
+                                                     int                pixel_size,
+                                                     int                scale);
+void               phosh_app_icon_cache_clear_all   (PhoshAppIconCache *self);
+GIcon             *phosh_app_icon_cache_get_app_icon (GAppInfo *info);
+
+G_END_DECLS
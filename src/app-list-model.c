@@ -13,6 +13,7 @@
 
 #include "app-list-model.h"
 #include "folder-info.h"
+#include "memory-accounting.h"
 
 #include <gio/gio.h>
 
@@ -235,6 +236,23 @@ on_folder_children_changed (PhoshAppListModel *self)
   /* A folder has been created or destroyed or modified.
    * Rearrange the apps from scratch. */
   on_monitor_changed_cb (priv->monitor, self);
+
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "app-list-model",
+                                        G_OBJECT (self),
+                                        report_memory,
+                                        NULL);
+}
+
+
+/* We can't tell how much memory a GAppInfo holds so only report the number of apps */
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshAppListModelPrivate *priv;
+
+  priv = phosh_app_list_model_get_instance_private (PHOSH_APP_LIST_MODEL (owner));
+  report->objects += g_sequence_get_length (priv->items);
 }
 
 
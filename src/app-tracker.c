@@ -16,6 +16,7 @@
 #include "toplevel-manager.h"
 #include "phosh-marshalers.h"
 #include "util.h"
+#include "wakeup-scheduler.h"
 
 #define GNOME_DESKTOP_USE_UNSTABLE_API
 #include <libgnome-desktop/gnome-systemd.h>
@@ -145,8 +146,12 @@ phosh_app_state_new (GDesktopAppInfo    *info,
   state->state = flags;
   state->info = g_object_ref (info);
   state->tracker = tracker;
-  state->timeout_id = g_timeout_add_seconds (STARTUP_TIMEOUT, on_startup_timeout, state);
-  g_source_set_name_by_id (state->timeout_id, "[phosh] state timeout");
+  state->timeout_id = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                                  "[phosh] state timeout",
+                                                  STARTUP_TIMEOUT,
+                                                  PHOSH_WAKEUP_FLAG_NONE,
+                                                  on_startup_timeout,
+                                                  state);
 
   g_debug ("Pid %" G_GINT64_FORMAT ", '%s', startup-id: %s got state %d",
            state->pid,
@@ -698,6 +703,20 @@ phosh_app_tracker_launch_app_info (PhoshAppTracker *self, GAppInfo *info)
   app_id = phosh_strip_suffix_from_app_id (g_app_info_get_id (G_APP_INFO (info)));
   g_debug ("Launching '%s'", app_id);
 
+  /* Most apps use their desktop file's name as app-id */
+  if (app_id) {
+    g_autoptr (GPtrArray) toplevels = NULL;
+
+    toplevels = phosh_toplevel_manager_get_toplevels_for_app_id (toplevel_manager, app_id);
+    if (toplevels->len) {
+      phosh_toplevel_activate (g_ptr_array_index (toplevels, 0),
+                               phosh_wayland_get_wl_seat (phosh_wayland_get_default ()));
+      g_signal_emit (self, signals[APP_ACTIVATED], 0, info);
+      return;
+    }
+  }
+
+  /* Others need a lookup */
   for (guint i=0; i < phosh_toplevel_manager_get_num_toplevels (toplevel_manager); i++) {
     PhoshToplevel *toplevel = phosh_toplevel_manager_get_toplevel (toplevel_manager, i);
     const char *window_id = phosh_toplevel_get_app_id (toplevel);
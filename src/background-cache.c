@@ -12,6 +12,7 @@
 
 #include "background-cache.h"
 #include "background-image.h"
+#include "memory-accounting.h"
 #include "util.h"
 
 #include <gio/gio.h>
@@ -58,6 +59,34 @@ on_background_image_loaded (GObject *source_object, GAsyncResult *res, gpointer
 }
 
 
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshBackgroundCache *self = PHOSH_BACKGROUND_CACHE (owner);
+  GHashTableIter iter;
+  PhoshBackgroundImage *image;
+
+  g_hash_table_iter_init (&iter, self->background_images);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&image)) {
+    GdkPixbuf *pixbuf = phosh_background_image_get_pixbuf (image);
+
+    if (pixbuf)
+      report->bytes += gdk_pixbuf_get_byte_length (pixbuf);
+    report->objects++;
+  }
+}
+
+
+static void
+evict_memory (GObject *owner, PhoshMemoryPressure pressure)
+{
+  /* Backgrounds only keep their scaled copy and refetch the full
+   * resolution image when they need to rescale so the cache holds
+   * the only reference */
+  phosh_background_cache_clear_all (PHOSH_BACKGROUND_CACHE (owner));
+}
+
+
 static void
 phosh_background_cache_finalize (GObject *object)
 {
@@ -101,6 +130,12 @@ phosh_background_cache_init (PhoshBackgroundCache *self)
                                                    (GEqualFunc) g_file_equal,
                                                    g_object_unref,
                                                    g_object_unref);
+
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "background-cache",
+                                        G_OBJECT (self),
+                                        report_memory,
+                                        evict_memory);
 }
 
 /**
@@ -56,9 +56,8 @@ struct _PhoshBackground
 {
   PhoshLayerSurface        parent;
 
-  /* The cached background image */
+  /* The background image, fetched from the cache when rendering */
   GFile                   *uri;
-  PhoshBackgroundImage    *cached_bg_image;
   GCancellable            *cancel_load;
   /* How the background in rendered */
   GDesktopBackgroundStyle  style;
@@ -270,7 +269,7 @@ phosh_background_draw (GtkWidget *widget, cairo_t *cr)
 
 
 static void
-update_image (PhoshBackground *self)
+update_image (PhoshBackground *self, PhoshBackgroundImage *image)
 {
   int width, height;
 
@@ -289,7 +288,7 @@ update_image (PhoshBackground *self)
   g_debug ("Scaling background %p to %dx%d", self, width, height);
 
   g_clear_object (&self->pixbuf);
-  self->pixbuf = image_background (self->cached_bg_image, width, height,
+  self->pixbuf = image_background (image, width, height,
                                    self->style, &self->color);
 
   self->needs_update = FALSE;
@@ -305,8 +304,9 @@ on_background_image_present (PhoshBackground        *self,
   g_assert (PHOSH_IS_BACKGROUND (self));
   g_assert (PHOSH_IS_BACKGROUND_CACHE (cache));
 
-  g_set_object (&self->cached_bg_image, image);
-  update_image (self);
+  /* Only keep the scaled copy, the full resolution image is refetched
+   * from the cache on the next update so it can be evicted */
+  update_image (self, image);
 }
 
 
@@ -332,8 +332,7 @@ trigger_update (PhoshBackground *self)
   if (self->uri) {
     phosh_background_cache_fetch_background (cache, self->uri, self->cancel_load);
   } else {
-    g_clear_object (&self->cached_bg_image);
-    update_image (self);
+    update_image (self, NULL);
   }
 }
 
@@ -358,7 +357,6 @@ phosh_background_finalize (GObject *object)
   g_cancellable_cancel (self->cancel_load);
   g_clear_object (&self->cancel_load);
   g_clear_object (&self->pixbuf);
-  g_clear_object (&self->cached_bg_image);
 
   G_OBJECT_CLASS (phosh_background_parent_class)->finalize (object);
 }
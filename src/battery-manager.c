@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-battery-manager"
+
+#include "phosh-config.h"
+
+#include "battery-manager.h"
+#include "property-coalescer.h"
+#include "util.h"
+#include "dbus/upower-device-dbus.h"
+
+#include <upower.h>
+
+#include <math.h>
+
+#define BUS_NAME "org.freedesktop.UPower"
+#define OBJECT_PATH "/org/freedesktop/UPower/devices/DisplayDevice"
+
+#define BATTERY_MISSING_ICON "battery-missing-symbolic"
+
+/**
+ * PhoshBatteryManager:
+ *
+ * Tracks the battery state via UPower's display device
+ *
+ * The manager is shared by all battery icons so there's a single
+ * connection to upowerd that is set up asynchronously. Property changes
+ * are coalesced via [type@PropertyCoalescer] so consumers get at most
+ * one update per frame.
+ */
+
+enum {
+  PROP_0,
+  PROP_PRESENT,
+  PROP_ICON_NAME,
+  PROP_INFO,
+  PROP_LAST_PROP
+};
+static GParamSpec *props[PROP_LAST_PROP];
+
+struct _PhoshBatteryManager {
+  PhoshManager            parent;
+
+  /* Whether upowerd is around */
+  gboolean                present;
+  char                   *icon_name;
+  char                   *info;
+
+  PhoshPropertyCoalescer *coalescer;
+  PhoshDBusUPowerDevice  *proxy;
+  GCancellable           *cancel;
+};
+G_DEFINE_TYPE (PhoshBatteryManager, phosh_battery_manager, PHOSH_TYPE_MANAGER)
+
+
+static void
+phosh_battery_manager_get_property (GObject    *object,
+                                    guint       property_id,
+                                    GValue     *value,
+                                    GParamSpec *pspec)
+{
+  PhoshBatteryManager *self = PHOSH_BATTERY_MANAGER (object);
+
+  switch (property_id) {
+  case PROP_PRESENT:
+    g_value_set_boolean (value, self->present);
+    break;
+  case PROP_ICON_NAME:
+    g_value_set_string (value, self->icon_name);
+    break;
+  case PROP_INFO:
+    g_value_set_string (value, self->info);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+update_state (PhoshBatteryManager *self)
+{
+  UpDeviceState    state;
+  double           percentage;
+  int              smallest_ten;
+  gboolean         is_charging;
+  gboolean         is_charged;
+  gboolean         present;
+  g_autofree char *icon_name = NULL;
+  g_autofree char *info = NULL;
+  g_autofree char *owner = NULL;
+
+  owner = g_dbus_proxy_get_name_owner (G_DBUS_PROXY (self->proxy));
+  present = !!owner;
+
+  state = phosh_dbus_upower_device_get_state (self->proxy);
+  percentage = phosh_dbus_upower_device_get_percentage (self->proxy);
+
+  is_charging = state == UP_DEVICE_STATE_CHARGING;
+  smallest_ten = floor (percentage / 10.0) * 10;
+  is_charged = state == UP_DEVICE_STATE_FULLY_CHARGED || (is_charging && smallest_ten == 100);
+  info = g_strdup_printf ("%d%%", (int) (percentage + 0.5));
+
+  if (is_charged) {
+    icon_name = g_strdup ("battery-level-100-charged-symbolic");
+  } else {
+    if (is_charging) {
+      icon_name = g_strdup_printf ("battery-level-%d-charging-symbolic", smallest_ten);
+    } else {
+      icon_name = g_strdup_printf ("battery-level-%d-symbolic", smallest_ten);
+    }
+  }
+
+  g_object_freeze_notify (G_OBJECT (self));
+
+  if (g_strcmp0 (self->icon_name, icon_name)) {
+    g_free (self->icon_name);
+    self->icon_name = g_steal_pointer (&icon_name);
+    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_ICON_NAME]);
+  }
+
+  if (g_strcmp0 (self->info, info)) {
+    g_free (self->info);
+    self->info = g_steal_pointer (&info);
+    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_INFO]);
+  }
+
+  if (self->present != present) {
+    self->present = present;
+    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_PRESENT]);
+  }
+
+  g_object_thaw_notify (G_OBJECT (self));
+}
+
+
+static void
+on_name_owner_changed (PhoshBatteryManager *self)
+{
+  phosh_property_coalescer_queue (self->coalescer, G_OBJECT (self->proxy), "g-name-owner");
+}
+
+
+static void
+on_proxy_new_for_bus_finish (GObject             *source_object,
+                             GAsyncResult        *res,
+                             PhoshBatteryManager *self)
+{
+  g_autoptr (GError) err = NULL;
+  PhoshDBusUPowerDevice *proxy;
+
+  proxy = phosh_dbus_upower_device_proxy_new_for_bus_finish (res, &err);
+  if (!proxy) {
+    phosh_async_error_warn (err, "Failed to get upowerd display device proxy");
+    return;
+  }
+
+  g_return_if_fail (PHOSH_IS_BATTERY_MANAGER (self));
+  self->proxy = proxy;
+
+  g_signal_connect_swapped (self->proxy,
+                            "notify::g-name-owner",
+                            G_CALLBACK (on_name_owner_changed),
+                            self);
+  phosh_property_coalescer_watch (self->coalescer, G_DBUS_PROXY (self->proxy));
+
+  update_state (self);
+}
+
+
+static void
+phosh_battery_manager_idle_init (PhoshManager *manager)
+{
+  PhoshBatteryManager *self = PHOSH_BATTERY_MANAGER (manager);
+
+  self->cancel = g_cancellable_new ();
+
+  /* All properties of the display device feed into the same state */
+  self->coalescer = phosh_property_coalescer_new ();
+  g_signal_connect_swapped (self->coalescer, "changed", G_CALLBACK (update_state), self);
+
+  phosh_dbus_upower_device_proxy_new_for_bus (G_BUS_TYPE_SYSTEM,
+                                              G_DBUS_PROXY_FLAGS_GET_INVALIDATED_PROPERTIES,
+                                              BUS_NAME,
+                                              OBJECT_PATH,
+                                              self->cancel,
+                                              (GAsyncReadyCallback) on_proxy_new_for_bus_finish,
+                                              self);
+}
+
+
+static void
+phosh_battery_manager_dispose (GObject *object)
+{
+  PhoshBatteryManager *self = PHOSH_BATTERY_MANAGER (object);
+
+  g_cancellable_cancel (self->cancel);
+  g_clear_object (&self->cancel);
+
+  if (self->coalescer)
+    g_signal_handlers_disconnect_by_data (self->coalescer, self);
+  g_clear_object (&self->coalescer);
+  if (self->proxy)
+    g_signal_handlers_disconnect_by_data (self->proxy, self);
+  g_clear_object (&self->proxy);
+
+  G_OBJECT_CLASS (phosh_battery_manager_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_battery_manager_finalize (GObject *object)
+{
+  PhoshBatteryManager *self = PHOSH_BATTERY_MANAGER (object);
+
+  g_free (self->icon_name);
+  g_free (self->info);
+
+  G_OBJECT_CLASS (phosh_battery_manager_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_battery_manager_class_init (PhoshBatteryManagerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  PhoshManagerClass *manager_class = PHOSH_MANAGER_CLASS (klass);
+
+  object_class->get_property = phosh_battery_manager_get_property;
+  object_class->dispose = phosh_battery_manager_dispose;
+  object_class->finalize = phosh_battery_manager_finalize;
+
+  manager_class->idle_init = phosh_battery_manager_idle_init;
+
+  /**
+   * PhoshBatteryManager:present:
+   *
+   * Whether battery information is present
+   */
+  props[PROP_PRESENT] =
+    g_param_spec_boolean ("present", "", "",
+                          FALSE,
+                          G_PARAM_READABLE |
+                          G_PARAM_EXPLICIT_NOTIFY |
+                          G_PARAM_STATIC_STRINGS);
+  /**
+   * PhoshBatteryManager:icon-name:
+   *
+   * The icon name reflecting the current charge and state
+   */
+  props[PROP_ICON_NAME] =
+    g_param_spec_string ("icon-name", "", "",
+                         BATTERY_MISSING_ICON,
+                         G_PARAM_READABLE |
+                         G_PARAM_EXPLICIT_NOTIFY |
+                         G_PARAM_STATIC_STRINGS);
+  /**
+   * PhoshBatteryManager:info:
+   *
+   * The charge in percent as human readable string
+   */
+  props[PROP_INFO] =
+    g_param_spec_string ("info", "", "",
+                         "0%",
+                         G_PARAM_READABLE |
+                         G_PARAM_EXPLICIT_NOTIFY |
+                         G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+}
+
+
+static void
+phosh_battery_manager_init (PhoshBatteryManager *self)
+{
+  self->icon_name = g_strdup (BATTERY_MISSING_ICON);
+  self->info = g_strdup ("0%");
+}
+
+
+PhoshBatteryManager *
+phosh_battery_manager_new (void)
+{
+  return g_object_new (PHOSH_TYPE_BATTERY_MANAGER, NULL);
+}
+
+
+gboolean
+phosh_battery_manager_get_present (PhoshBatteryManager *self)
+{
+  g_return_val_if_fail (PHOSH_IS_BATTERY_MANAGER (self), FALSE);
+
+  return self->present;
+}
+
+
+const char *
+phosh_battery_manager_get_icon_name (PhoshBatteryManager *self)
+{
+  g_return_val_if_fail (PHOSH_IS_BATTERY_MANAGER (self), NULL);
+
+  return self->icon_name;
+}
+
+
+const char *
+phosh_battery_manager_get_info (PhoshBatteryManager *self)
+{
+  g_return_val_if_fail (PHOSH_IS_BATTERY_MANAGER (self), NULL);
+
+  return self->info;
+}
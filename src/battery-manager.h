@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "manager.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_BATTERY_MANAGER (phosh_battery_manager_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshBatteryManager, phosh_battery_manager, PHOSH, BATTERY_MANAGER, PhoshManager)
+
+PhoshBatteryManager *phosh_battery_manager_new (void);
+gboolean             phosh_battery_manager_get_present (PhoshBatteryManager *self);
+const char          *phosh_battery_manager_get_icon_name (PhoshBatteryManager *self);
+const char          *phosh_battery_manager_get_info (PhoshBatteryManager *self);
+
+G_END_DECLS
@@ -13,15 +13,15 @@
 #include "phosh-config.h"
 
 #include "batteryinfo.h"
-#include "upower.h"
-#include "util.h"
-
-#include <math.h>
+#include "shell.h"
 
 /**
  * PhoshBatteryInfo:
  *
  * A widget to display the battery status
+ *
+ * The battery state is tracked by the shell's #PhoshBatteryManager
+ * which is shared between all battery icons.
  */
 
 enum {
@@ -34,11 +34,10 @@ static GParamSpec *props[PROP_LAST_PROP];
 
 
 typedef struct _PhoshBatteryInfo {
-  PhoshStatusIcon  parent;
-  UpClient        *upower;
-  UpDevice        *device;
-  gboolean         present;
-  gboolean         show_detail;
+  PhoshStatusIcon      parent;
+  PhoshBatteryManager *manager;
+  gboolean             present;
+  gboolean             show_detail;
 } PhoshBatteryInfo;
 
 
@@ -87,56 +86,17 @@ phosh_battery_info_get_property (GObject    *object,
 
 
 static void
-setup_display_device (PhoshBatteryInfo *self)
+on_present_changed (PhoshBatteryInfo    *self,
+                    GParamSpec          *pspec,
+                    PhoshBatteryManager *manager)
 {
-  g_autoptr (GError) err = NULL;
-
-  self->upower = up_client_new_full (NULL, &err);
-  if (self->upower == NULL) {
-    phosh_dbus_service_error_warn (err, "Failed to connect to upowerd");
-    return;
-  }
+  gboolean present = phosh_battery_manager_get_present (manager);
 
-  /* TODO: this is a oversimplified sync call */
-  self->device = up_client_get_display_device (self->upower);
-  if (self->device == NULL) {
-    g_warning ("Failed to get upowerd display device");
+  if (self->present == present)
     return;
-  }
-}
-
 
-static void
-on_property_changed (PhoshBatteryInfo     *self,
-                     GParamSpec           *pspec,
-                     UpDevice             *device)
-{
-  UpDeviceState    state;
-  gdouble          percentage;
-  gint             smallest_ten;
-  gboolean         is_charging;
-  gboolean         is_charged;
-  g_autofree char *icon_name = NULL;
-  g_autofree char *info = NULL;
-
-  g_object_get (device, "state", &state, "percentage", &percentage, NULL);
-
-  is_charging = state == UP_DEVICE_STATE_CHARGING;
-  smallest_ten = floor (percentage / 10.0) * 10;
-  is_charged = state == UP_DEVICE_STATE_FULLY_CHARGED || (is_charging && smallest_ten == 100);
-  info = g_strdup_printf ("%d%%", (int) (percentage + 0.5));
-
-  if (is_charged) {
-    icon_name = g_strdup ("battery-level-100-charged-symbolic");
-  } else {
-    if (is_charging) {
-      icon_name = g_strdup_printf ("battery-level-%d-charging-symbolic", smallest_ten);
-    } else {
-      icon_name = g_strdup_printf ("battery-level-%d-symbolic", smallest_ten);
-    }
-  }
-  phosh_status_icon_set_icon_name (PHOSH_STATUS_ICON (self), icon_name);
-  phosh_status_icon_set_info (PHOSH_STATUS_ICON (self), info);
+  self->present = present;
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_PRESENT]);
 }
 
 
@@ -147,26 +107,22 @@ phosh_battery_info_constructed (GObject *object)
 
   G_OBJECT_CLASS (phosh_battery_info_parent_class)->constructed (object);
 
-  setup_display_device (self);
-  if (self->device) {
-    g_object_connect (self->device,
-                      "swapped_object_signal::notify::percentage",
-                      G_CALLBACK (on_property_changed),
-                      self,
-                      "swapped_object_signal::notify::state",
-                      G_CALLBACK (on_property_changed),
-                      self,
-                      NULL);
-
-    g_object_bind_property (self,
-                            "info",
-                            phosh_status_icon_get_extra_widget (PHOSH_STATUS_ICON (self)),
-                            "label",
-                            G_BINDING_SYNC_CREATE);
-    self->present = TRUE;
-    on_property_changed (self, NULL, self->device);
-    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_PRESENT]);
-  }
+  self->manager = g_object_ref (phosh_shell_get_battery_manager (phosh_shell_get_default ()));
+
+  g_object_bind_property (self->manager, "icon-name", self, "icon-name", G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self->manager, "info", self, "info", G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self,
+                          "info",
+                          phosh_status_icon_get_extra_widget (PHOSH_STATUS_ICON (self)),
+                          "label",
+                          G_BINDING_SYNC_CREATE);
+
+  g_signal_connect_object (self->manager,
+                           "notify::present",
+                           G_CALLBACK (on_present_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  on_present_changed (self, NULL, self->manager);
 }
 
 
@@ -175,8 +131,7 @@ phosh_battery_info_dispose (GObject *object)
 {
   PhoshBatteryInfo *self = PHOSH_BATTERY_INFO (object);
 
-  g_clear_object (&self->device);
-  g_clear_object (&self->upower);
+  g_clear_object (&self->manager);
 
   G_OBJECT_CLASS (phosh_battery_info_parent_class)->dispose (object);
 }
@@ -11,6 +11,7 @@
 #include "phosh-config.h"
 
 #include "connectivity-info.h"
+#include "nm-client-provider.h"
 #include "util.h"
 
 #include <NetworkManager.h>
@@ -117,7 +118,7 @@ on_nm_client_ready (GObject *obj, GAsyncResult *res, PhoshConnectivityInfo *self
   NMClient *nmclient;
   guint id;
 
-  nmclient = nm_client_new_finish (res, &err);
+  nmclient = phosh_nm_client_provider_get_client_finish (PHOSH_NM_CLIENT_PROVIDER (obj), res, &err);
   if (!nmclient) {
     phosh_async_error_warn (err, "Failed to init NM");
     return;
@@ -144,7 +145,10 @@ phosh_connectivity_info_constructed (GObject *object)
   G_OBJECT_CLASS (phosh_connectivity_info_parent_class)->constructed (object);
 
   self->cancel = g_cancellable_new ();
-  nm_client_new_async (self->cancel, (GAsyncReadyCallback)on_nm_client_ready, self);
+  phosh_nm_client_provider_get_client_async (phosh_nm_client_provider_get_default (),
+                                             self->cancel,
+                                             (GAsyncReadyCallback)on_nm_client_ready,
+                                             self);
 }
 
 
@@ -156,7 +160,10 @@ phosh_connectivity_info_dispose (GObject *object)
   g_cancellable_cancel (self->cancel);
   g_clear_object (&self->cancel);
 
-  g_clear_object (&self->nmclient);
+  if (self->nmclient) {
+    g_signal_handlers_disconnect_by_data (self->nmclient, self);
+    g_clear_object (&self->nmclient);
+  }
 
   G_OBJECT_CLASS (phosh_connectivity_info_parent_class)->dispose (object);
 }
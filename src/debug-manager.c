@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-debug-manager"
+
+#include "phosh-config.h"
+
+#include "debug-manager.h"
+#include "frame-profiler.h"
+#include "memory-accounting.h"
+#include "plugin-loader.h"
+#include "shell.h"
+#include "wakeup-scheduler.h"
+
+#include <gio/gio.h>
+
+/**
+ * PhoshDebugManager:
+ *
+ * Provides the sm.puri.Phosh.Debug DBus interface
+ *
+ * The interface allows to inspect the shell's internal state
+ * like the cost of loaded plugins, the frame timings of layer
+ * surfaces, the memory held by caches or the number of timer
+ * wakeups. It's only exported with `PHOSH_DEBUG=debug-interface`
+ * or `PHOSH_DEBUG=frame-profiler`.
+ */
+
+#define DEBUG_DBUS_NAME "sm.puri.Phosh.Debug"
+#define DEBUG_DBUS_PATH "/sm/puri/Phosh/Debug"
+
+static void phosh_debug_manager_debug_iface_init (PhoshDBusDebugIface *iface);
+
+typedef struct _PhoshDebugManager {
+  PhoshDBusDebugSkeleton parent;
+
+  int                    dbus_name_id;
+} PhoshDebugManager;
+
+G_DEFINE_TYPE_WITH_CODE (PhoshDebugManager,
+                         phosh_debug_manager,
+                         PHOSH_DBUS_TYPE_DEBUG_SKELETON,
+                         G_IMPLEMENT_INTERFACE (
+                           PHOSH_DBUS_TYPE_DEBUG,
+                           phosh_debug_manager_debug_iface_init));
+
+
+static gboolean
+handle_get_plugin_stats (PhoshDBusDebug        *object,
+                         GDBusMethodInvocation *invocation)
+{
+  g_debug ("DBus call GetPluginStats");
+
+  phosh_dbus_debug_complete_get_plugin_stats (object,
+                                              invocation,
+                                              phosh_plugin_loader_get_plugin_stats ());
+  return TRUE;
+}
+
+
+static PhoshFrameProfiler *
+get_frame_profiler (GDBusMethodInvocation *invocation)
+{
+  PhoshFrameProfiler *profiler;
+
+  profiler = phosh_shell_get_frame_profiler (phosh_shell_get_default ());
+  if (profiler == NULL) {
+    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                           G_DBUS_ERROR_NOT_SUPPORTED,
+                                           "Frame profiler not enabled");
+  }
+
+  return profiler;
+}
+
+
+static gboolean
+handle_get_frame_stats (PhoshDBusDebug        *object,
+                        GDBusMethodInvocation *invocation)
+{
+  PhoshFrameProfiler *profiler;
+
+  g_debug ("DBus call GetFrameStats");
+
+  profiler = get_frame_profiler (invocation);
+  if (profiler == NULL)
+    return TRUE;
+
+  phosh_dbus_debug_complete_get_frame_stats (object,
+                                             invocation,
+                                             phosh_frame_profiler_get_stats (profiler));
+  return TRUE;
+}
+
+
+static gboolean
+handle_write_frame_trace (PhoshDBusDebug        *object,
+                          GDBusMethodInvocation *invocation,
+                          const char            *filename)
+{
+  g_autoptr (GError) err = NULL;
+  PhoshFrameProfiler *profiler;
+
+  g_debug ("DBus call WriteFrameTrace: %s", filename);
+
+  profiler = get_frame_profiler (invocation);
+  if (profiler == NULL)
+    return TRUE;
+
+  if (!phosh_frame_profiler_write_trace (profiler, filename, &err)) {
+    g_dbus_method_invocation_return_gerror (invocation, err);
+    return TRUE;
+  }
+
+  phosh_dbus_debug_complete_write_frame_trace (object, invocation);
+  return TRUE;
+}
+
+
+static gboolean
+handle_get_memory_stats (PhoshDBusDebug        *object,
+                         GDBusMethodInvocation *invocation)
+{
+  PhoshMemoryAccounting *accounting = phosh_memory_accounting_get_default ();
+
+  g_debug ("DBus call GetMemoryStats");
+
+  phosh_dbus_debug_complete_get_memory_stats (object,
+                                              invocation,
+                                              phosh_memory_accounting_get_stats (accounting));
+  return TRUE;
+}
+
+
+static gboolean
+handle_get_wakeup_stats (PhoshDBusDebug        *object,
+                         GDBusMethodInvocation *invocation)
+{
+  PhoshWakeupScheduler *scheduler = phosh_wakeup_scheduler_get_default ();
+
+  g_debug ("DBus call GetWakeupStats");
+
+  phosh_dbus_debug_complete_get_wakeup_stats (object,
+                                              invocation,
+                                              phosh_wakeup_scheduler_get_stats (scheduler));
+  return TRUE;
+}
+
+
+static void
+phosh_debug_manager_debug_iface_init (PhoshDBusDebugIface *iface)
+{
+  iface->handle_get_plugin_stats = handle_get_plugin_stats;
+  iface->handle_get_frame_stats = handle_get_frame_stats;
+  iface->handle_write_frame_trace = handle_write_frame_trace;
+  iface->handle_get_memory_stats = handle_get_memory_stats;
+  iface->handle_get_wakeup_stats = handle_get_wakeup_stats;
+}
+
+
+static void
+on_name_acquired (GDBusConnection *connection,
+                  const char      *name,
+                  gpointer         user_data)
+{
+  g_debug ("Acquired name %s", name);
+}
+
+
+static void
+on_name_lost (GDBusConnection *connection,
+              const char      *name,
+              gpointer         user_data)
+{
+  g_debug ("Lost or failed to acquire name %s", name);
+}
+
+
+static void
+on_bus_acquired (GDBusConnection *connection,
+                 const char      *name,
+                 gpointer         user_data)
+{
+  PhoshDebugManager *self = user_data;
+  g_autoptr (GError) err = NULL;
+
+  if (!g_dbus_interface_skeleton_export (G_DBUS_INTERFACE_SKELETON (self),
+                                         connection,
+                                         DEBUG_DBUS_PATH,
+                                         &err)) {
+    g_warning ("Failed to export on %s: %s", DEBUG_DBUS_NAME, err->message);
+  }
+}
+
+
+static void
+phosh_debug_manager_dispose (GObject *object)
+{
+  PhoshDebugManager *self = PHOSH_DEBUG_MANAGER (object);
+
+  if (g_dbus_interface_skeleton_get_object_path (G_DBUS_INTERFACE_SKELETON (self)))
+    g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (self));
+
+  g_clear_handle_id (&self->dbus_name_id, g_bus_unown_name);
+
+  G_OBJECT_CLASS (phosh_debug_manager_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_debug_manager_constructed (GObject *object)
+{
+  PhoshDebugManager *self = PHOSH_DEBUG_MANAGER (object);
+
+  G_OBJECT_CLASS (phosh_debug_manager_parent_class)->constructed (object);
+
+  self->dbus_name_id = g_bus_own_name (G_BUS_TYPE_SESSION,
+                                       DEBUG_DBUS_NAME,
+                                       G_BUS_NAME_OWNER_FLAGS_ALLOW_REPLACEMENT |
+                                       G_BUS_NAME_OWNER_FLAGS_REPLACE,
+                                       on_bus_acquired,
+                                       on_name_acquired,
+                                       on_name_lost,
+                                       self,
+                                       NULL);
+}
+
+
+static void
+phosh_debug_manager_class_init (PhoshDebugManagerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->constructed = phosh_debug_manager_constructed;
+  object_class->dispose = phosh_debug_manager_dispose;
+}
+
+
+static void
+phosh_debug_manager_init (PhoshDebugManager *self)
+{
+}
+
+
+PhoshDebugManager *
+phosh_debug_manager_new (void)
+{
+  return g_object_new (PHOSH_TYPE_DEBUG_MANAGER, NULL);
+}
@@ -0,0 +1,22 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include "dbus/phosh-debug-dbus.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_DEBUG_MANAGER (phosh_debug_manager_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshDebugManager, phosh_debug_manager, PHOSH, DEBUG_MANAGER,
+                      PhoshDBusDebugSkeleton)
+
+PhoshDebugManager *phosh_debug_manager_new (void);
+
+G_END_DECLS
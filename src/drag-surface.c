@@ -23,6 +23,12 @@
  * See #PhoshTopPanel for a usage example. Note that you need to
  * update folded/unfolded margins on the #PhoshLayerSurface's
  * `configured` event to adjust it to the proper sizes.
+ *
+ * The compositor can send drag events way more often than we draw
+ * frames so `dragged` is emitted at most once per frame with the most
+ * recent margin. The compositor moves the surface itself, so handlers
+ * of `dragged` should only do cheap updates like redraws and leave
+ * layout changes to `drag-state` changes.
  */
 
 enum {
@@ -58,6 +64,11 @@ typedef struct _PhoshDragSurfacePrivate {
   PhoshDragSurfaceDragMode                 drag_mode;
   guint                                    drag_handle;
   guint                                    exclusive;
+
+  /* Coalescing of drag events */
+  guint                                    drag_tick_id;
+  gboolean                                 drag_pending;
+  int                                      margin;
 } PhoshDragSurfacePrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhoshDragSurface, phosh_drag_surface, PHOSH_TYPE_LAYER_SURFACE)
@@ -139,6 +150,49 @@ phosh_drag_surface_get_property (GObject    *object,
 }
 
 
+static void
+emit_dragged (PhoshDragSurface *self)
+{
+  PhoshDragSurfacePrivate *priv = phosh_drag_surface_get_instance_private (self);
+
+  if (!priv->drag_pending)
+    return;
+
+  priv->drag_pending = FALSE;
+  g_signal_emit (self, signals[SIGNAL_DRAGGED], 0, priv->margin);
+}
+
+
+static gboolean
+on_drag_tick (GtkWidget *widget, GdkFrameClock *frame_clock, gpointer user_data)
+{
+  PhoshDragSurface *self = PHOSH_DRAG_SURFACE (widget);
+  PhoshDragSurfacePrivate *priv = phosh_drag_surface_get_instance_private (self);
+
+  /* Keep ticking while drag events come in, stop after an idle frame */
+  if (!priv->drag_pending) {
+    priv->drag_tick_id = 0;
+    return G_SOURCE_REMOVE;
+  }
+
+  emit_dragged (self);
+  return G_SOURCE_CONTINUE;
+}
+
+
+static void
+stop_drag_tick (PhoshDragSurface *self)
+{
+  PhoshDragSurfacePrivate *priv = phosh_drag_surface_get_instance_private (self);
+
+  if (priv->drag_tick_id == 0)
+    return;
+
+  gtk_widget_remove_tick_callback (GTK_WIDGET (self), priv->drag_tick_id);
+  priv->drag_tick_id = 0;
+}
+
+
 static void
 drag_surface_handle_drag_end (void                                    *data,
                               struct zphoc_draggable_layer_surface_v1 *drag_surface_,
@@ -151,6 +205,10 @@ drag_surface_handle_drag_end (void                                    *data,
 
   priv = phosh_drag_surface_get_instance_private (self);
 
+  /* Make sure the last position is seen before the state changes */
+  stop_drag_tick (self);
+  emit_dragged (self);
+
   if (state == priv->drag_state)
     return;
 
@@ -172,7 +230,18 @@ drag_surface_handle_dragged (void                                    *data,
 
   priv = phosh_drag_surface_get_instance_private (self);
 
-  g_signal_emit (self, signals[SIGNAL_DRAGGED], 0, margin);
+  priv->margin = margin;
+  priv->drag_pending = TRUE;
+
+  if (gtk_widget_get_mapped (GTK_WIDGET (self))) {
+    /* Coalesce to one update per frame */
+    if (priv->drag_tick_id == 0) {
+      priv->drag_tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (self), on_drag_tick,
+                                                         NULL, NULL);
+    }
+  } else {
+    emit_dragged (self);
+  }
 
   if (priv->drag_state == PHOSH_DRAG_SURFACE_STATE_DRAGGED)
     return;
@@ -270,6 +339,7 @@ phosh_drag_surface_dispose (GObject *object)
   PhoshDragSurface *self = PHOSH_DRAG_SURFACE (object);
   PhoshDragSurfacePrivate *priv = phosh_drag_surface_get_instance_private (self);
 
+  stop_drag_tick (self);
   g_clear_pointer (&priv->drag_surface, zphoc_draggable_layer_surface_v1_destroy);
 
   G_OBJECT_CLASS (phosh_drag_surface_parent_class)->dispose (object);
@@ -396,7 +466,7 @@ phosh_drag_surface_set_margin (PhoshDragSurface *self, int margin_folded, int ma
   }
 
   if (priv->margin_unfolded != margin_unfolded) {
-    priv->margin_folded = margin_folded;
+    priv->margin_unfolded = margin_unfolded;
     changed = TRUE;
   }
 
@@ -0,0 +1,430 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-frame-profiler"
+
+#include "phosh-config.h"
+
+#include "frame-profiler.h"
+#include "layersurface.h"
+
+#include <unistd.h>
+
+/**
+ * PhoshFrameProfiler:
+ *
+ * Records frame timings of layer surfaces
+ *
+ * The profiler hooks into the frame clock of every layer surface that
+ * gets mapped and records the duration of the layout and paint phases
+ * of each frame in a ring buffer. Frames that take longer than the
+ * refresh interval are counted as missed deadlines.
+ *
+ * The collected data can be fetched as histograms or written out as
+ * trace in the Chrome JSON trace format which can be loaded into
+ * Perfetto's UI.
+ *
+ * As this adds overhead to every frame it's only enabled via
+ * `PHOSH_DEBUG=frame-profiler`.
+ */
+
+#define N_FRAMES 512
+#define DEFAULT_REFRESH_INTERVAL 16667
+
+/* Upper bounds of the histogram buckets in ms */
+static const guint buckets[] = { 4, 8, 12, 16, 24, 33, 50, 100, G_MAXUINT };
+
+typedef struct {
+  gint64  start;
+  /* Relative to start, all in µs */
+  guint32 layout_start;
+  guint32 layout_us;
+  guint32 paint_start;
+  guint32 paint_us;
+  guint32 total_us;
+  gboolean missed;
+} FrameRecord;
+
+typedef struct {
+  GtkWidget          *surface;
+  GdkFrameClock      *frame_clock;
+  char               *name;
+  guint               id;
+
+  /* The frame currently in progress */
+  gint64              frame_start;
+  gint64              layout_start;
+  gint64              paint_start;
+  FrameRecord         current;
+
+  FrameRecord         frames[N_FRAMES];
+  guint               n_frames;
+  guint               n_missed;
+  guint               histogram[G_N_ELEMENTS (buckets)];
+  guint32             max_us;
+} SurfaceStats;
+
+struct _PhoshFrameProfiler {
+  GObject     parent;
+
+  gulong      map_hook_id;
+  /* SurfaceStats, kept after the surface is gone */
+  GPtrArray  *surfaces;
+  guint       next_id;
+};
+G_DEFINE_TYPE (PhoshFrameProfiler, phosh_frame_profiler, G_TYPE_OBJECT)
+
+
+static void
+surface_stats_detach (SurfaceStats *stats)
+{
+  if (stats->frame_clock) {
+    g_signal_handlers_disconnect_by_data (stats->frame_clock, stats);
+    g_clear_object (&stats->frame_clock);
+  }
+
+  if (stats->surface) {
+    g_signal_handlers_disconnect_by_data (stats->surface, stats);
+    stats->surface = NULL;
+  }
+}
+
+
+static void
+surface_stats_free (SurfaceStats *stats)
+{
+  surface_stats_detach (stats);
+  g_free (stats->name);
+  g_free (stats);
+}
+
+
+static void
+on_before_paint (GdkFrameClock *frame_clock, SurfaceStats *stats)
+{
+  stats->frame_start = g_get_monotonic_time ();
+  stats->layout_start = 0;
+  stats->paint_start = 0;
+  stats->current = (FrameRecord) { .start = stats->frame_start };
+}
+
+
+static void
+on_layout (GdkFrameClock *frame_clock, SurfaceStats *stats)
+{
+  stats->layout_start = g_get_monotonic_time ();
+}
+
+
+static void
+on_paint (GdkFrameClock *frame_clock, SurfaceStats *stats)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (stats->frame_start == 0)
+    return;
+
+  if (stats->layout_start) {
+    stats->current.layout_start = stats->layout_start - stats->frame_start;
+    stats->current.layout_us = now - stats->layout_start;
+  }
+  stats->paint_start = now;
+}
+
+
+static void
+on_after_paint (GdkFrameClock *frame_clock, SurfaceStats *stats)
+{
+  gint64 now = g_get_monotonic_time ();
+  gint64 refresh_interval = 0;
+  FrameRecord *record;
+  guint ms;
+
+  if (stats->frame_start == 0)
+    return;
+
+  if (stats->paint_start) {
+    stats->current.paint_start = stats->paint_start - stats->frame_start;
+    stats->current.paint_us = now - stats->paint_start;
+  }
+  stats->current.total_us = now - stats->frame_start;
+
+  gdk_frame_clock_get_refresh_info (frame_clock,
+                                    gdk_frame_clock_get_frame_time (frame_clock),
+                                    &refresh_interval,
+                                    NULL);
+  if (refresh_interval == 0)
+    refresh_interval = DEFAULT_REFRESH_INTERVAL;
+
+  stats->current.missed = stats->current.total_us > refresh_interval;
+  if (stats->current.missed)
+    stats->n_missed++;
+
+  ms = stats->current.total_us / 1000;
+  for (guint i = 0; i < G_N_ELEMENTS (buckets); i++) {
+    if (ms < buckets[i]) {
+      stats->histogram[i]++;
+      break;
+    }
+  }
+  stats->max_us = MAX (stats->max_us, stats->current.total_us);
+
+  record = &stats->frames[stats->n_frames % N_FRAMES];
+  *record = stats->current;
+  stats->n_frames++;
+  stats->frame_start = 0;
+}
+
+
+static void
+on_surface_unrealize (GtkWidget *surface, SurfaceStats *stats)
+{
+  g_debug ("Stop profiling '%s'", stats->name);
+  surface_stats_detach (stats);
+}
+
+
+static SurfaceStats *
+find_surface_stats (PhoshFrameProfiler *self, GtkWidget *surface, const char *name)
+{
+  for (guint i = 0; i < self->surfaces->len; i++) {
+    SurfaceStats *stats = g_ptr_array_index (self->surfaces, i);
+
+    if (surface && stats->surface == surface)
+      return stats;
+
+    /* Reuse the stats of a surface that went away so transient surfaces
+     * don't pile up */
+    if (name && stats->surface == NULL && g_str_equal (stats->name, name))
+      return stats;
+  }
+
+  return NULL;
+}
+
+
+static gboolean
+on_widget_map_emission (GSignalInvocationHint *ihint,
+                        guint                  n_param_values,
+                        const GValue          *param_values,
+                        gpointer               user_data)
+{
+  PhoshFrameProfiler *self = PHOSH_FRAME_PROFILER (user_data);
+  GtkWidget *widget = g_value_get_object (&param_values[0]);
+
+  if (PHOSH_IS_LAYER_SURFACE (widget))
+    phosh_frame_profiler_add_surface (self, widget);
+
+  return TRUE;
+}
+
+
+static void
+phosh_frame_profiler_dispose (GObject *object)
+{
+  PhoshFrameProfiler *self = PHOSH_FRAME_PROFILER (object);
+
+  if (self->map_hook_id) {
+    g_signal_remove_emission_hook (g_signal_lookup ("map", GTK_TYPE_WIDGET), self->map_hook_id);
+    self->map_hook_id = 0;
+  }
+
+  g_clear_pointer (&self->surfaces, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (phosh_frame_profiler_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_frame_profiler_class_init (PhoshFrameProfilerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = phosh_frame_profiler_dispose;
+}
+
+
+static void
+phosh_frame_profiler_init (PhoshFrameProfiler *self)
+{
+  self->surfaces = g_ptr_array_new_with_free_func ((GDestroyNotify) surface_stats_free);
+
+  /* Layer surfaces create their frame clock when mapped */
+  self->map_hook_id = g_signal_add_emission_hook (g_signal_lookup ("map", GTK_TYPE_WIDGET),
+                                                  0,
+                                                  on_widget_map_emission,
+                                                  self,
+                                                  NULL);
+}
+
+
+PhoshFrameProfiler *
+phosh_frame_profiler_new (void)
+{
+  return g_object_new (PHOSH_TYPE_FRAME_PROFILER, NULL);
+}
+
+/**
+ * phosh_frame_profiler_add_surface:
+ * @self: The frame profiler
+ * @surface: A realized toplevel
+ *
+ * Start recording frame timings of the given surface. Layer surfaces
+ * are added automatically when they get mapped.
+ */
+void
+phosh_frame_profiler_add_surface (PhoshFrameProfiler *self, GtkWidget *surface)
+{
+  g_autofree char *namespace = NULL;
+  g_autofree char *name = NULL;
+  GdkFrameClock *frame_clock;
+  SurfaceStats *stats;
+
+  g_return_if_fail (PHOSH_IS_FRAME_PROFILER (self));
+  g_return_if_fail (GTK_IS_WIDGET (surface));
+
+  frame_clock = gtk_widget_get_frame_clock (surface);
+  g_return_if_fail (GDK_IS_FRAME_CLOCK (frame_clock));
+
+  if (find_surface_stats (self, surface, NULL))
+    return;
+
+  if (PHOSH_IS_LAYER_SURFACE (surface))
+    g_object_get (surface, "namespace", &namespace, NULL);
+  name = g_strdup_printf ("%s (%s)", G_OBJECT_TYPE_NAME (surface), namespace ?: "");
+
+  stats = find_surface_stats (self, NULL, name);
+  if (stats == NULL) {
+    stats = g_new0 (SurfaceStats, 1);
+    stats->name = g_steal_pointer (&name);
+    stats->id = ++self->next_id;
+    g_ptr_array_add (self->surfaces, stats);
+  }
+
+  g_debug ("Profiling '%s'", stats->name);
+  stats->surface = surface;
+  stats->frame_clock = g_object_ref (frame_clock);
+  stats->frame_start = 0;
+
+  g_signal_connect (surface, "unrealize", G_CALLBACK (on_surface_unrealize), stats);
+  g_object_connect (frame_clock,
+                    "signal::before-paint", G_CALLBACK (on_before_paint), stats,
+                    "signal::layout", G_CALLBACK (on_layout), stats,
+                    "signal::paint", G_CALLBACK (on_paint), stats,
+                    "signal::after-paint", G_CALLBACK (on_after_paint), stats,
+                    NULL);
+}
+
+/**
+ * phosh_frame_profiler_get_stats:
+ * @self: The frame profiler
+ *
+ * Get the frame statistics of all surfaces profiled so far. See the
+ * `GetFrameStats` DBus method for the format.
+ *
+ * Returns:(transfer floating): The frame statistics
+ */
+GVariant *
+phosh_frame_profiler_get_stats (PhoshFrameProfiler *self)
+{
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (PHOSH_IS_FRAME_PROFILER (self), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sa{sv})"));
+  for (guint i = 0; i < self->surfaces->len; i++) {
+    SurfaceStats *stats = g_ptr_array_index (self->surfaces, i);
+    GVariantBuilder dict, histogram;
+
+    g_variant_builder_init (&histogram, G_VARIANT_TYPE ("a(uu)"));
+    for (guint j = 0; j < G_N_ELEMENTS (buckets); j++)
+      g_variant_builder_add (&histogram, "(uu)", buckets[j], stats->histogram[j]);
+
+    g_variant_builder_init (&dict, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&dict, "{sv}", "frames", g_variant_new_uint32 (stats->n_frames));
+    g_variant_builder_add (&dict, "{sv}", "missed-deadlines",
+                           g_variant_new_uint32 (stats->n_missed));
+    g_variant_builder_add (&dict, "{sv}", "frame-time-max", g_variant_new_uint32 (stats->max_us));
+    g_variant_builder_add (&dict, "{sv}", "histogram", g_variant_builder_end (&histogram));
+    g_variant_builder_add (&dict, "{sv}", "mapped", g_variant_new_boolean (!!stats->surface));
+
+    g_variant_builder_add (&builder, "(sa{sv})", stats->name, &dict);
+  }
+
+  return g_variant_builder_end (&builder);
+}
+
+
+static void
+append_event (GString     *trace,
+              const char  *name,
+              guint        tid,
+              gint64       ts,
+              guint32      dur,
+              gboolean     missed)
+{
+  g_string_append_printf (trace,
+                          ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                          "\"ts\":%" G_GINT64_FORMAT ",\"dur\":%u%s}",
+                          name, getpid (), tid, ts, dur,
+                          missed ? ",\"args\":{\"missed\":true}" : "");
+}
+
+/**
+ * phosh_frame_profiler_write_trace:
+ * @self: The frame profiler
+ * @filename: The file to write the trace to
+ * @error: Return location for error
+ *
+ * Write the recorded frames in the Chrome JSON trace format. Each
+ * surface is represented as a thread with its frames, layout and
+ * paint phases as slices.
+ *
+ * Returns: %TRUE on success, otherwise %FALSE
+ */
+gboolean
+phosh_frame_profiler_write_trace (PhoshFrameProfiler *self,
+                                  const char         *filename,
+                                  GError            **error)
+{
+  g_autoptr (GString) trace = g_string_new ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  g_return_val_if_fail (PHOSH_IS_FRAME_PROFILER (self), FALSE);
+  g_return_val_if_fail (filename, FALSE);
+
+  g_string_append_printf (trace,
+                          "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,"
+                          "\"args\":{\"name\":\"phosh\"}}",
+                          getpid ());
+
+  for (guint i = 0; i < self->surfaces->len; i++) {
+    SurfaceStats *stats = g_ptr_array_index (self->surfaces, i);
+    g_autofree char *escaped = g_strescape (stats->name, NULL);
+    guint first = stats->n_frames > N_FRAMES ? stats->n_frames - N_FRAMES : 0;
+
+    g_string_append_printf (trace,
+                            ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                            "\"args\":{\"name\":\"%s\"}}",
+                            getpid (), stats->id, escaped);
+
+    for (guint n = first; n < stats->n_frames; n++) {
+      FrameRecord *record = &stats->frames[n % N_FRAMES];
+
+      append_event (trace, "frame", stats->id, record->start, record->total_us, record->missed);
+      if (record->layout_us) {
+        append_event (trace, "layout", stats->id, record->start + record->layout_start,
+                      record->layout_us, FALSE);
+      }
+      if (record->paint_us) {
+        append_event (trace, "paint", stats->id, record->start + record->paint_start,
+                      record->paint_us, FALSE);
+      }
+    }
+  }
+  g_string_append (trace, "\n]}\n");
+
+  return g_file_set_contents (filename, trace->str, trace->len, error);
+}
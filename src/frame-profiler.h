@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_FRAME_PROFILER (phosh_frame_profiler_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshFrameProfiler, phosh_frame_profiler, PHOSH, FRAME_PROFILER, GObject)
+
+PhoshFrameProfiler *phosh_frame_profiler_new         (void);
+void                phosh_frame_profiler_add_surface (PhoshFrameProfiler *self,
+                                                      GtkWidget          *surface);
+GVariant           *phosh_frame_profiler_get_stats   (PhoshFrameProfiler *self);
+gboolean            phosh_frame_profiler_write_trace (PhoshFrameProfiler *self,
+                                                      const char         *filename,
+                                                      GError            **error);
+
+G_END_DECLS
@@ -270,6 +270,45 @@ grab_single_accelerator (PhoshGnomeShellManager *self,
 }
 
 
+static void
+on_grabs_done (PhoshKeyboardEvents *keyboard_events,
+               GAsyncResult        *res,
+               gpointer             user_data)
+{
+  g_autoptr (GDBusMethodInvocation) invocation = G_DBUS_METHOD_INVOCATION (user_data);
+  g_autoptr (GError) err = NULL;
+  GVariant *reply;
+
+  if (!phosh_keyboard_events_wait_for_grabs_finish (keyboard_events, res, &err))
+    g_warning ("Failed to wait for accelerator grabs: %s", err->message);
+
+  reply = g_object_steal_data (G_OBJECT (invocation), "phosh-grab-reply");
+  g_dbus_method_invocation_return_value (invocation, reply);
+}
+
+/*
+ * Reply to the grab request once the compositor handled all grabs so
+ * the caller can rely on the accelerators being active.
+ */
+static void
+complete_after_grabs (GDBusMethodInvocation *invocation, GVariant *reply)
+{
+  PhoshKeyboardEvents *keyboard_events;
+
+  keyboard_events = phosh_shell_get_keyboard_events (phosh_shell_get_default ());
+  if (keyboard_events == NULL) {
+    g_dbus_method_invocation_return_value (invocation, reply);
+    return;
+  }
+
+  g_object_set_data (G_OBJECT (invocation), "phosh-grab-reply", reply);
+  phosh_keyboard_events_wait_for_grabs (keyboard_events,
+                                        NULL,
+                                        (GAsyncReadyCallback) on_grabs_done,
+                                        g_object_ref (invocation));
+}
+
+
 static gboolean
 handle_grab_accelerator (PhoshDBusGnomeShell   *skeleton,
                          GDBusMethodInvocation *invocation,
@@ -303,8 +342,7 @@ handle_grab_accelerator (PhoshDBusGnomeShell   *skeleton,
     return TRUE;
   }
 
-  phosh_dbus_gnome_shell_complete_grab_accelerator (
-    skeleton, invocation, action_id);
+  complete_after_grabs (invocation, g_variant_new ("(u)", action_id));
 
   return TRUE;
 }
@@ -370,8 +408,8 @@ handle_grab_accelerators (PhoshDBusGnomeShell   *skeleton,
       g_hash_table_remove (self->info_by_action, GUINT_TO_POINTER (action_id));
     }
   } else { /* success */
-    phosh_dbus_gnome_shell_complete_grab_accelerators (
-      skeleton, invocation, g_variant_builder_end (builder));
+    complete_after_grabs (invocation,
+                          g_variant_new ("(@au)", g_variant_builder_end (builder)));
   }
 
   return TRUE;
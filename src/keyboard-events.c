@@ -17,6 +17,13 @@
  * PhoshKeyboardEvents:
  *
  * Grabs and manages special keyboard events
+ *
+ * Each action added to the action group grabs the accelerator of the
+ * same name. Grab and ungrab requests are batched and sent once per
+ * main loop iteration so registering many accelerators at once
+ * (e.g. by g-s-d at session startup) doesn't result in a request per
+ * action. Use [method@KeyboardEvents.wait_for_grabs] to get notified
+ * when the compositor handled all outstanding grabs.
  */
 
 enum {
@@ -30,7 +37,14 @@ struct _PhoshKeyboardEvents {
   GSimpleActionGroup                   parent;
 
   struct phosh_private_keyboard_event *kbevent;
-  GHashTable                          *accelerators;
+  GHashTable                          *accelerators;  /* action id → action name */
+  GHashTable                          *action_ids;    /* action name → action id */
+
+  GHashTable                          *pending_grabs; /* action names to grab */
+  GArray                              *pending_ungrabs; /* action ids to ungrab */
+  GHashTable                          *sent_grabs;    /* action names awaiting confirmation */
+  guint                                flush_id;
+  GPtrArray                           *waiters;       /* GTasks waiting for grabs */
 };
 
 static void initable_iface_init (GInitableIface *iface);
@@ -38,6 +52,33 @@ static void initable_iface_init (GInitableIface *iface);
 G_DEFINE_TYPE_WITH_CODE (PhoshKeyboardEvents, phosh_keyboard_events, G_TYPE_SIMPLE_ACTION_GROUP,
                          G_IMPLEMENT_INTERFACE(G_TYPE_INITABLE, initable_iface_init));
 
+
+static void schedule_flush (PhoshKeyboardEvents *self);
+
+
+static gboolean
+grabs_pending (PhoshKeyboardEvents *self)
+{
+  return g_hash_table_size (self->pending_grabs) || g_hash_table_size (self->sent_grabs);
+}
+
+
+static void
+complete_waiters (PhoshKeyboardEvents *self)
+{
+  g_autoptr (GPtrArray) waiters = NULL;
+
+  if (grabs_pending (self) || self->waiters->len == 0)
+    return;
+
+  waiters = g_steal_pointer (&self->waiters);
+  self->waiters = g_ptr_array_new_with_free_func (g_object_unref);
+
+  for (guint i = 0; i < waiters->len; i++)
+    g_task_return_boolean (g_ptr_array_index (waiters, i), TRUE);
+}
+
+
 static void
 handle_accelerator_activated_event (void *data,
                                     struct phosh_private_keyboard_event *kbevent,
@@ -94,6 +135,11 @@ handle_grab_failed_event (void *data,
                           const char *accelerator,
                           uint32_t error)
 {
+  PhoshKeyboardEvents *self = PHOSH_KEYBOARD_EVENTS (data);
+
+  g_hash_table_remove (self->sent_grabs, accelerator);
+  complete_waiters (self);
+
   switch ((enum phosh_private_keyboard_event_error) error) {
   case PHOSH_PRIVATE_KEYBOARD_EVENT_ERROR_ALREADY_SUBSCRIBED:
     g_warning ("Already subscribed to accelerator %s", accelerator);
@@ -117,7 +163,17 @@ handle_grab_success_event (void *data,
 {
   PhoshKeyboardEvents *self = PHOSH_KEYBOARD_EVENTS (data);
 
+  g_hash_table_remove (self->sent_grabs, accelerator);
   g_hash_table_insert (self->accelerators, GUINT_TO_POINTER (action_id), g_strdup (accelerator));
+  g_hash_table_insert (self->action_ids, g_strdup (accelerator), GUINT_TO_POINTER (action_id));
+
+  /* Action got removed while the grab was in flight */
+  if (!g_action_group_has_action (G_ACTION_GROUP (self), accelerator)) {
+    g_array_append_val (self->pending_ungrabs, action_id);
+    schedule_flush (self);
+  }
+
+  complete_waiters (self);
 }
 
 
@@ -127,9 +183,17 @@ handle_ungrab_success_event (void *data,
                              uint32_t action_id)
 {
   PhoshKeyboardEvents *self = PHOSH_KEYBOARD_EVENTS (data);
+  const char *action;
 
   g_return_if_fail (PHOSH_IS_KEYBOARD_EVENTS (data));
   g_debug ("Ungrab of %d successful", action_id);
+
+  action = g_hash_table_lookup (self->accelerators, GUINT_TO_POINTER (action_id));
+  /* The action might have been grabbed again meanwhile */
+  if (action &&
+      GPOINTER_TO_UINT (g_hash_table_lookup (self->action_ids, action)) == action_id) {
+    g_hash_table_remove (self->action_ids, action);
+  }
   g_hash_table_remove (self->accelerators, GUINT_TO_POINTER (action_id));
 }
 
@@ -154,13 +218,56 @@ static const struct phosh_private_keyboard_event_listener keyboard_event_listene
 };
 
 
+static gboolean
+on_flush (gpointer data)
+{
+  PhoshKeyboardEvents *self = PHOSH_KEYBOARD_EVENTS (data);
+  GHashTableIter iter;
+  const char *action_name;
+
+  self->flush_id = 0;
+
+  /* Ungrab first so accelerators that got re-added can be grabbed again */
+  for (guint i = 0; i < self->pending_ungrabs->len; i++) {
+    guint action_id = g_array_index (self->pending_ungrabs, guint, i);
+
+    phosh_private_keyboard_event_ungrab_accelerator_request (self->kbevent, action_id);
+  }
+  g_debug ("Sent %u ungrab requests", self->pending_ungrabs->len);
+  g_array_set_size (self->pending_ungrabs, 0);
+
+  g_hash_table_iter_init (&iter, self->pending_grabs);
+  while (g_hash_table_iter_next (&iter, (gpointer *)&action_name, NULL)) {
+    phosh_private_keyboard_event_grab_accelerator_request (self->kbevent, action_name);
+    g_hash_table_iter_steal (&iter);
+    g_hash_table_add (self->sent_grabs, (gpointer)action_name);
+  }
+  g_debug ("%u grab requests in flight", g_hash_table_size (self->sent_grabs));
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+schedule_flush (PhoshKeyboardEvents *self)
+{
+  if (self->flush_id)
+    return;
+
+  /* Run before GDK flushes the display so all requests go out at once */
+  self->flush_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE, on_flush, self, NULL);
+  g_source_set_name_by_id (self->flush_id, "[phosh] flush accelerator grabs");
+}
+
+
 static void
 on_action_added (PhoshKeyboardEvents *self,
                  gchar               *action_name,
                  GActionGroup        *action_group)
 {
   g_debug ("Grabbing accelerator %s", action_name);
-  phosh_private_keyboard_event_grab_accelerator_request (self->kbevent, action_name);
+  g_hash_table_add (self->pending_grabs, g_strdup (action_name));
+  schedule_flush (self);
 }
 
 
@@ -169,18 +276,24 @@ on_action_removed (PhoshKeyboardEvents *self,
                    gchar               *action_name,
                    GActionGroup        *action_group)
 {
-  GHashTableIter iter;
-  gpointer key, value;
+  gpointer value;
+  guint action_id;
 
   g_debug ("Ungrabbing accelerator %s", action_name);
 
-  g_hash_table_iter_init (&iter, self->accelerators);
-  while (g_hash_table_iter_next (&iter, &key, &value)) {
-    if (!g_strcmp0 (action_name, value)) {
-      phosh_private_keyboard_event_ungrab_accelerator_request (self->kbevent,
-                                                               GPOINTER_TO_UINT (key));
-    }
+  /* Not sent yet, nothing to ungrab */
+  if (g_hash_table_remove (self->pending_grabs, action_name)) {
+    complete_waiters (self);
+    return;
   }
+
+  /* Grabs in flight get ungrabbed once confirmed */
+  if (!g_hash_table_lookup_extended (self->action_ids, action_name, NULL, &value))
+    return;
+
+  action_id = GPOINTER_TO_UINT (value);
+  g_array_append_val (self->pending_ungrabs, action_id);
+  schedule_flush (self);
 }
 
 
@@ -249,8 +362,18 @@ phosh_keyboard_events_dispose (GObject *object)
 {
   PhoshKeyboardEvents *self = PHOSH_KEYBOARD_EVENTS (object);
 
+  g_clear_handle_id (&self->flush_id, g_source_remove);
   g_clear_pointer (&self->kbevent, phosh_private_keyboard_event_destroy);
 
+  if (self->waiters) {
+    for (guint i = 0; i < self->waiters->len; i++) {
+      g_task_return_new_error (g_ptr_array_index (self->waiters, i),
+                               G_IO_ERROR, G_IO_ERROR_CLOSED,
+                               "Keyboard events gone");
+    }
+    g_clear_pointer (&self->waiters, g_ptr_array_unref);
+  }
+
   G_OBJECT_CLASS (phosh_keyboard_events_parent_class)->dispose (object);
 }
 
@@ -261,6 +384,10 @@ phosh_keyboard_events_finalize (GObject *object)
   PhoshKeyboardEvents *self = PHOSH_KEYBOARD_EVENTS (object);
 
   g_clear_pointer (&self->accelerators, g_hash_table_unref);
+  g_clear_pointer (&self->action_ids, g_hash_table_unref);
+  g_clear_pointer (&self->pending_grabs, g_hash_table_unref);
+  g_clear_pointer (&self->pending_ungrabs, g_array_unref);
+  g_clear_pointer (&self->sent_grabs, g_hash_table_unref);
 
   G_OBJECT_CLASS (phosh_keyboard_events_parent_class)->finalize (object);
 }
@@ -311,6 +438,11 @@ phosh_keyboard_events_init (PhoshKeyboardEvents *self)
                                               g_direct_equal,
                                               NULL,
                                               g_free);
+  self->action_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->pending_grabs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->pending_ungrabs = g_array_new (FALSE, FALSE, sizeof (guint));
+  self->sent_grabs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->waiters = g_ptr_array_new_with_free_func (g_object_unref);
 }
 
 
@@ -323,3 +455,56 @@ phosh_keyboard_events_new (void)
                          &err,
                          NULL);
 }
+
+/**
+ * phosh_keyboard_events_wait_for_grabs:
+ * @self: The keyboard events
+ * @cancellable: (nullable): A cancellable
+ * @callback: The callback to invoke
+ * @user_data: The data for @callback
+ *
+ * Waits until the compositor handled all grab requests for the
+ * actions currently in the action group.
+ */
+void
+phosh_keyboard_events_wait_for_grabs (PhoshKeyboardEvents *self,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+
+  g_return_if_fail (PHOSH_IS_KEYBOARD_EVENTS (self));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, phosh_keyboard_events_wait_for_grabs);
+
+  if (!grabs_pending (self)) {
+    g_task_return_boolean (task, TRUE);
+    return;
+  }
+
+  g_ptr_array_add (self->waiters, g_steal_pointer (&task));
+}
+
+/**
+ * phosh_keyboard_events_wait_for_grabs_finish:
+ * @self: The keyboard events
+ * @res: The result
+ * @error: The return location for an error
+ *
+ * Finishes an operation started with
+ * [method@KeyboardEvents.wait_for_grabs].
+ *
+ * Returns: %TRUE if all grabs were handled
+ */
+gboolean
+phosh_keyboard_events_wait_for_grabs_finish (PhoshKeyboardEvents  *self,
+                                             GAsyncResult         *res,
+                                             GError              **error)
+{
+  g_return_val_if_fail (PHOSH_IS_KEYBOARD_EVENTS (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (res), error);
+}
@@ -20,4 +20,11 @@ G_DECLARE_FINAL_TYPE (PhoshKeyboardEvents,
                       GSimpleActionGroup)
 
 PhoshKeyboardEvents  *phosh_keyboard_events_new           (void);
+void                  phosh_keyboard_events_wait_for_grabs (PhoshKeyboardEvents *self,
+                                                            GCancellable        *cancellable,
+                                                            GAsyncReadyCallback  callback,
+                                                            gpointer             user_data);
+gboolean              phosh_keyboard_events_wait_for_grabs_finish (PhoshKeyboardEvents  *self,
+                                                                   GAsyncResult         *res,
+                                                                   GError              **error);
 
@@ -26,6 +26,10 @@
  * The #PhoshLockscreenManager is responsible for putting the #PhoshLockscreen
  * on the primary output and a #PhoshLockshield on other outputs when the session
  * becomes idle or when invoked explicitly via phosh_lockscreen_manager_set_locked().
+ *
+ * Unless disabled via the `persistent` setting the #PhoshLockscreen is
+ * built ahead of time and kept (hidden) when unlocking so locking the
+ * screen doesn't need to rebuild it and its plugins.
  */
 
 enum {
@@ -54,6 +58,9 @@ struct _PhoshLockscreenManager {
   gint64 active_time;                   /* when lock was activated (in us) */
 
   PhoshCallsManager    *calls_manager;  /* Calls DBus Interface */
+
+  GSettings            *settings;
+  guint                 prewarm_id;
 };
 
 G_DEFINE_TYPE (PhoshLockscreenManager, phosh_lockscreen_manager, G_TYPE_OBJECT)
@@ -72,7 +79,14 @@ lockscreen_unlock_cb (PhoshLockscreenManager *self, PhoshLockscreen *lockscreen)
   g_signal_handlers_disconnect_by_data (monitor_manager, self);
   g_signal_handlers_disconnect_by_data (primary_monitor, self);
   g_signal_handlers_disconnect_by_data (shell, self);
-  g_clear_pointer (&self->lockscreen, phosh_cp_widget_destroy);
+
+  if (g_settings_get_boolean (self->settings, "persistent")) {
+    /* Keep the lockscreen around for the next lock */
+    gtk_widget_hide (GTK_WIDGET (self->lockscreen));
+    phosh_lockscreen_reset (self->lockscreen);
+  } else {
+    g_clear_pointer (&self->lockscreen, phosh_cp_widget_destroy);
+  }
 
   /* Unlock all other outputs */
   g_clear_pointer (&self->shields, g_ptr_array_unref);
@@ -89,6 +103,10 @@ lockscreen_wakeup_output_cb (PhoshLockscreenManager *self, PhoshLockscreen *lock
   g_return_if_fail (PHOSH_IS_LOCKSCREEN_MANAGER (self));
   g_return_if_fail (PHOSH_IS_LOCKSCREEN (lockscreen));
 
+  /* A kept lockscreen has nothing to wake up for */
+  if (!self->locked)
+    return;
+
   /* we just proxy the signal here */
   g_signal_emit (self, signals[WAKEUP_OUTPUTS], 0);
 }
@@ -170,31 +188,101 @@ on_monitor_added (PhoshLockscreenManager *self,
 
 
 static void
-lock_primary_monitor (PhoshLockscreenManager *self)
+on_lockscreen_destroy (PhoshLockscreenManager *self, PhoshLockscreen *lockscreen)
+{
+  /* E.g. due to `layer_surface_closed` */
+  if (self->lockscreen == lockscreen)
+    self->lockscreen = NULL;
+}
+
+
+static void
+create_lockscreen (PhoshLockscreenManager *self, PhoshMonitor *monitor)
 {
   GType lockscreen_type;
-  PhoshMonitor *primary_monitor;
   PhoshWayland *wl = phosh_wayland_get_default ();
   PhoshShell *shell = phosh_shell_get_default ();
 
   lockscreen_type = phosh_shell_get_lockscreen_type (shell);
-  primary_monitor = phosh_shell_get_primary_monitor (shell);
-  g_assert (PHOSH_IS_MONITOR (primary_monitor));
 
   /* The primary output gets the clock, keypad, ... */
   self->lockscreen = PHOSH_LOCKSCREEN (phosh_lockscreen_new (
                                          lockscreen_type,
                                          phosh_wayland_get_zwlr_layer_shell_v1 (wl),
-                                         primary_monitor->wl_output,
+                                         monitor->wl_output,
                                          self->calls_manager));
   g_object_connect (
     self->lockscreen,
     "swapped-object-signal::lockscreen-unlock", G_CALLBACK (lockscreen_unlock_cb), self,
     "swapped-object-signal::wakeup-output", G_CALLBACK (lockscreen_wakeup_output_cb), self,
+    "swapped-object-signal::destroy", G_CALLBACK (on_lockscreen_destroy), self,
     NULL);
+}
+
+
+/* Whether the kept lockscreen can be used on the given monitor */
+static gboolean
+can_reuse_lockscreen (PhoshLockscreenManager *self, PhoshMonitor *monitor)
+{
+  PhoshShell *shell = phosh_shell_get_default ();
+  gpointer wl_output;
+
+  if (self->lockscreen == NULL)
+    return FALSE;
+
+  if (G_OBJECT_TYPE (self->lockscreen) != phosh_shell_get_lockscreen_type (shell))
+    return FALSE;
+
+  g_object_get (self->lockscreen, "wl-output", &wl_output, NULL);
+  return wl_output == monitor->wl_output;
+}
+
+
+static void
+lock_primary_monitor (PhoshLockscreenManager *self)
+{
+  PhoshMonitor *primary_monitor;
+  PhoshShell *shell = phosh_shell_get_default ();
+
+  primary_monitor = phosh_shell_get_primary_monitor (shell);
+  g_assert (PHOSH_IS_MONITOR (primary_monitor));
+
+  if (!self->locked && can_reuse_lockscreen (self, primary_monitor)) {
+    g_debug ("Reusing lockscreen %p", self->lockscreen);
+  } else {
+    /* Only drop a kept lockscreen, an old visible one gets removed
+     * due to `layer_surface_closed` */
+    if (!self->locked)
+      g_clear_pointer (&self->lockscreen, phosh_cp_widget_destroy);
+    create_lockscreen (self, primary_monitor);
+  }
 
   gtk_widget_show (GTK_WIDGET (self->lockscreen));
-  /* Old lockscreen gets remove due to `layer_surface_closed` */
+}
+
+
+static gboolean
+on_prewarm_idle (gpointer data)
+{
+  PhoshLockscreenManager *self = PHOSH_LOCKSCREEN_MANAGER (data);
+  PhoshMonitor *primary_monitor;
+
+  self->prewarm_id = 0;
+
+  if (self->lockscreen || self->locked || self->locking)
+    return G_SOURCE_REMOVE;
+
+  if (!g_settings_get_boolean (self->settings, "persistent"))
+    return G_SOURCE_REMOVE;
+
+  primary_monitor = phosh_shell_get_primary_monitor (phosh_shell_get_default ());
+  if (primary_monitor == NULL)
+    return G_SOURCE_REMOVE;
+
+  g_debug ("Prewarming lockscreen");
+  create_lockscreen (self, primary_monitor);
+
+  return G_SOURCE_REMOVE;
 }
 
 
@@ -334,9 +422,11 @@ phosh_lockscreen_manager_dispose (GObject *object)
 {
   PhoshLockscreenManager *self = PHOSH_LOCKSCREEN_MANAGER (object);
 
+  g_clear_handle_id (&self->prewarm_id, g_source_remove);
   g_clear_pointer (&self->shields, g_ptr_array_unref);
   g_clear_pointer (&self->lockscreen, phosh_cp_widget_destroy);
   g_clear_object (&self->calls_manager);
+  g_clear_object (&self->settings);
 
   G_OBJECT_CLASS (phosh_lockscreen_manager_parent_class)->dispose (object);
 }
@@ -354,6 +444,10 @@ phosh_lockscreen_manager_constructed (GObject *object)
                            G_CALLBACK (on_calls_call_added),
                            self,
                            G_CONNECT_SWAPPED);
+
+  /* Build the lockscreen once things settled so the first lock is fast too */
+  self->prewarm_id = g_idle_add_full (G_PRIORITY_LOW, on_prewarm_idle, self, NULL);
+  g_source_set_name_by_id (self->prewarm_id, "[phosh] prewarm lockscreen");
 }
 
 
@@ -400,6 +494,7 @@ phosh_lockscreen_manager_class_init (PhoshLockscreenManagerClass *klass)
 static void
 phosh_lockscreen_manager_init (PhoshLockscreenManager *self)
 {
+  self->settings = g_settings_new ("sm.puri.phosh.lockscreen");
 }
 
 
@@ -470,7 +565,7 @@ phosh_lockscreen_manager_set_page  (PhoshLockscreenManager *self,
 {
   g_return_val_if_fail (PHOSH_IS_LOCKSCREEN_MANAGER (self), FALSE);
 
-  if (!self->lockscreen)
+  if (!self->lockscreen || !self->locked)
     return FALSE;
 
   g_return_val_if_fail (PHOSH_IS_LOCKSCREEN (self->lockscreen), FALSE);
@@ -485,6 +580,7 @@ phosh_lockscreen_manager_set_page  (PhoshLockscreenManager *self,
  * @self: The lockscreen manager
  *
  * Gets the current [type@Lockscreen], if one exists (NULL otherwise).
+ * A lockscreen that is kept around while unlocked isn't returned.
  *
  * Returns:(transfer none)(nullable): The lockscreen
  */
@@ -493,7 +589,7 @@ phosh_lockscreen_manager_get_lockscreen (PhoshLockscreenManager *self)
 {
   g_return_val_if_fail (PHOSH_IS_LOCKSCREEN_MANAGER (self), NULL);
 
-  if (!self->lockscreen)
+  if (!self->lockscreen || !self->locked)
     return NULL;
 
   g_return_val_if_fail (PHOSH_IS_LOCKSCREEN (self->lockscreen), FALSE);
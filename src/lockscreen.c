@@ -9,6 +9,7 @@
 
 #define G_LOG_DOMAIN "phosh-lockscreen"
 
+#include "animation.h"
 #include "auth.h"
 #include "call-notification.h"
 #include "calls-manager.h"
@@ -20,6 +21,7 @@
 #include "osk-manager.h"
 #include "shell.h"
 #include "util.h"
+#include "wakeup-scheduler.h"
 #include "widget-box.h"
 #include "wall-clock.h"
 
@@ -36,6 +38,11 @@
 
 #define LOCKSCREEN_SMALL_DISPLAY 700
 
+/* One radian every 30ms for two full sine periods so the PIN entry
+ * ends up in the idle position */
+#define LOCKSCREEN_SHAKE_PERIODS 2
+#define LOCKSCREEN_SHAKE_DURATION (LOCKSCREEN_SHAKE_PERIODS * 2 * G_PI * 30) /* ms */
+
 /**
  * PhoshLockscreen:
  *
@@ -97,6 +104,7 @@ typedef struct {
   GtkWidget         *btn_keyboard;
   guint              idle_timer;
   gint64             last_input;
+  PhoshAnimation    *shake;
   PhoshAuth         *auth;
   GSettings         *lockscreen_settings;
 
@@ -208,34 +216,24 @@ finish_shake_entry (PhoshLockscreen *self)
 }
 
 
-static gboolean
-shake_entry (GtkWidget     *widget,
-             GdkFrameClock *frame_clock,
-             gpointer       data)
+static void
+shake_value_cb (double value, PhoshLockscreen *self)
 {
-  PhoshLockscreen *self = PHOSH_LOCKSCREEN (widget);
   PhoshLockscreenPrivate *priv = phosh_lockscreen_get_instance_private (self);
-  gint64 start_time = g_variant_get_int64 (data);
-  gint64 end_time = start_time + 1000 * 300;
-  gint64 now = gdk_frame_clock_get_frame_time (frame_clock);
-
-  float t = (float) (now - start_time) / (float) (end_time - start_time);
-  float pos = sin (t * 10) * 0.05 + 0.5;
-
-  if (now > end_time) {
-    /* Stop the animation only when we would step over the idle position (0.5) */
-    if ((gtk_entry_get_alignment (GTK_ENTRY (priv->entry_pin)) > 0.5 && pos < 0.5) || pos > 0.5) {
-      guint id;
-
-      gtk_entry_set_alignment (GTK_ENTRY (priv->entry_pin), 0.5);
-      id = g_timeout_add (400, (GSourceFunc) finish_shake_entry, self);
-      g_source_set_name_by_id (id, "[PhoshLockscreen] shake PIN entry");
-      return FALSE;
-    }
-  }
 
-  gtk_entry_set_alignment (GTK_ENTRY (priv->entry_pin), pos);
-  return TRUE;
+  gtk_entry_set_alignment (GTK_ENTRY (priv->entry_pin), sin (value) * 0.05 + 0.5);
+}
+
+
+static void
+shake_done_cb (PhoshLockscreen *self)
+{
+  PhoshLockscreenPrivate *priv = phosh_lockscreen_get_instance_private (self);
+  guint id;
+
+  gtk_entry_set_alignment (GTK_ENTRY (priv->entry_pin), 0.5);
+  id = g_timeout_add (400, (GSourceFunc) finish_shake_entry, self);
+  g_source_set_name_by_id (id, "[PhoshLockscreen] shake PIN entry");
 }
 
 static void
@@ -486,10 +484,12 @@ carousel_page_changed_cb (PhoshLockscreen *self,
 
     if (!priv->idle_timer) {
       priv->last_input = g_get_monotonic_time ();
-      priv->idle_timer = g_timeout_add_seconds (LOCKSCREEN_IDLE_SECONDS,
-                                                (GSourceFunc) keypad_check_idle,
-                                                self);
-      g_source_set_name_by_id (priv->idle_timer, "[PhoshLockscreen] keypad check");
+      priv->idle_timer = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                                     "[PhoshLockscreen] keypad check",
+                                                     LOCKSCREEN_IDLE_SECONDS,
+                                                     PHOSH_WAKEUP_FLAG_UI,
+                                                     (GSourceFunc) keypad_check_idle,
+                                                     self);
     }
   } else {
     gtk_widget_set_sensitive (priv->entry_pin, FALSE);
@@ -868,6 +868,7 @@ phosh_lockscreen_dispose (GObject *object)
 
   g_clear_object (&priv->notification_settings);
   g_clear_handle_id (&priv->idle_timer, g_source_remove);
+  g_clear_pointer (&priv->shake, phosh_animation_unref);
   g_clear_object (&priv->calls_manager);
   g_clear_pointer (&priv->active, g_free);
   g_clear_object (&priv->lockscreen_settings);
@@ -1053,7 +1054,18 @@ phosh_lockscreen_class_init (PhoshLockscreenClass *klass)
 static void
 phosh_lockscreen_init (PhoshLockscreen *self)
 {
+  PhoshLockscreenPrivate *priv = phosh_lockscreen_get_instance_private (self);
+
   gtk_widget_init_template (GTK_WIDGET (self));
+
+  priv->shake = phosh_animation_new (GTK_WIDGET (self),
+                                     0.0,
+                                     LOCKSCREEN_SHAKE_PERIODS * 2 * G_PI,
+                                     LOCKSCREEN_SHAKE_DURATION * PHOSH_ANIMATION_SLOWDOWN,
+                                     PHOSH_ANIMATION_TYPE_LINEAR,
+                                     (PhoshAnimationValueCallback) shake_value_cb,
+                                     (PhoshAnimationDoneCallback) shake_done_cb,
+                                     self);
 }
 
 
@@ -1210,17 +1222,41 @@ void
 phosh_lockscreen_shake_pin_entry (PhoshLockscreen *self)
 {
   PhoshLockscreenPrivate *priv;
-  GdkFrameClock *clock;
-  gint64 now;
 
   g_return_if_fail (PHOSH_IS_LOCKSCREEN (self));
   priv = phosh_lockscreen_get_instance_private (self);
-  clock = gtk_widget_get_frame_clock (priv->entry_pin);
-  now = gdk_frame_clock_get_frame_time (clock);
-  gtk_widget_add_tick_callback (GTK_WIDGET (self),
-                                shake_entry,
-                                g_variant_ref_sink (g_variant_new_int64 (now)),
-                                (GDestroyNotify) g_variant_unref);
+
+  phosh_animation_start (priv->shake);
+}
+
+/**
+ * phosh_lockscreen_reset:
+ * @self: The `PhoshLockscreen`
+ *
+ * Brings the lockscreen back into the state of a newly built one so
+ * it can be shown again on the next lock: the PIN entry and unlock
+ * status are cleared and the default page is shown.
+ */
+void
+phosh_lockscreen_reset (PhoshLockscreen *self)
+{
+  PhoshLockscreenPrivate *priv;
+
+  g_return_if_fail (PHOSH_IS_LOCKSCREEN (self));
+  priv = phosh_lockscreen_get_instance_private (self);
+
+  g_clear_handle_id (&priv->idle_timer, g_source_remove);
+  clear_input (self, TRUE);
+  phosh_lockscreen_set_unlock_status (self, _("Enter Passcode"));
+  gtk_entry_set_alignment (GTK_ENTRY (priv->entry_pin), 0.5);
+  gtk_widget_set_sensitive (GTK_WIDGET (self), TRUE);
+
+  if (priv->active)
+    hdy_deck_set_visible_child (priv->deck, GTK_WIDGET (priv->box_call_display));
+  else
+    hdy_deck_set_visible_child (priv->deck, GTK_WIDGET (priv->box_info));
+
+  phosh_lockscreen_set_page (self, priv->default_page);
 }
 
 /**
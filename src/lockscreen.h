@@ -72,4 +72,6 @@ void                phosh_lockscreen_set_unlock_status (PhoshLockscreen *self, c
 
 void                phosh_lockscreen_add_extra_page (PhoshLockscreen *self, GtkWidget *widget);
 
+void                phosh_lockscreen_reset (PhoshLockscreen *self);
+
 G_END_DECLS
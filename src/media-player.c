@@ -12,7 +12,10 @@
 
 #include "mpris-dbus.h"
 #include "media-player.h"
+#include "memory-accounting.h"
+#include "property-coalescer.h"
 #include "util.h"
+#include "wakeup-scheduler.h"
 
 #include <gmobile.h>
 #include <cui-call.h>
@@ -87,6 +90,7 @@ typedef struct _PhoshMediaPlayer {
   PhoshMprisDBusMediaPlayer2       *mpris;
   /* Actual player controls */
   PhoshMprisDBusMediaPlayer2Player *player;
+  PhoshPropertyCoalescer           *coalescer;
   GDBusConnection                  *session_bus;
   guint                             dbus_id;
   PhoshMediaPlayerStatus            status;
@@ -246,10 +250,12 @@ start_pos_poller (PhoshMediaPlayer *self)
   }
   g_debug ("Starting position poller");
   poll_position (self);
-  self->pos_poller_id = g_timeout_add_seconds (POLLER_INTERVAL,
-                                               (GSourceFunc) poll_position,
-                                               self);
-  g_source_set_name_by_id (self->pos_poller_id, "[PhoshMediaPlayer] pos_poller");
+  self->pos_poller_id = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                                    "[PhoshMediaPlayer] pos_poller",
+                                                    POLLER_INTERVAL,
+                                                    PHOSH_WAKEUP_FLAG_UI,
+                                                    (GSourceFunc) poll_position,
+                                                    self);
 }
 
 
@@ -595,6 +601,41 @@ on_can_seek (PhoshMediaPlayer                 *self,
 }
 
 
+static void
+on_player_props_changed (PhoshMediaPlayer       *self,
+                         GObject                *object,
+                         GStrv                   properties,
+                         PhoshPropertyCoalescer *coalescer)
+{
+  PhoshMprisDBusMediaPlayer2Player *player = PHOSH_MPRIS_DBUS_MEDIA_PLAYER2_PLAYER (object);
+
+  if (player != self->player)
+    return;
+
+  if (g_strv_contains ((const char * const *)properties, "Metadata"))
+    on_metadata_changed (self, NULL, player);
+  if (g_strv_contains ((const char * const *)properties, "PlaybackStatus"))
+    on_playback_status_changed (self, NULL, player);
+  if (g_strv_contains ((const char * const *)properties, "CanGoNext"))
+    on_can_go_next_changed (self, NULL, player);
+  if (g_strv_contains ((const char * const *)properties, "CanGoPrevious"))
+    on_can_go_previous_changed (self, NULL, player);
+  if (g_strv_contains ((const char * const *)properties, "CanPlay"))
+    on_can_play (self, NULL, player);
+  if (g_strv_contains ((const char * const *)properties, "CanSeek"))
+    on_can_seek (self, NULL, player);
+}
+
+
+static void
+clear_player (PhoshMediaPlayer *self)
+{
+  if (self->player)
+    phosh_property_coalescer_unwatch (self->coalescer, G_DBUS_PROXY (self->player));
+  g_clear_object (&self->player);
+}
+
+
 static void
 phosh_media_player_dispose (GObject *object)
 {
@@ -610,7 +651,11 @@ phosh_media_player_dispose (GObject *object)
   }
   g_clear_object (&self->session_bus);
   g_clear_object (&self->mpris);
-  g_clear_object (&self->player);
+  if (self->coalescer) {
+    clear_player (self);
+    g_signal_handlers_disconnect_by_data (self->coalescer, self);
+    g_clear_object (&self->coalescer);
+  }
 
   G_OBJECT_CLASS (phosh_media_player_parent_class)->dispose (object);
 }
@@ -716,26 +761,8 @@ attach_player_cb (GObject          *source_object,
   g_return_if_fail (PHOSH_IS_MEDIA_PLAYER (self));
   self->player = player;
 
-  g_object_connect (self->player,
-                    "swapped_object_signal::notify::metadata",
-                    G_CALLBACK (on_metadata_changed),
-                    self,
-                    "swapped_object_signal::notify::playback-status",
-                    G_CALLBACK (on_playback_status_changed),
-                    self,
-                    "swapped_object_signal::notify::can-go-next",
-                    G_CALLBACK (on_can_go_next_changed),
-                    self,
-                    "swapped_object_signal::notify::can-go-previous",
-                    G_CALLBACK (on_can_go_previous_changed),
-                    self,
-                    "swapped_object_signal::notify::can-play",
-                    G_CALLBACK (on_can_play),
-                    self,
-                    "swapped_object_signal::notify::can-seek",
-                    G_CALLBACK (on_can_seek),
-                    self,
-                    NULL);
+  /* Players can update e.g. metadata and status in quick succession */
+  phosh_property_coalescer_watch (self->coalescer, G_DBUS_PROXY (self->player));
 
   g_debug ("Connected player");
   /* Set 'attached' before running notifiers, since we check it on e.g. start_pos_poller() */
@@ -743,12 +770,12 @@ attach_player_cb (GObject          *source_object,
   /* Hide progress bar box by default, it's shown if track length is given in metadata */
   gtk_widget_hide (self->box_pos_len);
 
-  g_object_notify (G_OBJECT (self->player), "metadata");
-  g_object_notify (G_OBJECT (self->player), "playback-status");
-  g_object_notify (G_OBJECT (self->player), "can-go-next");
-  g_object_notify (G_OBJECT (self->player), "can-go-previous");
-  g_object_notify (G_OBJECT (self->player), "can-play");
-  g_object_notify (G_OBJECT (self->player), "can-seek");
+  on_metadata_changed (self, NULL, self->player);
+  on_playback_status_changed (self, NULL, self->player);
+  on_can_go_next_changed (self, NULL, self->player);
+  on_can_go_previous_changed (self, NULL, self->player);
+  on_can_play (self, NULL, self->player);
+  on_can_seek (self, NULL, self->player);
 }
 
 
@@ -779,7 +806,7 @@ attach_mpris_cb (GObject          *source_object,
 static void
 attach_player (PhoshMediaPlayer *self, const char *name)
 {
-  g_clear_object (&self->player);
+  clear_player (self);
   g_clear_object (&self->mpris);
 
   g_debug ("Trying to attach player for %s", name);
@@ -947,6 +974,23 @@ on_bus_get_finished (GObject          *source_object,
 }
 
 
+/* Art loaded from files is held by GTK's icon machinery so only inline art has a known size */
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshMediaPlayer *self = PHOSH_MEDIA_PLAYER (owner);
+  GIcon *icon;
+
+  if (gtk_image_get_storage_type (GTK_IMAGE (self->img_art)) != GTK_IMAGE_GICON)
+    return;
+
+  gtk_image_get_gicon (GTK_IMAGE (self->img_art), &icon, NULL);
+  if (GDK_IS_PIXBUF (icon))
+    report->bytes += gdk_pixbuf_get_byte_length (GDK_PIXBUF (icon));
+  report->objects++;
+}
+
+
 static void
 phosh_media_player_init (PhoshMediaPlayer *self)
 {
@@ -956,10 +1000,23 @@ phosh_media_player_init (PhoshMediaPlayer *self)
   self->track_length = -1;
   self->track_position = -1;
   self->pos_poller_id = 0;
+
+  self->coalescer = phosh_property_coalescer_new ();
+  g_signal_connect_swapped (self->coalescer,
+                            "changed",
+                            G_CALLBACK (on_player_props_changed),
+                            self);
+
   g_bus_get (G_BUS_TYPE_SESSION,
              self->cancel,
              (GAsyncReadyCallback)on_bus_get_finished,
              self);
+
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "media-art",
+                                        G_OBJECT (self),
+                                        report_memory,
+                                        NULL);
 }
 
 
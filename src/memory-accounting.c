@@ -0,0 +1,447 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-memory-accounting"
+
+#include "phosh-config.h"
+
+#include "memory-accounting.h"
+#include "wakeup-scheduler.h"
+
+#include <unistd.h>
+
+#ifdef __GLIBC__
+# include <malloc.h>
+#endif
+
+/**
+ * PhoshMemoryAccounting:
+ *
+ * Tracks the memory held by the shell's caches and models
+ *
+ * Caches and other subsystems that hold on to potentially large
+ * amounts of memory register a reporter under a subsystem name. The
+ * reporter tells how many bytes and objects are currently held.
+ * Several reporters can use the same name (e.g. one per widget
+ * instance), their numbers are summed up.
+ *
+ * Subsystems can have a budget. When a periodic check finds a
+ * subsystem over budget the reporters' evict functions are invoked
+ * to drop what can be recreated. Each check also logs the current
+ * usage so growth over long uptimes can be attributed.
+ *
+ * When the system is under memory pressure all subsystems are asked
+ * to shed memory via [method@MemoryAccounting.shed].
+ */
+
+typedef struct {
+  char    *name;
+  guint64  budget;
+  guint    n_evictions;
+} Subsystem;
+
+typedef struct {
+  PhoshMemoryAccounting *accounting;
+  Subsystem             *subsystem;
+  GObject               *owner;
+  PhoshMemoryReportFunc  report;
+  PhoshMemoryEvictFunc   evict;
+} Reporter;
+
+struct _PhoshMemoryAccounting {
+  GObject     parent;
+
+  /* Subsystems in registration order */
+  GPtrArray  *subsystems;
+  GPtrArray  *reporters;
+
+  guint       check_id;
+};
+G_DEFINE_TYPE (PhoshMemoryAccounting, phosh_memory_accounting, G_TYPE_OBJECT)
+
+
+static void
+subsystem_free (Subsystem *subsystem)
+{
+  g_free (subsystem->name);
+  g_free (subsystem);
+}
+
+
+static void on_owner_finalized (gpointer data, GObject *where_the_object_was);
+
+static void
+reporter_free (Reporter *reporter)
+{
+  if (reporter->owner)
+    g_object_weak_unref (reporter->owner, on_owner_finalized, reporter);
+  g_free (reporter);
+}
+
+
+static void
+on_owner_finalized (gpointer data, GObject *where_the_object_was)
+{
+  Reporter *reporter = data;
+
+  reporter->owner = NULL;
+  g_ptr_array_remove (reporter->accounting->reporters, reporter);
+}
+
+
+static Subsystem *
+get_subsystem (PhoshMemoryAccounting *self, const char *name)
+{
+  Subsystem *subsystem;
+
+  for (guint i = 0; i < self->subsystems->len; i++) {
+    subsystem = g_ptr_array_index (self->subsystems, i);
+    if (g_str_equal (subsystem->name, name))
+      return subsystem;
+  }
+
+  subsystem = g_new0 (Subsystem, 1);
+  subsystem->name = g_strdup (name);
+  g_ptr_array_add (self->subsystems, subsystem);
+
+  return subsystem;
+}
+
+
+static PhoshMemoryReport
+collect (PhoshMemoryAccounting *self, Subsystem *subsystem)
+{
+  PhoshMemoryReport report = { 0 };
+
+  for (guint i = 0; i < self->reporters->len; i++) {
+    Reporter *reporter = g_ptr_array_index (self->reporters, i);
+
+    if (reporter->subsystem == subsystem)
+      reporter->report (reporter->owner, &report);
+  }
+
+  return report;
+}
+
+
+static void
+evict (PhoshMemoryAccounting *self, Subsystem *subsystem, PhoshMemoryPressure pressure)
+{
+  g_autoptr (GPtrArray) reporters = g_ptr_array_new ();
+
+  /* Evicting might drop owners and hence reporters */
+  for (guint i = 0; i < self->reporters->len; i++) {
+    Reporter *reporter = g_ptr_array_index (self->reporters, i);
+
+    if (reporter->subsystem == subsystem && reporter->evict)
+      g_ptr_array_add (reporters, reporter);
+  }
+
+  if (reporters->len == 0)
+    return;
+
+  for (guint i = 0; i < reporters->len; i++) {
+    Reporter *reporter = g_ptr_array_index (reporters, i);
+
+    if (g_ptr_array_find (self->reporters, reporter, NULL))
+      reporter->evict (reporter->owner, pressure);
+  }
+
+  subsystem->n_evictions++;
+}
+
+
+static guint64
+get_rss (void)
+{
+  g_autofree char *statm = NULL;
+  g_auto (GStrv) fields = NULL;
+
+  if (!g_file_get_contents ("/proc/self/statm", &statm, NULL, NULL))
+    return 0;
+
+  fields = g_strsplit (statm, " ", 3);
+  if (g_strv_length (fields) < 2)
+    return 0;
+
+  return g_ascii_strtoull (fields[1], NULL, 10) * sysconf (_SC_PAGESIZE);
+}
+
+
+static gboolean
+on_check_timeout (gpointer data)
+{
+  phosh_memory_accounting_check (PHOSH_MEMORY_ACCOUNTING (data));
+
+  return G_SOURCE_CONTINUE;
+}
+
+
+static void
+phosh_memory_accounting_finalize (GObject *object)
+{
+  PhoshMemoryAccounting *self = PHOSH_MEMORY_ACCOUNTING (object);
+
+  g_clear_handle_id (&self->check_id, g_source_remove);
+  g_clear_pointer (&self->reporters, g_ptr_array_unref);
+  g_clear_pointer (&self->subsystems, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (phosh_memory_accounting_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_memory_accounting_class_init (PhoshMemoryAccountingClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phosh_memory_accounting_finalize;
+}
+
+
+static void
+phosh_memory_accounting_init (PhoshMemoryAccounting *self)
+{
+  self->subsystems = g_ptr_array_new_with_free_func ((GDestroyNotify) subsystem_free);
+  self->reporters = g_ptr_array_new_with_free_func ((GDestroyNotify) reporter_free);
+}
+
+/**
+ * phosh_memory_accounting_get_default:
+ *
+ * Gets the memory accounting singleton.
+ *
+ * Returns:(transfer none): The memory accounting singleton.
+ */
+PhoshMemoryAccounting *
+phosh_memory_accounting_get_default (void)
+{
+  static PhoshMemoryAccounting *instance;
+
+  if (instance == NULL) {
+    instance = g_object_new (PHOSH_TYPE_MEMORY_ACCOUNTING, NULL);
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+  return instance;
+}
+
+/**
+ * phosh_memory_accounting_add_reporter:
+ * @self: The memory accounting
+ * @name: The subsystem's name
+ * @owner:(nullable): The object holding the memory
+ * @report: Function to report the held memory
+ * @evict:(nullable): Function to drop memory when over budget or under pressure
+ *
+ * Registers a reporter for the given subsystem. If @owner is given
+ * the reporter is removed when @owner gets finalized.
+ */
+void
+phosh_memory_accounting_add_reporter (PhoshMemoryAccounting *self,
+                                      const char            *name,
+                                      GObject               *owner,
+                                      PhoshMemoryReportFunc  report,
+                                      PhoshMemoryEvictFunc   evict)
+{
+  Reporter *reporter;
+
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+  g_return_if_fail (name);
+  g_return_if_fail (owner == NULL || G_IS_OBJECT (owner));
+  g_return_if_fail (report);
+
+  reporter = g_new0 (Reporter, 1);
+  reporter->accounting = self;
+  reporter->subsystem = get_subsystem (self, name);
+  reporter->owner = owner;
+  reporter->report = report;
+  reporter->evict = evict;
+
+  if (owner)
+    g_object_weak_ref (owner, on_owner_finalized, reporter);
+
+  g_ptr_array_add (self->reporters, reporter);
+}
+
+/**
+ * phosh_memory_accounting_set_budget:
+ * @self: The memory accounting
+ * @name: The subsystem's name
+ * @budget: The budget in bytes or `0` for no budget
+ *
+ * Sets the number of bytes the given subsystem may hold before its
+ * reporters are asked to evict.
+ */
+void
+phosh_memory_accounting_set_budget (PhoshMemoryAccounting *self,
+                                    const char            *name,
+                                    guint64                budget)
+{
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+  g_return_if_fail (name);
+
+  get_subsystem (self, name)->budget = budget;
+}
+
+/**
+ * phosh_memory_accounting_clear_budgets:
+ * @self: The memory accounting
+ *
+ * Removes the budgets of all subsystems.
+ */
+void
+phosh_memory_accounting_clear_budgets (PhoshMemoryAccounting *self)
+{
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+
+  for (guint i = 0; i < self->subsystems->len; i++) {
+    Subsystem *subsystem = g_ptr_array_index (self->subsystems, i);
+
+    subsystem->budget = 0;
+  }
+}
+
+/**
+ * phosh_memory_accounting_load_budgets:
+ * @self: The memory accounting
+ * @budgets: A `a{su}` variant mapping subsystem names to KiB
+ *
+ * Replaces all budgets by the ones in @budgets as found in the
+ * `memory-budgets` setting.
+ */
+void
+phosh_memory_accounting_load_budgets (PhoshMemoryAccounting *self, GVariant *budgets)
+{
+  GVariantIter iter;
+  const char *name;
+  guint32 budget;
+
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+  g_return_if_fail (g_variant_is_of_type (budgets, G_VARIANT_TYPE ("a{su}")));
+
+  phosh_memory_accounting_clear_budgets (self);
+
+  g_variant_iter_init (&iter, budgets);
+  while (g_variant_iter_next (&iter, "{&su}", &name, &budget))
+    phosh_memory_accounting_set_budget (self, name, (guint64) budget * 1024);
+}
+
+/**
+ * phosh_memory_accounting_set_interval:
+ * @self: The memory accounting
+ * @interval: The interval in seconds or `0` to disable
+ *
+ * Sets how often budgets are checked and the usage is logged.
+ */
+void
+phosh_memory_accounting_set_interval (PhoshMemoryAccounting *self, guint interval)
+{
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+
+  g_clear_handle_id (&self->check_id, g_source_remove);
+  if (interval == 0)
+    return;
+
+  self->check_id = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                               "[phosh] memory accounting check",
+                                               interval,
+                                               PHOSH_WAKEUP_FLAG_NONE,
+                                               on_check_timeout,
+                                               self);
+}
+
+/**
+ * phosh_memory_accounting_check:
+ * @self: The memory accounting
+ *
+ * Evicts from subsystems that exceed their budget and logs the
+ * current usage.
+ */
+void
+phosh_memory_accounting_check (PhoshMemoryAccounting *self)
+{
+  g_autoptr (GString) usage = g_string_new (NULL);
+  g_autofree char *rss = NULL;
+
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+
+  for (guint i = 0; i < self->subsystems->len; i++) {
+    Subsystem *subsystem = g_ptr_array_index (self->subsystems, i);
+    PhoshMemoryReport report = collect (self, subsystem);
+    g_autofree char *bytes = NULL;
+
+    if (subsystem->budget && report.bytes > subsystem->budget) {
+      g_debug ("'%s' holds %" G_GUINT64_FORMAT " bytes, over budget of %" G_GUINT64_FORMAT,
+               subsystem->name, report.bytes, subsystem->budget);
+      evict (self, subsystem, PHOSH_MEMORY_PRESSURE_MEDIUM);
+      report = collect (self, subsystem);
+    }
+
+    bytes = g_format_size (report.bytes);
+    g_string_append_printf (usage, ", %s: %s (%u)", subsystem->name, bytes, report.objects);
+  }
+
+  rss = g_format_size (get_rss ());
+  g_message ("Memory usage: rss %s%s", rss, usage->str);
+}
+
+/**
+ * phosh_memory_accounting_shed:
+ * @self: The memory accounting
+ * @pressure: How much memory to give back
+ *
+ * Asks all subsystems to give back memory and returns freed heap
+ * memory to the system.
+ */
+void
+phosh_memory_accounting_shed (PhoshMemoryAccounting *self, PhoshMemoryPressure pressure)
+{
+  g_return_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self));
+
+  g_debug ("Shedding memory, pressure %d", pressure);
+
+  for (guint i = 0; i < self->subsystems->len; i++)
+    evict (self, g_ptr_array_index (self->subsystems, i), pressure);
+
+#ifdef __GLIBC__
+  malloc_trim (0);
+#endif
+}
+
+/**
+ * phosh_memory_accounting_get_stats:
+ * @self: The memory accounting
+ *
+ * Get the memory held by all subsystems. See the `GetMemoryStats`
+ * DBus method for the format.
+ *
+ * Returns:(transfer floating): The memory statistics
+ */
+GVariant *
+phosh_memory_accounting_get_stats (PhoshMemoryAccounting *self)
+{
+  GVariantBuilder builder;
+
+  g_return_val_if_fail (PHOSH_IS_MEMORY_ACCOUNTING (self), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(sa{sv})"));
+  for (guint i = 0; i < self->subsystems->len; i++) {
+    Subsystem *subsystem = g_ptr_array_index (self->subsystems, i);
+    PhoshMemoryReport report = collect (self, subsystem);
+    GVariantBuilder dict;
+
+    g_variant_builder_init (&dict, G_VARIANT_TYPE_VARDICT);
+    g_variant_builder_add (&dict, "{sv}", "bytes", g_variant_new_uint64 (report.bytes));
+    g_variant_builder_add (&dict, "{sv}", "objects", g_variant_new_uint32 (report.objects));
+    g_variant_builder_add (&dict, "{sv}", "budget", g_variant_new_uint64 (subsystem->budget));
+    g_variant_builder_add (&dict, "{sv}", "evictions",
+                           g_variant_new_uint32 (subsystem->n_evictions));
+
+    g_variant_builder_add (&builder, "(sa{sv})", subsystem->name, &dict);
+  }
+
+  return g_variant_builder_end (&builder);
+}
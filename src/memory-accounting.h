@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PhoshMemoryReport:
+ * @bytes: The number of bytes held
+ * @objects: The number of objects held
+ *
+ * The memory held by a subsystem as filled in by a
+ * [callback@MemoryReportFunc].
+ */
+typedef struct {
+  guint64 bytes;
+  guint   objects;
+} PhoshMemoryReport;
+
+/**
+ * PhoshMemoryReportFunc:
+ * @owner:(nullable): The object the reporter was registered for
+ * @report: The report to add the held memory to
+ *
+ * Adds the memory currently held by @owner to @report.
+ */
+typedef void (*PhoshMemoryReportFunc) (GObject *owner, PhoshMemoryReport *report);
+
+/**
+ * PhoshMemoryPressure:
+ * @PHOSH_MEMORY_PRESSURE_LOW: Drop what isn't in use
+ * @PHOSH_MEMORY_PRESSURE_MEDIUM: Drop what can be recreated cheaply
+ * @PHOSH_MEMORY_PRESSURE_CRITICAL: Drop everything that can be recreated
+ *
+ * How much memory a subsystem should give back.
+ */
+typedef enum {
+  PHOSH_MEMORY_PRESSURE_LOW = 1,
+  PHOSH_MEMORY_PRESSURE_MEDIUM,
+  PHOSH_MEMORY_PRESSURE_CRITICAL,
+} PhoshMemoryPressure;
+
+/**
+ * PhoshMemoryEvictFunc:
+ * @owner:(nullable): The object the reporter was registered for
+ * @pressure: How much memory to give back
+ *
+ * Invoked when the subsystem exceeds its budget or the system is
+ * under memory pressure.
+ */
+typedef void (*PhoshMemoryEvictFunc) (GObject *owner, PhoshMemoryPressure pressure);
+
+#define PHOSH_TYPE_MEMORY_ACCOUNTING (phosh_memory_accounting_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshMemoryAccounting, phosh_memory_accounting, PHOSH, MEMORY_ACCOUNTING,
+                      GObject)
+
+PhoshMemoryAccounting *phosh_memory_accounting_get_default   (void);
+void                   phosh_memory_accounting_add_reporter  (PhoshMemoryAccounting *self,
+                                                              const char            *name,
+                                                              GObject               *owner,
+                                                              PhoshMemoryReportFunc  report,
+                                                              PhoshMemoryEvictFunc   evict);
+void                   phosh_memory_accounting_set_budget    (PhoshMemoryAccounting *self,
+                                                              const char            *name,
+                                                              guint64                budget);
+void                   phosh_memory_accounting_clear_budgets (PhoshMemoryAccounting *self);
+void                   phosh_memory_accounting_load_budgets  (PhoshMemoryAccounting *self,
+                                                              GVariant              *budgets);
+void                   phosh_memory_accounting_set_interval  (PhoshMemoryAccounting *self,
+                                                              guint                  interval);
+void                   phosh_memory_accounting_check         (PhoshMemoryAccounting *self);
+void                   phosh_memory_accounting_shed          (PhoshMemoryAccounting *self,
+                                                              PhoshMemoryPressure    pressure);
+GVariant              *phosh_memory_accounting_get_stats     (PhoshMemoryAccounting *self);
+
+G_END_DECLS
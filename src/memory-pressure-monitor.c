@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-memory-pressure-monitor"
+
+#include "phosh-config.h"
+
+#include "memory-accounting.h"
+#include "memory-pressure-monitor.h"
+#include "phosh-enums.h"
+
+#include <gio/gio.h>
+#include <glib-unix.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PSI_MEMORY_PATH "/proc/pressure/memory"
+/* Unprivileged processes need a window that is a multiple of 2s */
+#define PSI_WINDOW_US   2000000
+/* Don't repeat the same level more often than that */
+#define RATE_LIMIT_US   (10 * G_USEC_PER_SEC)
+
+/**
+ * PhoshMemoryPressureMonitor:
+ *
+ * Monitors the system for memory pressure
+ *
+ * The monitor uses Linux' pressure stall information (PSI) triggers
+ * and [iface@Gio.MemoryMonitor] to detect memory pressure and
+ * broadcasts it as [enum@MemoryPressure] so caches can give back
+ * memory before the kernel has to reclaim or kill processes.
+ */
+
+enum {
+  PRESSURE,
+  N_SIGNALS
+};
+static guint signals[N_SIGNALS];
+
+typedef struct {
+  PhoshMemoryPressure  level;
+  const char          *trigger;
+} PsiTriggerDesc;
+
+/* Stall thresholds in µs within the window */
+static const PsiTriggerDesc psi_triggers[] = {
+  { PHOSH_MEMORY_PRESSURE_LOW, "some 100000 " G_STRINGIFY (PSI_WINDOW_US) },
+  { PHOSH_MEMORY_PRESSURE_MEDIUM, "some 300000 " G_STRINGIFY (PSI_WINDOW_US) },
+  { PHOSH_MEMORY_PRESSURE_CRITICAL, "full 200000 " G_STRINGIFY (PSI_WINDOW_US) },
+};
+
+typedef struct {
+  PhoshMemoryPressureMonitor *monitor;
+  PhoshMemoryPressure         level;
+  int                         fd;
+  guint                       source_id;
+} PsiTrigger;
+
+struct _PhoshMemoryPressureMonitor {
+  GObject              parent;
+
+  PsiTrigger           triggers[G_N_ELEMENTS (psi_triggers)];
+  GMemoryMonitor      *memory_monitor;
+
+  PhoshMemoryPressure  last_level;
+  gint64               last_emitted;
+};
+G_DEFINE_TYPE (PhoshMemoryPressureMonitor, phosh_memory_pressure_monitor, G_TYPE_OBJECT)
+
+
+static void
+emit_pressure (PhoshMemoryPressureMonitor *self, PhoshMemoryPressure level)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (level <= self->last_level && now - self->last_emitted < RATE_LIMIT_US)
+    return;
+
+  g_debug ("Memory pressure level %d", level);
+  self->last_level = level;
+  self->last_emitted = now;
+  g_signal_emit (self, signals[PRESSURE], 0, level);
+}
+
+
+static gboolean
+on_psi_event (int fd, GIOCondition condition, gpointer user_data)
+{
+  PsiTrigger *trigger = user_data;
+
+  if (condition & (G_IO_ERR | G_IO_HUP | G_IO_NVAL)) {
+    g_warning ("Memory pressure trigger failed, disabling");
+    trigger->source_id = 0;
+    g_clear_fd (&trigger->fd, NULL);
+    return G_SOURCE_REMOVE;
+  }
+
+  emit_pressure (trigger->monitor, trigger->level);
+  return G_SOURCE_CONTINUE;
+}
+
+
+static gboolean
+setup_psi_trigger (PhoshMemoryPressureMonitor *self, PsiTrigger *trigger, const PsiTriggerDesc *desc)
+{
+  trigger->monitor = self;
+  trigger->level = desc->level;
+  trigger->fd = open (PSI_MEMORY_PATH, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+  if (trigger->fd < 0) {
+    g_debug ("Failed to open " PSI_MEMORY_PATH ": %s", g_strerror (errno));
+    return FALSE;
+  }
+
+  /* The kernel expects the terminating NUL */
+  if (write (trigger->fd, desc->trigger, strlen (desc->trigger) + 1) < 0) {
+    g_debug ("Failed to set memory pressure trigger '%s': %s", desc->trigger, g_strerror (errno));
+    g_clear_fd (&trigger->fd, NULL);
+    return FALSE;
+  }
+
+  trigger->source_id = g_unix_fd_add (trigger->fd, G_IO_PRI | G_IO_ERR, on_psi_event, trigger);
+  g_source_set_name_by_id (trigger->source_id, "[phosh] memory pressure trigger");
+
+  return TRUE;
+}
+
+
+static void
+on_low_memory_warning (PhoshMemoryPressureMonitor  *self,
+                       GMemoryMonitorWarningLevel   warning)
+{
+  PhoshMemoryPressure level;
+
+  if (warning >= G_MEMORY_MONITOR_WARNING_LEVEL_CRITICAL)
+    level = PHOSH_MEMORY_PRESSURE_CRITICAL;
+  else if (warning >= G_MEMORY_MONITOR_WARNING_LEVEL_MEDIUM)
+    level = PHOSH_MEMORY_PRESSURE_MEDIUM;
+  else
+    level = PHOSH_MEMORY_PRESSURE_LOW;
+
+  emit_pressure (self, level);
+}
+
+
+static void
+phosh_memory_pressure_monitor_dispose (GObject *object)
+{
+  PhoshMemoryPressureMonitor *self = PHOSH_MEMORY_PRESSURE_MONITOR (object);
+
+  for (guint i = 0; i < G_N_ELEMENTS (self->triggers); i++) {
+    g_clear_handle_id (&self->triggers[i].source_id, g_source_remove);
+    g_clear_fd (&self->triggers[i].fd, NULL);
+  }
+
+  if (self->memory_monitor)
+    g_signal_handlers_disconnect_by_data (self->memory_monitor, self);
+  g_clear_object (&self->memory_monitor);
+
+  G_OBJECT_CLASS (phosh_memory_pressure_monitor_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_memory_pressure_monitor_class_init (PhoshMemoryPressureMonitorClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = phosh_memory_pressure_monitor_dispose;
+
+  /**
+   * PhoshMemoryPressureMonitor::pressure:
+   * @self: The memory pressure monitor
+   * @level: The memory pressure level
+   *
+   * Emitted when the system is under memory pressure. The same level
+   * is emitted at most every couple of seconds, a higher level is
+   * emitted immediately.
+   */
+  signals[PRESSURE] = g_signal_new ("pressure",
+                                    G_TYPE_FROM_CLASS (klass),
+                                    G_SIGNAL_RUN_LAST, 0,
+                                    NULL, NULL, NULL,
+                                    G_TYPE_NONE,
+                                    1,
+                                    PHOSH_TYPE_MEMORY_PRESSURE);
+}
+
+
+static void
+phosh_memory_pressure_monitor_init (PhoshMemoryPressureMonitor *self)
+{
+  gboolean has_psi = TRUE;
+
+  for (guint i = 0; i < G_N_ELEMENTS (self->triggers); i++)
+    self->triggers[i].fd = -1;
+
+  for (guint i = 0; i < G_N_ELEMENTS (psi_triggers) && has_psi; i++)
+    has_psi = setup_psi_trigger (self, &self->triggers[i], &psi_triggers[i]);
+
+  if (!has_psi)
+    g_debug ("No PSI memory pressure triggers, relying on GMemoryMonitor");
+
+  self->memory_monitor = g_memory_monitor_dup_default ();
+  g_signal_connect_swapped (self->memory_monitor, "low-memory-warning",
+                            G_CALLBACK (on_low_memory_warning), self);
+}
+
+
+PhoshMemoryPressureMonitor *
+phosh_memory_pressure_monitor_new (void)
+{
+  return g_object_new (PHOSH_TYPE_MEMORY_PRESSURE_MONITOR, NULL);
+}
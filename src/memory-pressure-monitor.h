@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_MEMORY_PRESSURE_MONITOR (phosh_memory_pressure_monitor_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshMemoryPressureMonitor, phosh_memory_pressure_monitor,
+                      PHOSH, MEMORY_PRESSURE_MONITOR, GObject)
+
+PhoshMemoryPressureMonitor *phosh_memory_pressure_monitor_new (void);
+
+G_END_DECLS
@@ -27,6 +27,9 @@
 #define GSD_COLOR_BUS_NAME "org.gnome.SettingsDaemon.Color"
 #define GSD_COLOR_OBJECT_PATH "/org/gnome/SettingsDaemon/Color"
 
+/* Time without heads coming or going before we send a configuration */
+#define CONFIG_SETTLE_MS 150
+
 /**
  * PhoshMonitorManager:
  *
@@ -36,6 +39,14 @@
  * org.gnome.Mutter.DisplayConfig DBus interface via
  * #PhoshDBusDisplayConfig. This includes individual monitor
  * configuration as well as blanking/power saving.
+ *
+ * Output configurations are applied as transactions: pending head
+ * state is accumulated and sent as a single configuration once the
+ * head layout settled. At most one configuration is in flight at a
+ * time, changes made meanwhile go into the next one and cancelled
+ * configurations are retried with the compositor's fresh serial.
+ * Requested head state is kept apart from the state reported by the
+ * compositor so head events don't drop changes that are still queued.
  */
 
 /* Equivalent to the 'layout-mode' enum in org.gnome.Mutter.DisplayConfig */
@@ -81,9 +92,23 @@ typedef struct _PhoshMonitorManager
   PhoshHead *pending_primary;
   uint32_t zwlr_output_serial;
 
+  /* Output configuration transactions */
+  struct zwlr_output_configuration_v1 *config_in_flight;
+  uint32_t                 config_serial;
+  gboolean                 config_dirty;
+  gboolean                 config_cancelled;
+  guint                    config_apply_id;
+  gint64                   last_head_change;
+
+  /* Cached GetCurrentState reply */
+  GVariant  *current_state;
+  PhoshHead *current_state_primary;
+
   GCancellable            *cancel;
 } PhoshMonitorManager;
 
+static void schedule_apply (PhoshMonitorManager *self);
+
 G_DEFINE_TYPE_WITH_CODE (PhoshMonitorManager,
                          phosh_monitor_manager,
                          PHOSH_DBUS_TYPE_DISPLAY_CONFIG_SKELETON,
@@ -388,37 +413,18 @@ phosh_monitor_manager_handle_set_crtc_gamma (PhoshDBusDisplayConfig *skeleton,
 #define MONITOR_SPEC_FORMAT "(ssss)"
 #define MONITOR_FORMAT "(" MONITOR_SPEC_FORMAT MODES_FORMAT "a{sv})"
 #define MONITORS_FORMAT "a" MONITOR_FORMAT
+/* The modes are passed as a GVariant */
+#define MONITOR_BUILD_FORMAT "(" MONITOR_SPEC_FORMAT "@" MODES_FORMAT "a{sv})"
 
 #define LOGICAL_MONITOR_MONITORS_FORMAT "a" MONITOR_SPEC_FORMAT
 #define LOGICAL_MONITOR_FORMAT "(iidub" LOGICAL_MONITOR_MONITORS_FORMAT "a{sv})"
 #define LOGICAL_MONITORS_FORMAT "a" LOGICAL_MONITOR_FORMAT
 
 
-static gboolean
-phosh_monitor_manager_handle_get_current_state (PhoshDBusDisplayConfig *skeleton,
-                                                GDBusMethodInvocation  *invocation)
+static GVariant *
+build_current_state (PhoshMonitorManager *self, PhoshHead *primary_head)
 {
-  PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (skeleton);
   GVariantBuilder monitors_builder, logical_monitors_builder, properties_builder;
-  PhoshMonitor *primary_monitor;
-  PhoshHead *primary_head;
-
-  g_debug ("DBus call %s", __func__);
-
-  primary_monitor = phosh_shell_get_primary_monitor (phosh_shell_get_default());
-  if (!primary_monitor) {
-    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
-                                           G_DBUS_ERROR_ACCESS_DENIED,
-                                           "No primary monitor found");
-    return TRUE;
-  }
-  primary_head = phosh_monitor_manager_get_head_from_monitor (self, primary_monitor);
-  if (!primary_head) {
-    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
-                                           G_DBUS_ERROR_ACCESS_DENIED,
-                                           "No primary monitor found");
-    return TRUE;
-  }
 
   g_variant_builder_init (&monitors_builder,
                           G_VARIANT_TYPE (MONITORS_FORMAT));
@@ -427,50 +433,10 @@ phosh_monitor_manager_handle_get_current_state (PhoshDBusDisplayConfig *skeleton
 
   /* connected physical monitors */
   for (int i = 0; i < self->heads->len; i++) {
-    double scale = 1.0;
     PhoshHead *head = g_ptr_array_index (self->heads, i);
-    GVariantBuilder modes_builder, supported_scales_builder, mode_properties_builder,
-      monitor_properties_builder;
+    GVariantBuilder monitor_properties_builder;
     char *display_name;
     gboolean is_builtin;
-    int n;
-
-    g_variant_builder_init (&modes_builder, G_VARIANT_TYPE (MODES_FORMAT));
-
-    for (int k = 0; k < head->modes->len; k++) {
-      PhoshHeadMode *mode = g_ptr_array_index (head->modes, k);
-      g_autofree float *scales = NULL;
-      if (!mode->name) {
-        g_warning ("Skipping unnamend mode %p", mode);
-        continue;
-      }
-
-      g_variant_builder_init (&supported_scales_builder,
-                              G_VARIANT_TYPE ("ad"));
-      scales = phosh_head_calculate_supported_mode_scales (head, mode, &n, TRUE);
-      for (int l = 0; l < n; l++) {
-        g_variant_builder_add (&supported_scales_builder, "d",
-                               (double)scales[l]);
-      }
-
-      g_variant_builder_init (&mode_properties_builder,
-                              G_VARIANT_TYPE ("a{sv}"));
-      g_variant_builder_add (&mode_properties_builder, "{sv}",
-                             "is-current",
-                             g_variant_new_boolean (head->mode == mode));
-      g_variant_builder_add (&mode_properties_builder, "{sv}",
-                             "is-preferred",
-                             g_variant_new_boolean (mode->preferred));
-
-      g_variant_builder_add (&modes_builder, MODE_FORMAT,
-                             mode->name,
-                             (gint32)mode->width,
-                             (gint32)mode->height,
-                             (double)mode->refresh / 1000.0,
-                             (double)scale,  /* preferred_scale, */
-                             &supported_scales_builder,
-                             &mode_properties_builder);
-    }
 
     g_variant_builder_init (&monitor_properties_builder,
                             G_VARIANT_TYPE ("a{sv}"));
@@ -485,12 +451,12 @@ phosh_monitor_manager_handle_get_current_state (PhoshDBusDisplayConfig *skeleton
                              "display-name",
                              g_variant_new_take_string (display_name));
 
-    g_variant_builder_add (&monitors_builder, MONITOR_FORMAT,
+    g_variant_builder_add (&monitors_builder, MONITOR_BUILD_FORMAT,
                            head->name,                       /* monitor_spec->connector */
                            head->vendor ?: "",               /* monitor_spec->vendor, */
                            head->product ?: "",              /* monitor_spec->product, */
                            head->serial ?: "",               /* monitor_spec->serial, */
-                           &modes_builder,
+                           phosh_head_modes_to_variant (head->modes, head->mode),
                            &monitor_properties_builder);
   }
 
@@ -535,14 +501,59 @@ phosh_monitor_manager_handle_get_current_state (PhoshDBusDisplayConfig *skeleton
                          "supports-changing-layout-mode",
                          g_variant_new_boolean (TRUE));
 
-  phosh_dbus_display_config_complete_get_current_state (
-    skeleton,
-    invocation,
-    self->serial,
-    g_variant_builder_end (&monitors_builder),
-    g_variant_builder_end (&logical_monitors_builder),
-    g_variant_builder_end (&properties_builder));
+  return g_variant_new ("(@" MONITORS_FORMAT "@" LOGICAL_MONITORS_FORMAT "@a{sv})",
+                        g_variant_builder_end (&monitors_builder),
+                        g_variant_builder_end (&logical_monitors_builder),
+                        g_variant_builder_end (&properties_builder));
+}
 
+
+static gboolean
+phosh_monitor_manager_handle_get_current_state (PhoshDBusDisplayConfig *skeleton,
+                                                GDBusMethodInvocation  *invocation)
+{
+  PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (skeleton);
+  g_autoptr (GVariant) monitors = NULL;
+  g_autoptr (GVariant) logical_monitors = NULL;
+  g_autoptr (GVariant) properties = NULL;
+  PhoshMonitor *primary_monitor;
+  PhoshHead *primary_head;
+
+  g_debug ("DBus call %s", __func__);
+
+  primary_monitor = phosh_shell_get_primary_monitor (phosh_shell_get_default());
+  if (!primary_monitor) {
+    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                           G_DBUS_ERROR_ACCESS_DENIED,
+                                           "No primary monitor found");
+    return TRUE;
+  }
+  primary_head = phosh_monitor_manager_get_head_from_monitor (self, primary_monitor);
+  if (!primary_head) {
+    g_dbus_method_invocation_return_error (invocation, G_DBUS_ERROR,
+                                           G_DBUS_ERROR_ACCESS_DENIED,
+                                           "No primary monitor found");
+    return TRUE;
+  }
+
+  /* The state only changes with heads, modes and the serial. The
+   * primary monitor is tracked by the shell so check it separately. */
+  if (self->current_state == NULL || self->current_state_primary != primary_head) {
+    g_clear_pointer (&self->current_state, g_variant_unref);
+    self->current_state = g_variant_ref_sink (build_current_state (self, primary_head));
+    self->current_state_primary = primary_head;
+  }
+
+  monitors = g_variant_get_child_value (self->current_state, 0);
+  logical_monitors = g_variant_get_child_value (self->current_state, 1);
+  properties = g_variant_get_child_value (self->current_state, 2);
+
+  phosh_dbus_display_config_complete_get_current_state (skeleton,
+                                                        invocation,
+                                                        self->serial,
+                                                        monitors,
+                                                        logical_monitors,
+                                                        properties);
   return TRUE;
 }
 
@@ -554,6 +565,7 @@ phosh_monitor_manager_handle_get_current_state (PhoshDBusDisplayConfig *skeleton
 #undef MODE_FORMAT
 #undef MONITORS_FORMAT
 #undef MONITOR_FORMAT
+#undef MONITOR_BUILD_FORMAT
 
 
 #define MONITOR_CONFIG_FORMAT "(ssa{sv})"
@@ -1068,6 +1080,14 @@ on_wl_outputs_changed (PhoshMonitorManager *self, GParamSpec *pspec, PhoshWaylan
  * wlr_output_manager wayland protocol
  */
 
+static void
+invalidate_current_state (PhoshMonitorManager *self)
+{
+  g_clear_pointer (&self->current_state, g_variant_unref);
+  self->current_state_primary = NULL;
+}
+
+
 static void
 on_head_finished (PhoshMonitorManager *self,
                   PhoshHead *head)
@@ -1079,6 +1099,8 @@ on_head_finished (PhoshMonitorManager *self,
   else
     g_warning ("Tried to remove inexistend head %p", head);
 
+  self->last_head_change = g_get_monotonic_time ();
+  invalidate_current_state (self);
   phosh_dbus_display_config_emit_monitors_changed (PHOSH_DBUS_DISPLAY_CONFIG (self));
 }
 
@@ -1098,6 +1120,8 @@ zwlr_output_manager_v1_handle_head (void *data,
   g_ptr_array_add (self->heads, head);
   g_signal_connect_swapped (head, "head-finished", G_CALLBACK (on_head_finished), self);
 
+  self->last_head_change = g_get_monotonic_time ();
+  invalidate_current_state (self);
   phosh_dbus_display_config_emit_monitors_changed (PHOSH_DBUS_DISPLAY_CONFIG (self));
 }
 
@@ -1114,7 +1138,22 @@ zwlr_output_manager_v1_handle_done (void *data,
   self->zwlr_output_serial = serial;
   self->serial++;
 
+  /* Heads without queued changes follow the compositor's state */
+  for (int i = 0; i < self->heads->len; i++) {
+    PhoshHead *head = g_ptr_array_index (self->heads, i);
+
+    if (!head->pending.requested)
+      phosh_head_clear_pending (head);
+  }
+
+  /* Head and mode changes are applied atomically with done */
+  invalidate_current_state (self);
   phosh_dbus_display_config_emit_monitors_changed (PHOSH_DBUS_DISPLAY_CONFIG (self));
+
+  /* A cancelled configuration can be retried with the new serial */
+  self->config_cancelled = FALSE;
+  if (self->config_dirty)
+    schedule_apply (self);
 }
 
 
@@ -1124,12 +1163,33 @@ static const struct zwlr_output_manager_v1_listener zwlr_output_manager_v1_liste
 };
 
 
+static void
+config_finished (PhoshMonitorManager *self, struct zwlr_output_configuration_v1 *config)
+{
+  g_return_if_fail (self->config_in_flight == config);
+
+  g_clear_pointer (&self->config_in_flight, zwlr_output_configuration_v1_destroy);
+
+  /* Changes that came in while the configuration was in flight */
+  if (self->config_dirty) {
+    schedule_apply (self);
+    return;
+  }
+
+  /* Nothing queued, follow the compositor's state again */
+  for (int i = 0; i < self->heads->len; i++)
+    phosh_head_clear_pending (g_ptr_array_index (self->heads, i));
+}
+
+
 static void
 zwlr_output_configuration_v1_handle_succeeded (void *data,
                                                struct zwlr_output_configuration_v1 *config)
 {
+  PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (data);
+
   g_debug ("New output configuration %p applied", config);
-  zwlr_output_configuration_v1_destroy (config);
+  config_finished (self, config);
 }
 
 
@@ -1137,9 +1197,11 @@ static void
 zwlr_output_configuration_v1_handle_failed (void *data,
                                             struct zwlr_output_configuration_v1 *config)
 {
+  PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (data);
+
   /* TODO: bubble up error */
   g_warning ("Failed to apply New output %p configuration", config);
-  zwlr_output_configuration_v1_destroy (config);
+  config_finished (self, config);
 }
 
 
@@ -1147,8 +1209,14 @@ static void
 zwlr_output_configuration_v1_handle_cancelled (void *data,
                                                struct zwlr_output_configuration_v1 *config)
 {
-  zwlr_output_configuration_v1_destroy(config);
-  g_warning("Failed to apply New output configuration %p due to changes", config);
+  PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (data);
+
+  /* The output state changed underneath us. The compositor usually sends
+   * the new serial before cancelling, only wait for it if it didn't */
+  g_debug ("Output configuration %p cancelled, retrying", config);
+  self->config_dirty = TRUE;
+  self->config_cancelled = self->zwlr_output_serial == self->config_serial;
+  config_finished (self, config);
 }
 
 
@@ -1159,6 +1227,107 @@ static const struct zwlr_output_configuration_v1_listener config_listener = {
 };
 
 
+static void
+send_config (PhoshMonitorManager *self)
+{
+  PhoshWayland *wl = phosh_wayland_get_default();
+  struct zwlr_output_configuration_v1 *config;
+  struct zwlr_output_manager_v1 *output_manager =
+    phosh_wayland_get_zwlr_output_manager_v1 (wl);
+
+  config = zwlr_output_manager_v1_create_configuration (output_manager,
+                                                        self->zwlr_output_serial);
+
+  zwlr_output_configuration_v1_add_listener (config, &config_listener, self);
+  for (int i = 0; i < self->heads->len; i++) {
+    struct zwlr_output_configuration_head_v1 *config_head;
+    PhoshHead *head = g_ptr_array_index (self->heads, i);
+    struct zwlr_output_head_v1 *wlr_head = phosh_head_get_wlr_head (head);
+    struct zwlr_output_mode_v1 *wlr_mode;
+
+    g_debug ("Adding %sabled head %s to configuration",
+             head->pending.enabled ? "en" : "dis",
+             head->name);
+
+    if (!head->pending.enabled) {
+      zwlr_output_configuration_v1_disable_head (config, wlr_head);
+      continue;
+    }
+
+    config_head = zwlr_output_configuration_v1_enable_head (config, wlr_head);
+
+    /* A disabled head might not have a mode when set */
+    if (head->pending.mode) {
+      wlr_mode = head->pending.mode->wlr_mode;
+    } else {
+      wlr_mode = phosh_head_get_preferred_mode (head)->wlr_mode;
+    }
+
+    zwlr_output_configuration_head_v1_set_mode (config_head, wlr_mode);
+    zwlr_output_configuration_head_v1_set_position (config_head,
+                                                    head->pending.x, head->pending.y);
+    zwlr_output_configuration_head_v1_set_transform (config_head, head->pending.transform);
+    zwlr_output_configuration_head_v1_set_scale (config_head,
+                                                 wl_fixed_from_double(head->pending.scale));
+  }
+
+  zwlr_output_configuration_v1_apply (config);
+  self->config_in_flight = config;
+  self->config_serial = self->zwlr_output_serial;
+  self->config_dirty = FALSE;
+}
+
+
+static gboolean
+on_apply_config (gpointer data)
+{
+  PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (data);
+  gint64 settled;
+
+  self->config_apply_id = 0;
+
+  if (!self->config_dirty || self->config_in_flight || self->config_cancelled)
+    return G_SOURCE_REMOVE;
+
+  /* Heads are still coming and going (e.g. a dock got plugged in) */
+  settled = self->last_head_change + CONFIG_SETTLE_MS * G_TIME_SPAN_MILLISECOND;
+  if (g_get_monotonic_time () < settled) {
+    schedule_apply (self);
+    return G_SOURCE_REMOVE;
+  }
+
+  send_config (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+schedule_apply (PhoshMonitorManager *self)
+{
+  gint64 now, settled;
+
+  if (!self->config_dirty || self->config_in_flight || self->config_cancelled)
+    return;
+
+  if (self->config_apply_id)
+    return;
+
+  now = g_get_monotonic_time ();
+  settled = self->last_head_change + CONFIG_SETTLE_MS * G_TIME_SPAN_MILLISECOND;
+
+  if (now < settled) {
+    self->config_apply_id = g_timeout_add ((settled - now) / G_TIME_SPAN_MILLISECOND + 1,
+                                           on_apply_config,
+                                           self);
+  } else {
+    /* Merge all changes made during this main loop iteration */
+    self->config_apply_id = g_idle_add (on_apply_config, self);
+  }
+  g_source_set_name_by_id (self->config_apply_id, "[phosh] apply output config");
+}
+
+
 static void
 phosh_monitor_manager_dispose (GObject *object)
 {
@@ -1172,6 +1341,10 @@ phosh_monitor_manager_dispose (GObject *object)
   g_clear_object (&self->sensor_proxy_manager);
   g_clear_pointer (&self->sensor_proxy_binding, g_binding_unbind);
 
+  g_clear_handle_id (&self->config_apply_id, g_source_remove);
+  g_clear_pointer (&self->config_in_flight, zwlr_output_configuration_v1_destroy);
+
+
   g_clear_object (&self->gsd_color_proxy);
   g_cancellable_cancel (self->cancel);
   g_clear_object (&self->cancel);
@@ -1185,6 +1358,7 @@ phosh_monitor_manager_finalize (GObject *object)
 {
   PhoshMonitorManager *self = PHOSH_MONITOR_MANAGER (object);
 
+  g_clear_pointer (&self->current_state, g_variant_unref);
   g_ptr_array_free (self->monitors, TRUE);
   g_ptr_array_free (self->heads, TRUE);
 
@@ -1504,55 +1678,25 @@ phosh_monitor_manager_set_monitor_transform (PhoshMonitorManager *self,
  * phosh_monitor_manager_apply_monitor_config
  * @self: a #PhoshMonitorManager
  *
- * Applies a full output configuration
+ * Applies a full output configuration. The configuration is sent
+ * once the head layout settled and no other configuration is in
+ * flight. Multiple calls in between result in a single
+ * configuration.
  */
 void
 phosh_monitor_manager_apply_monitor_config (PhoshMonitorManager *self)
 {
-  PhoshWayland *wl = phosh_wayland_get_default();
-  struct zwlr_output_configuration_v1 *config;
-  struct zwlr_output_manager_v1 *output_manager =
-    phosh_wayland_get_zwlr_output_manager_v1 (wl);
-
   g_return_if_fail (PHOSH_IS_MONITOR_MANAGER (self));
 
-  config = zwlr_output_manager_v1_create_configuration (output_manager,
-                                                        self->zwlr_output_serial);
-
-  zwlr_output_configuration_v1_add_listener (config, &config_listener, self);
+  /* The configuration covers all heads */
   for (int i = 0; i < self->heads->len; i++) {
-    struct zwlr_output_configuration_head_v1 *config_head;
     PhoshHead *head = g_ptr_array_index (self->heads, i);
-    struct zwlr_output_head_v1 *wlr_head = phosh_head_get_wlr_head (head);
-    struct zwlr_output_mode_v1 *wlr_mode;
 
-    g_debug ("Adding %sabled head %s to configuration",
-             head->pending.enabled ? "en" : "dis",
-             head->name);
-
-    if (!head->pending.enabled) {
-      zwlr_output_configuration_v1_disable_head (config, wlr_head);
-      continue;
-    }
-
-    config_head = zwlr_output_configuration_v1_enable_head (config, wlr_head);
-
-    /* A disabled head might not have a mode when set */
-    if (head->pending.mode) {
-      wlr_mode = head->pending.mode->wlr_mode;
-    } else {
-      wlr_mode = phosh_head_get_preferred_mode (head)->wlr_mode;
-    }
-
-    zwlr_output_configuration_head_v1_set_mode (config_head, wlr_mode);
-    zwlr_output_configuration_head_v1_set_position (config_head,
-                                                    head->pending.x, head->pending.y);
-    zwlr_output_configuration_head_v1_set_transform (config_head, head->pending.transform);
-    zwlr_output_configuration_head_v1_set_scale (config_head,
-                                                 wl_fixed_from_double(head->pending.scale));
+    head->pending.requested = TRUE;
   }
 
-  zwlr_output_configuration_v1_apply (config);
+  self->config_dirty = TRUE;
+  schedule_apply (self);
 }
 
 void
@@ -31,6 +31,10 @@ typedef struct _PhoshHeadMode {
   int32_t                     refresh;
   gboolean                    preferred;
   char                       *name;
+
+  /* Fractional scales supported by this mode, computed once per size */
+  float                      *supported_scales;
+  int                         n_supported_scales;
 } PhoshHeadMode;
 
 struct _PhoshHead {
@@ -58,6 +62,8 @@ struct _PhoshHead {
     double scale;
     gboolean enabled;
     gboolean seen;
+    /* Holds changes not yet applied by the compositor */
+    gboolean requested;
   } pending;
 
   PhoshMonitorConnectorType conn_type;
@@ -76,6 +82,10 @@ float *                     phosh_head_calculate_supported_mode_scales (PhoshHea
                                                                         PhoshHeadMode *mode,
                                                                         int           *n,
                                                                         gboolean       fractional);
+const float *               phosh_head_mode_get_supported_scales (PhoshHeadMode *mode,
+                                                                  int           *n);
+GVariant *                  phosh_head_modes_to_variant (GPtrArray     *modes,
+                                                         PhoshHeadMode *current);
 void                        phosh_head_clear_pending (PhoshHead *self);
 void                        phosh_head_set_pending_transform (PhoshHead             *self,
                                                               PhoshMonitorTransform  transform,
@@ -53,6 +53,7 @@ phosh_head_mode_destroy (PhoshHeadMode *mode)
 
   g_clear_pointer (&mode->wlr_mode, zwlr_output_mode_v1_destroy);
   g_free (mode->name);
+  g_free (mode->supported_scales);
   g_free (mode);
 }
 
@@ -103,6 +104,14 @@ zwlr_output_mode_v1_handle_size (void *data, struct zwlr_output_mode_v1 *wlr_mod
   mode->width = width;
   mode->height = height;
   mode_name (mode);
+
+  /* Supported scales only depend on the size so calculate them once
+   * when the mode arrives rather than on every GetCurrentState call */
+  g_clear_pointer (&mode->supported_scales, g_free);
+  mode->supported_scales = phosh_head_calculate_supported_mode_scales (mode->head,
+                                                                       mode,
+                                                                       &mode->n_supported_scales,
+                                                                       TRUE);
 }
 
 
@@ -133,6 +142,11 @@ zwlr_output_mode_v1_handle_finished (void                       *data,
                                      struct zwlr_output_mode_v1 *wlr_mode)
 {
   PhoshHeadMode *mode = data;
+  PhoshHead *head = mode->head;
+
+  /* Configurations are applied deferred so don't keep stale modes around */
+  if (head->pending.mode == mode)
+    head->pending.mode = NULL;
 
   /* Array removal triggers phosh_head_mode_destroy */
   if (!g_ptr_array_remove (mode->head->modes, mode))
@@ -230,7 +244,7 @@ head_handle_enabled (void                       *data,
   PhoshHead *self = PHOSH_HEAD (data);
 
   g_return_if_fail (PHOSH_IS_HEAD (self));
-  self->enabled = self->pending.enabled = !!enabled;
+  self->enabled = !!enabled;
   g_debug ("Head %p is %sabled", self, self->enabled ? "en" : "dis");
 }
 
@@ -249,7 +263,7 @@ head_handle_current_mode (void                       *data,
 
     if (mode->wlr_mode == wlr_mode) {
       g_debug ("Head %p has current mode %p", self, mode);
-      self->mode = self->pending.mode = mode;
+      self->mode = mode;
       return;
     }
   }
@@ -267,8 +281,8 @@ head_handle_position (void *data,
 
   g_return_if_fail (PHOSH_IS_HEAD (self));
   g_debug ("Head %p has pos %d,%d", self, x, y);
-  self->x = self->pending.x = x;
-  self->y = self->pending.y = y;
+  self->x = x;
+  self->y = y;
 }
 
 
@@ -281,7 +295,7 @@ head_handle_transform (void                       *data,
 
   g_return_if_fail (PHOSH_IS_HEAD (self));
   g_debug ("Head %p has transform %d", self, transform);
-  self->transform = self->pending.transform = transform;
+  self->transform = transform;
 }
 
 
@@ -293,7 +307,7 @@ head_handle_scale (void                       *data,
   PhoshHead *self = PHOSH_HEAD (data);
 
   g_return_if_fail (PHOSH_IS_HEAD (self));
-  self->scale = self->pending.scale = wl_fixed_to_double(scale);
+  self->scale = wl_fixed_to_double(scale);
   g_debug ("Head %p has scale %f", self, self->scale);
 
 }
@@ -512,6 +526,7 @@ phosh_head_set_pending_transform (PhoshHead             *self,
   tilted = phosh_monitor_transform_is_tilted (transform);
 
   self->pending.transform = (enum wl_output_transform) transform;
+  self->pending.requested = TRUE;
 
   /* We need to adjust the positions of monitors to the right and below the transformed
      ones to avoid gaps if tilting changed */
@@ -538,6 +553,8 @@ phosh_head_set_pending_transform (PhoshHead             *self,
 
     if (move_head->pending.y > self->pending.y)
       move_head->pending.y += dy;
+
+    move_head->pending.requested = TRUE;
   }
 }
 
@@ -741,17 +758,102 @@ phosh_head_calculate_supported_mode_scales (PhoshHead     *head,
   return (float *) g_array_free (supported_scales, FALSE);
 }
 
+/**
+ * phosh_head_mode_get_supported_scales:
+ * @mode: The mode
+ * @n: (out): The number of supported scales
+ *
+ * Get the fractional scales supported by @mode. The scales are
+ * cached with the mode so this is cheap to call repeatedly.
+ *
+ * Returns: (transfer none) (array length=n): The supported scales
+ */
+const float *
+phosh_head_mode_get_supported_scales (PhoshHeadMode *mode, int *n)
+{
+  g_return_val_if_fail (mode, NULL);
+  g_return_val_if_fail (n, NULL);
+
+  if (mode->supported_scales == NULL) {
+    mode->supported_scales = phosh_head_calculate_supported_mode_scales (mode->head,
+                                                                         mode,
+                                                                         &mode->n_supported_scales,
+                                                                         TRUE);
+  }
+
+  *n = mode->n_supported_scales;
+  return mode->supported_scales;
+}
+
+/**
+ * phosh_head_modes_to_variant:
+ * @modes:(element-type PhoshHeadMode): The modes to serialize
+ * @current:(nullable): The current mode
+ *
+ * Serializes @modes as used in `GetCurrentState` of
+ * org.gnome.Mutter.DisplayConfig. Modes without a name are skipped.
+ *
+ * Returns: (transfer floating): The modes as `a(siiddada{sv})`
+ */
+GVariant *
+phosh_head_modes_to_variant (GPtrArray *modes, PhoshHeadMode *current)
+{
+  GVariantBuilder modes_builder;
+
+  g_return_val_if_fail (modes, NULL);
+
+  g_variant_builder_init (&modes_builder, G_VARIANT_TYPE ("a(siiddada{sv})"));
+
+  for (int i = 0; i < modes->len; i++) {
+    PhoshHeadMode *mode = g_ptr_array_index (modes, i);
+    GVariantBuilder supported_scales_builder, mode_properties_builder;
+    const float *scales;
+    int n;
+
+    if (!mode->name) {
+      g_warning ("Skipping unnamend mode %p", mode);
+      continue;
+    }
+
+    g_variant_builder_init (&supported_scales_builder, G_VARIANT_TYPE ("ad"));
+    scales = phosh_head_mode_get_supported_scales (mode, &n);
+    for (int j = 0; j < n; j++)
+      g_variant_builder_add (&supported_scales_builder, "d", (double)scales[j]);
+
+    g_variant_builder_init (&mode_properties_builder, G_VARIANT_TYPE ("a{sv}"));
+    g_variant_builder_add (&mode_properties_builder, "{sv}",
+                           "is-current",
+                           g_variant_new_boolean (mode == current));
+    g_variant_builder_add (&mode_properties_builder, "{sv}",
+                           "is-preferred",
+                           g_variant_new_boolean (mode->preferred));
+
+    g_variant_builder_add (&modes_builder, "(siiddada{sv})",
+                           mode->name,
+                           (gint32)mode->width,
+                           (gint32)mode->height,
+                           (double)mode->refresh / 1000.0,
+                           1.0, /* preferred_scale */
+                           &supported_scales_builder,
+                           &mode_properties_builder);
+  }
+
+  return g_variant_builder_end (&modes_builder);
+}
+
 /**
  * phosh_head_clear_pending:
  * @self: A #PhoshHead
  *
  * Clear all pending state. This can be used if e.g.  pending state
- * was set but the output configuration not submitted.
+ * was set but the output configuration not submitted. The pending
+ * state then matches the head's current state.
  */
 void
 phosh_head_clear_pending (PhoshHead *self)
 {
   self->pending.seen = FALSE;
+  self->pending.requested = FALSE;
   self->pending.x = self->x;
   self->pending.y = self->y;
   self->pending.transform = self->transform;
@@ -773,4 +875,5 @@ void
 phosh_head_set_pending_enabled (PhoshHead *self, gboolean enabled)
 {
   self->pending.enabled = enabled;
+  self->pending.requested = TRUE;
 }
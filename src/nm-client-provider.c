@@ -0,0 +1,190 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-nm-client-provider"
+
+#include "phosh-config.h"
+
+#include "nm-client-provider.h"
+
+/**
+ * PhoshNmClientProvider:
+ *
+ * Provides the shell wide `NMClient`
+ *
+ * Each `NMClient` mirrors NetworkManager's whole object tree and
+ * listens to all of its property changes so all network related
+ * consumers share a single one. It is created on first use and
+ * consumers that ask for it while it's still initializing get it once
+ * it's ready.
+ */
+
+struct _PhoshNmClientProvider {
+  GObject       parent;
+
+  NMClient     *client;
+  GCancellable *cancel;
+  /* GTasks waiting for the client */
+  GPtrArray    *pending;
+};
+G_DEFINE_TYPE (PhoshNmClientProvider, phosh_nm_client_provider, G_TYPE_OBJECT)
+
+
+static void
+on_nm_client_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GPtrArray) pending = NULL;
+  PhoshNmClientProvider *self;
+  NMClient *client;
+
+  client = nm_client_new_finish (res, &err);
+  if (client == NULL && g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  self = PHOSH_NM_CLIENT_PROVIDER (user_data);
+  self->client = client;
+
+  /* Callbacks might ask for the client again */
+  pending = g_steal_pointer (&self->pending);
+  for (guint i = 0; i < pending->len; i++) {
+    GTask *task = g_ptr_array_index (pending, i);
+
+    if (client)
+      g_task_return_pointer (task, g_object_ref (client), g_object_unref);
+    else
+      g_task_return_error (task, g_error_copy (err));
+  }
+
+  if (client)
+    g_debug ("NM client initialized");
+  else
+    g_warning ("Failed to init NM: %s", err->message);
+}
+
+
+static void
+phosh_nm_client_provider_dispose (GObject *object)
+{
+  PhoshNmClientProvider *self = PHOSH_NM_CLIENT_PROVIDER (object);
+
+  g_cancellable_cancel (self->cancel);
+  g_clear_object (&self->cancel);
+  g_clear_pointer (&self->pending, g_ptr_array_unref);
+  g_clear_object (&self->client);
+
+  G_OBJECT_CLASS (phosh_nm_client_provider_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_nm_client_provider_class_init (PhoshNmClientProviderClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = phosh_nm_client_provider_dispose;
+}
+
+
+static void
+phosh_nm_client_provider_init (PhoshNmClientProvider *self)
+{
+  self->cancel = g_cancellable_new ();
+}
+
+/**
+ * phosh_nm_client_provider_get_default:
+ *
+ * Get the NM client provider singleton
+ *
+ * Returns:(transfer none): The NM client provider singleton
+ */
+PhoshNmClientProvider *
+phosh_nm_client_provider_get_default (void)
+{
+  static PhoshNmClientProvider *instance;
+
+  if (instance == NULL) {
+    g_debug ("Creating NM client provider");
+    instance = g_object_new (PHOSH_TYPE_NM_CLIENT_PROVIDER, NULL);
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+  return instance;
+}
+
+/**
+ * phosh_nm_client_provider_get_client_async:
+ * @self: The NM client provider
+ * @cancellable: (nullable): A cancellable
+ * @callback: The callback to invoke once the client is ready
+ * @user_data: The data passed to the callback
+ *
+ * Get the shared `NMClient`. The client is created if nobody asked
+ * for it yet. Cancelling @cancellable only affects this caller.
+ */
+void
+phosh_nm_client_provider_get_client_async (PhoshNmClientProvider *self,
+                                           GCancellable          *cancellable,
+                                           GAsyncReadyCallback    callback,
+                                           gpointer               user_data)
+{
+  g_autoptr (GTask) task = NULL;
+
+  g_return_if_fail (PHOSH_IS_NM_CLIENT_PROVIDER (self));
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, phosh_nm_client_provider_get_client_async);
+
+  if (self->client) {
+    g_task_return_pointer (task, g_object_ref (self->client), g_object_unref);
+    return;
+  }
+
+  if (self->pending == NULL) {
+    self->pending = g_ptr_array_new_with_free_func (g_object_unref);
+    nm_client_new_async (self->cancel, on_nm_client_ready, self);
+  }
+
+  g_ptr_array_add (self->pending, g_steal_pointer (&task));
+}
+
+/**
+ * phosh_nm_client_provider_get_client_finish:
+ * @self: The NM client provider
+ * @res: The async result
+ * @error: The return location for errors
+ *
+ * Finish an operation started by
+ * [method@NmClientProvider.get_client_async].
+ *
+ * Returns:(transfer full): The shared NM client or %NULL on error
+ */
+NMClient *
+phosh_nm_client_provider_get_client_finish (PhoshNmClientProvider  *self,
+                                            GAsyncResult           *res,
+                                            GError                **error)
+{
+  g_return_val_if_fail (PHOSH_IS_NM_CLIENT_PROVIDER (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * phosh_nm_client_provider_get_client:
+ * @self: The NM client provider
+ *
+ * Get the shared `NMClient` if it's already initialized.
+ *
+ * Returns:(transfer none)(nullable): The shared NM client
+ */
+NMClient *
+phosh_nm_client_provider_get_client (PhoshNmClientProvider *self)
+{
+  g_return_val_if_fail (PHOSH_IS_NM_CLIENT_PROVIDER (self), NULL);
+
+  return self->client;
+}
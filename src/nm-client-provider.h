@@ -0,0 +1,28 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <NetworkManager.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_NM_CLIENT_PROVIDER (phosh_nm_client_provider_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshNmClientProvider, phosh_nm_client_provider, PHOSH, NM_CLIENT_PROVIDER,
+                      GObject)
+
+PhoshNmClientProvider *phosh_nm_client_provider_get_default       (void);
+void                   phosh_nm_client_provider_get_client_async  (PhoshNmClientProvider *self,
+                                                                   GCancellable          *cancellable,
+                                                                   GAsyncReadyCallback    callback,
+                                                                   gpointer               user_data);
+NMClient              *phosh_nm_client_provider_get_client_finish (PhoshNmClientProvider *self,
+                                                                   GAsyncResult          *res,
+                                                                   GError               **error);
+NMClient              *phosh_nm_client_provider_get_client        (PhoshNmClientProvider *self);
+
+G_END_DECLS
@@ -9,6 +9,7 @@
 #define G_LOG_DOMAIN "phosh-notification-banner"
 
 #include "phosh-config.h"
+#include "animation.h"
 #include "notification-banner.h"
 #include "notification-frame.h"
 #include "shell.h"
@@ -37,10 +38,7 @@ struct _PhoshNotificationBanner {
   gulong handler_expired;
   gulong handler_closed;
 
-  struct {
-    double progress;
-    gint64  last_frame;
-  } animation;
+  PhoshAnimation    *animation;
 };
 typedef struct _PhoshNotificationBanner PhoshNotificationBanner;
 
@@ -154,22 +152,20 @@ phosh_notification_banner_finalize (GObject *object)
   clear_handler (self);
 
   g_clear_object (&self->notification);
+  g_clear_pointer (&self->animation, phosh_animation_unref);
 
   G_OBJECT_CLASS (phosh_notification_banner_parent_class)->finalize (object);
 }
 
 
 static void
-phosh_notification_banner_slide (PhoshNotificationBanner *self)
+animation_value_cb (double value, PhoshNotificationBanner *self)
 {
   int margin;
   int height;
-  double progress = hdy_ease_out_cubic (self->animation.progress);
-
-  progress = 1.0 - progress;
 
   gtk_window_get_size (GTK_WINDOW (self), NULL, &height);
-  margin = (height - 300) * progress;
+  margin = (height - 300) * (1.0 - value);
 
   phosh_layer_surface_set_margins (PHOSH_LAYER_SURFACE (self), margin, 0, 0, 0);
 
@@ -177,47 +173,21 @@ phosh_notification_banner_slide (PhoshNotificationBanner *self)
 }
 
 
-static gboolean
-animate_down_cb (GtkWidget     *widget,
-                 GdkFrameClock *frame_clock,
-                 gpointer       user_data)
+static void
+animation_done_cb (PhoshNotificationBanner *self)
 {
-  gint64 time;
-  gboolean finished = FALSE;
-  PhoshNotificationBanner *self = PHOSH_NOTIFICATION_BANNER (widget);
-
-  time = gdk_frame_clock_get_frame_time (frame_clock) - self->animation.last_frame;
-  if (self->animation.last_frame < 0) {
-    time = 0;
-  }
-
-  self->animation.progress += 0.06666 * time / 16666.00;
-  self->animation.last_frame = gdk_frame_clock_get_frame_time (frame_clock);
-
-  if (self->animation.progress >= 1.0) {
-    finished = TRUE;
-    self->animation.progress = 1.0;
-  }
-
-  phosh_notification_banner_slide (self);
-
-  return finished ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
 }
 
 
 static void
-phosh_notification_banner_show (GtkWidget *widget)
+phosh_notification_banner_map (GtkWidget *widget)
 {
   PhoshNotificationBanner *self = PHOSH_NOTIFICATION_BANNER (widget);
-  gboolean enable_animations;
-
-  enable_animations = hdy_get_enable_animations (GTK_WIDGET (self));
 
-  self->animation.last_frame = -1;
-  self->animation.progress = enable_animations ? 0.0 : 1.0;
-  gtk_widget_add_tick_callback (GTK_WIDGET (self), animate_down_cb, NULL, NULL);
+  GTK_WIDGET_CLASS (phosh_notification_banner_parent_class)->map (widget);
 
-  GTK_WIDGET_CLASS (phosh_notification_banner_parent_class)->show (widget);
+  /* Slide down */
+  phosh_animation_start (self->animation);
 }
 
 
@@ -231,7 +201,7 @@ phosh_notification_banner_class_init (PhoshNotificationBannerClass *klass)
   object_class->set_property = phosh_notification_banner_set_property;
   object_class->get_property = phosh_notification_banner_get_property;
 
-  widget_class->show = phosh_notification_banner_show;
+  widget_class->map = phosh_notification_banner_map;
 
   /**
    * PhoshNotificationBanner:notification:
@@ -256,7 +226,14 @@ phosh_notification_banner_class_init (PhoshNotificationBannerClass *klass)
 static void
 phosh_notification_banner_init (PhoshNotificationBanner *self)
 {
-  self->animation.progress = 0.0;
+  self->animation = phosh_animation_new (GTK_WIDGET (self),
+                                         0.0,
+                                         1.0,
+                                         250 * PHOSH_ANIMATION_SLOWDOWN,
+                                         PHOSH_ANIMATION_TYPE_EASE_OUT_CUBIC,
+                                         (PhoshAnimationValueCallback) animation_value_cb,
+                                         (PhoshAnimationDoneCallback) animation_done_cb,
+                                         self);
 }
 
 
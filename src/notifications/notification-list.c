@@ -11,6 +11,7 @@
 #include "phosh-config.h"
 #include "notification-source.h"
 #include "notification-list.h"
+#include "memory-accounting.h"
 
 /**
  * PhoshNotificationList:
@@ -127,6 +128,35 @@ list_iface_init (GListModelInterface *iface)
 }
 
 
+static guint64
+get_icon_bytes (GIcon *icon)
+{
+  if (GDK_IS_PIXBUF (icon))
+    return gdk_pixbuf_get_byte_length (GDK_PIXBUF (icon));
+
+  if (G_IS_BYTES_ICON (icon))
+    return g_bytes_get_size (g_bytes_icon_get_bytes (G_BYTES_ICON (icon)));
+
+  return 0;
+}
+
+
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshNotificationList *self = PHOSH_NOTIFICATION_LIST (owner);
+  GHashTableIter iter;
+  PhoshNotification *notification;
+
+  g_hash_table_iter_init (&iter, self->notifications);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&notification)) {
+    report->bytes += get_icon_bytes (phosh_notification_get_app_icon (notification));
+    report->bytes += get_icon_bytes (phosh_notification_get_image (notification));
+    report->objects++;
+  }
+}
+
+
 static void
 phosh_notification_list_init (PhoshNotificationList *self)
 {
@@ -141,6 +171,12 @@ phosh_notification_list_init (PhoshNotificationList *self)
                                                g_direct_equal,
                                                NULL,
                                                NULL);
+
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "notifications",
+                                        G_OBJECT (self),
+                                        report_memory,
+                                        NULL);
 }
 
 
@@ -9,6 +9,7 @@
 #include "timestamp-label.h"
 #include "timestamp-label-priv.h"
 #include "phosh-config.h"
+#include "wakeup-scheduler.h"
 #include <glib/gi18n.h>
 
 /**
@@ -254,10 +255,13 @@ phosh_timestamp_label_update (PhoshTimestampLabel *self)
 
     g_clear_handle_id (&(self->refresh_time), g_source_remove);
     time = phosh_timestamp_label_calc_timeout (self);
-    self->refresh_time = g_timeout_add (time/ G_TIME_SPAN_MILLISECOND,
-                                        (GSourceFunc) phosh_timestamp_label_update,
-                                        self);
-    g_source_set_name_by_id (self->refresh_time, "[PhoshTimestampLable] refresh");
+    self->refresh_time = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                                     "[PhoshTimestampLabel] refresh",
+                                                     (time + G_TIME_SPAN_SECOND - 1) /
+                                                     G_TIME_SPAN_SECOND,
+                                                     PHOSH_WAKEUP_FLAG_UI,
+                                                     (GSourceFunc) phosh_timestamp_label_update,
+                                                     self);
   } else {
     gtk_label_set_label (GTK_LABEL (self), "");
 
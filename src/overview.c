@@ -13,6 +13,7 @@
 #include "activity.h"
 #include "app-grid-button.h"
 #include "app-grid.h"
+#include "memory-accounting.h"
 #include "overview.h"
 #include "wlr-screencopy-unstable-v1-client-protocol.h"
 #include "phosh-private-client-protocol.h"
@@ -36,6 +37,10 @@
  *
  * The #PhoshOverview shows running apps (#PhoshActivity) and
  * the app grid (#PhoshAppGrid) to launch new applications.
+ *
+ * The running activities follow the toplevel manager's list model.
+ * Activities of closed toplevels are kept per app-id so a new window of
+ * the same app can reuse them.
  */
 
 enum {
@@ -61,6 +66,10 @@ typedef struct
   GtkWidget *carousel_running_activities;
   GtkWidget *app_grid;
   PhoshActivity *activity;
+  /* PhoshToplevel → PhoshActivity */
+  GHashTable    *activities;
+  /* Unused activities for reuse by app-id and parent app-id */
+  GHashTable    *activity_pool;
 
   int       has_activities;
 } PhoshOverviewPrivate;
@@ -110,19 +119,10 @@ static PhoshActivity *
 find_activity_by_toplevel (PhoshOverview        *self,
                            PhoshToplevel        *needle)
 {
-  g_autoptr(GList) children;
-  PhoshActivity *activity = NULL;
+  PhoshActivity *activity;
   PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (self);
 
-  children = gtk_container_get_children (GTK_CONTAINER (priv->carousel_running_activities));
-  for (GList *l = children; l; l = l->next) {
-    PhoshToplevel *toplevel;
-
-    activity = PHOSH_ACTIVITY (l->data);
-    toplevel = get_toplevel_from_activity (activity);
-    if (toplevel == needle)
-      break;
-  }
+  activity = g_hash_table_lookup (priv->activities, needle);
 
   g_return_val_if_fail (activity, NULL);
   return activity;
@@ -178,38 +178,37 @@ on_activity_closed (PhoshOverview *self, PhoshActivity *activity)
 
 
 static void
-on_toplevel_closed (PhoshToplevel *toplevel, PhoshOverview *overview)
+on_toplevel_activated_changed (PhoshToplevel *toplevel, GParamSpec *pspec, PhoshOverview *overview)
 {
   PhoshActivity *activity;
   PhoshOverviewPrivate *priv;
-
-  g_return_if_fail (PHOSH_IS_TOPLEVEL (toplevel));
   g_return_if_fail (PHOSH_IS_OVERVIEW (overview));
+  g_return_if_fail (PHOSH_IS_TOPLEVEL (toplevel));
   priv = phosh_overview_get_instance_private (overview);
 
-  activity = find_activity_by_toplevel (overview, toplevel);
-  g_return_if_fail (PHOSH_IS_ACTIVITY (activity));
-  gtk_widget_destroy (GTK_WIDGET (activity));
-
-  if (priv->activity == activity)
-    priv->activity = NULL;
+  if (phosh_toplevel_is_activated (toplevel)) {
+    activity = find_activity_by_toplevel (overview, toplevel);
+    priv->activity = activity;
+    scroll_to_activity (overview, activity);
+  }
 }
 
 
 static void
-on_toplevel_activated_changed (PhoshToplevel *toplevel, GParamSpec *pspec, PhoshOverview *overview)
+on_toplevel_state_changed (PhoshToplevel *toplevel, GParamSpec *pspec, PhoshOverview *overview)
 {
   PhoshActivity *activity;
-  PhoshOverviewPrivate *priv;
+
   g_return_if_fail (PHOSH_IS_OVERVIEW (overview));
   g_return_if_fail (PHOSH_IS_TOPLEVEL (toplevel));
-  priv = phosh_overview_get_instance_private (overview);
 
-  if (phosh_toplevel_is_activated (toplevel)) {
-    activity = find_activity_by_toplevel (overview, toplevel);
-    priv->activity = activity;
-    scroll_to_activity (overview, activity);
-  }
+  activity = find_activity_by_toplevel (overview, toplevel);
+  g_return_if_fail (activity);
+
+  g_object_set (activity,
+                "maximized", phosh_toplevel_is_maximized (toplevel),
+                "fullscreen", phosh_toplevel_is_fullscreen (toplevel),
+                NULL);
 }
 
 
@@ -239,8 +238,14 @@ request_thumbnail (PhoshActivity *activity, PhoshToplevel *toplevel)
 
 
 static void
-on_activity_resized (PhoshActivity *activity, GtkAllocation *alloc, PhoshToplevel *toplevel)
+on_activity_resized (PhoshOverview *self, GtkAllocation *alloc, PhoshActivity *activity)
 {
+  PhoshToplevel *toplevel = g_object_get_data (G_OBJECT (activity), "toplevel");
+
+  /* Unused activity */
+  if (toplevel == NULL)
+    return;
+
   request_thumbnail (activity, toplevel);
 }
 
@@ -259,16 +264,47 @@ on_activity_has_focus_changed (PhoshOverview *self, GParamSpec *pspec, PhoshActi
 }
 
 
+static char *
+get_activity_pool_key (const char *app_id, const char *parent_app_id)
+{
+  return g_strdup_printf ("%s/%s", app_id ?: "", parent_app_id ?: "");
+}
+
+
+static GtkWidget *
+create_activity (PhoshOverview *self, const char *app_id, const char *parent_app_id)
+{
+  GtkWidget *activity;
+
+  activity = g_object_new (PHOSH_TYPE_ACTIVITY,
+                           "app-id", app_id,
+                           "parent-app-id", parent_app_id,
+                           NULL);
+
+  g_signal_connect_swapped (activity, "clicked", G_CALLBACK (on_activity_clicked), self);
+  g_signal_connect_swapped (activity, "closed", G_CALLBACK (on_activity_closed), self);
+  g_signal_connect_swapped (activity, "resized", G_CALLBACK (on_activity_resized), self);
+  g_signal_connect_swapped (activity, "notify::has-focus", G_CALLBACK (on_activity_has_focus_changed), self);
+
+  phosh_connect_feedback (activity);
+
+  return g_object_ref_sink (activity);
+}
+
+
 static void
-add_activity (PhoshOverview *self, PhoshToplevel *toplevel)
+insert_activity (PhoshOverview *self, PhoshToplevel *toplevel, int position)
 {
   PhoshOverviewPrivate *priv;
-  GtkWidget *activity;
+  g_autoptr (GtkWidget) activity = NULL;
+  g_autofree char *key = NULL;
+  g_autofree char *pooled_key = NULL;
   const char *app_id, *title;
   const char *parent_app_id = NULL;
   int width, height;
   PhoshToplevelManager *m = phosh_shell_get_toplevel_manager (phosh_shell_get_default ());
   PhoshToplevel *parent = NULL;
+  gboolean reused;
 
   g_return_if_fail (PHOSH_IS_OVERVIEW (self));
   priv = phosh_overview_get_instance_private (self);
@@ -281,33 +317,36 @@ add_activity (PhoshOverview *self, PhoshToplevel *toplevel)
   if (parent)
     parent_app_id = phosh_toplevel_get_app_id (parent);
 
-  g_debug ("Building activator for '%s' (%s)", app_id, title);
+  key = get_activity_pool_key (app_id, parent_app_id);
+  reused = g_hash_table_steal_extended (priv->activity_pool, key,
+                                        (gpointer *)&pooled_key, (gpointer *)&activity);
+  if (reused) {
+    g_debug ("Reusing activator for '%s' (%s)", app_id, title);
+  } else {
+    g_debug ("Building activator for '%s' (%s)", app_id, title);
+    activity = create_activity (self, app_id, parent_app_id);
+  }
+
   phosh_shell_get_usable_area (phosh_shell_get_default (), NULL, NULL, &width, &height);
-  activity = g_object_new (PHOSH_TYPE_ACTIVITY,
-                           "app-id", app_id,
-                           "parent-app-id", parent_app_id,
-                           "win-width", width,
-                           "win-height", height,
-                           "maximized", phosh_toplevel_is_maximized (toplevel),
-                           "fullscreen", phosh_toplevel_is_fullscreen (toplevel),
-                           NULL);
+  g_object_set (activity,
+                "win-width", width,
+                "win-height", height,
+                "maximized", phosh_toplevel_is_maximized (toplevel),
+                "fullscreen", phosh_toplevel_is_fullscreen (toplevel),
+                NULL);
   g_object_set_data (G_OBJECT (activity), "toplevel", toplevel);
+  g_hash_table_insert (priv->activities, toplevel, activity);
 
-  gtk_container_add (GTK_CONTAINER (priv->carousel_running_activities), activity);
+  hdy_carousel_insert (HDY_CAROUSEL (priv->carousel_running_activities), activity, position);
   gtk_widget_show (activity);
 
-  g_signal_connect_swapped (activity, "clicked", G_CALLBACK (on_activity_clicked), self);
-  g_signal_connect_swapped (activity, "closed", G_CALLBACK (on_activity_closed), self);
-
-  g_signal_connect_object (toplevel, "closed", G_CALLBACK (on_toplevel_closed), self, 0);
   g_signal_connect_object (toplevel, "notify::activated", G_CALLBACK (on_toplevel_activated_changed), self, 0);
-  g_object_bind_property (toplevel, "maximized", activity, "maximized", G_BINDING_DEFAULT);
-  g_object_bind_property (toplevel, "fullscreen", activity, "fullscreen", G_BINDING_DEFAULT);
-
-  g_signal_connect (activity, "resized", G_CALLBACK (on_activity_resized), toplevel);
-  g_signal_connect_swapped (activity, "notify::has-focus", G_CALLBACK (on_activity_has_focus_changed), self);
+  g_signal_connect_object (toplevel, "notify::maximized", G_CALLBACK (on_toplevel_state_changed), self, 0);
+  g_signal_connect_object (toplevel, "notify::fullscreen", G_CALLBACK (on_toplevel_state_changed), self, 0);
 
-  phosh_connect_feedback (activity);
+  /* A reused activity keeps its size so won't emit "resized" */
+  if (reused)
+    request_thumbnail (PHOSH_ACTIVITY (activity), toplevel);
 
   if (phosh_toplevel_is_activated (toplevel)) {
     scroll_to_activity (self, PHOSH_ACTIVITY (activity));
@@ -317,34 +356,73 @@ add_activity (PhoshOverview *self, PhoshToplevel *toplevel)
 
 
 static void
-get_running_activities (PhoshOverview *self)
+release_activity (PhoshOverview *self, PhoshActivity *activity)
 {
-  PhoshOverviewPrivate *priv;
-  PhoshToplevelManager *toplevel_manager = phosh_shell_get_toplevel_manager (phosh_shell_get_default ());
-  guint toplevels_num = phosh_toplevel_manager_get_num_toplevels (toplevel_manager);
-  g_return_if_fail (PHOSH_IS_OVERVIEW (self));
-  priv = phosh_overview_get_instance_private (self);
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (self);
+  PhoshToplevel *toplevel = get_toplevel_from_activity (activity);
+  g_autofree char *key = NULL;
+  g_autofree char *parent_app_id = NULL;
 
-  priv->has_activities = !!toplevels_num;
-  if (toplevels_num == 0)
-    gtk_widget_hide (priv->carousel_running_activities);
+  g_signal_handlers_disconnect_by_data (toplevel, self);
+  g_hash_table_remove (priv->activities, toplevel);
+  g_object_set_data (G_OBJECT (activity), "toplevel", NULL);
+
+  if (priv->activity == activity)
+    priv->activity = NULL;
+
+  /* Don't show the closed window's thumbnail for the next one */
+  phosh_activity_reset (activity);
+
+  g_object_get (activity, "parent-app-id", &parent_app_id, NULL);
+  key = get_activity_pool_key (phosh_activity_get_app_id (activity), parent_app_id);
+  g_hash_table_replace (priv->activity_pool, g_steal_pointer (&key), g_object_ref (activity));
+
+  gtk_container_remove (GTK_CONTAINER (priv->carousel_running_activities), GTK_WIDGET (activity));
+}
+
+
+static void
+on_toplevels_changed (PhoshOverview *self,
+                      guint          position,
+                      guint          removed,
+                      guint          added,
+                      GListModel    *toplevels)
+{
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (self);
+  g_autoptr (GList) children = NULL;
+  GList *l;
+
+  children = gtk_container_get_children (GTK_CONTAINER (priv->carousel_running_activities));
+  l = g_list_nth (children, position);
+  for (guint i = 0; i < removed && l; i++, l = l->next)
+    release_activity (self, PHOSH_ACTIVITY (l->data));
 
-  for (guint i = 0; i < toplevels_num; i++) {
-    PhoshToplevel *toplevel = phosh_toplevel_manager_get_toplevel (toplevel_manager, i);
-    add_activity (self, toplevel);
+  for (guint i = 0; i < added; i++) {
+    g_autoptr (PhoshToplevel) toplevel = g_list_model_get_item (toplevels, position + i);
+
+    insert_activity (self, toplevel, position + i);
   }
 }
 
 
 static void
-toplevel_added_cb (PhoshOverview        *self,
-                   PhoshToplevel        *toplevel,
-                   PhoshToplevelManager *manager)
+bind_running_activities (PhoshOverview *self)
 {
+  PhoshOverviewPrivate *priv;
+  PhoshToplevelManager *toplevel_manager = phosh_shell_get_toplevel_manager (phosh_shell_get_default ());
+  guint toplevels_num = g_list_model_get_n_items (G_LIST_MODEL (toplevel_manager));
   g_return_if_fail (PHOSH_IS_OVERVIEW (self));
-  g_return_if_fail (PHOSH_IS_TOPLEVEL (toplevel));
-  g_return_if_fail (PHOSH_IS_TOPLEVEL_MANAGER (manager));
-  add_activity (self, toplevel);
+  priv = phosh_overview_get_instance_private (self);
+
+  priv->has_activities = !!toplevels_num;
+  if (toplevels_num == 0)
+    gtk_widget_hide (priv->carousel_running_activities);
+
+  g_signal_connect_object (toplevel_manager, "items-changed",
+                           G_CALLBACK (on_toplevels_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  on_toplevels_changed (self, 0, 0, toplevels_num, G_LIST_MODEL (toplevel_manager));
 }
 
 
@@ -464,11 +542,6 @@ phosh_overview_constructed (GObject *object)
 
   G_OBJECT_CLASS (phosh_overview_parent_class)->constructed (object);
 
-  g_signal_connect_object (toplevel_manager, "toplevel-added",
-                           G_CALLBACK (toplevel_added_cb),
-                           self,
-                           G_CONNECT_SWAPPED);
-
   g_signal_connect_object (toplevel_manager, "toplevel-changed",
                            G_CALLBACK (toplevel_changed_cb),
                            self,
@@ -479,7 +552,7 @@ phosh_overview_constructed (GObject *object)
                            self,
                            G_CONNECT_SWAPPED);
 
-  get_running_activities (self);
+  bind_running_activities (self);
 
   g_signal_connect_swapped (priv->app_grid, "app-launched",
                             G_CALLBACK (app_launched_cb), self);
@@ -489,6 +562,53 @@ phosh_overview_constructed (GObject *object)
 }
 
 
+static void
+report_activity_pool (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (PHOSH_OVERVIEW (owner));
+
+  if (priv->activity_pool)
+    report->objects += g_hash_table_size (priv->activity_pool);
+}
+
+
+static void
+evict_activity_pool (GObject *owner, PhoshMemoryPressure pressure)
+{
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (PHOSH_OVERVIEW (owner));
+
+  /* Pooled activities are off-screen */
+  if (priv->activity_pool) {
+    g_debug ("Dropping %u pooled activities", g_hash_table_size (priv->activity_pool));
+    g_hash_table_remove_all (priv->activity_pool);
+  }
+}
+
+
+static void
+phosh_overview_dispose (GObject *object)
+{
+  PhoshOverview *self = PHOSH_OVERVIEW (object);
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (self);
+
+  g_clear_pointer (&priv->activity_pool, g_hash_table_unref);
+
+  G_OBJECT_CLASS (phosh_overview_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_overview_finalize (GObject *object)
+{
+  PhoshOverview *self = PHOSH_OVERVIEW (object);
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (self);
+
+  g_clear_pointer (&priv->activities, g_hash_table_unref);
+
+  G_OBJECT_CLASS (phosh_overview_parent_class)->finalize (object);
+}
+
+
 static void
 phosh_overview_class_init (PhoshOverviewClass *klass)
 {
@@ -496,6 +616,8 @@ phosh_overview_class_init (PhoshOverviewClass *klass)
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
   object_class->constructed = phosh_overview_constructed;
+  object_class->dispose = phosh_overview_dispose;
+  object_class->finalize = phosh_overview_finalize;
   object_class->get_property = phosh_overview_get_property;
   widget_class->size_allocate = phosh_overview_size_allocate;
 
@@ -535,6 +657,16 @@ phosh_overview_class_init (PhoshOverviewClass *klass)
 static void
 phosh_overview_init (PhoshOverview *self)
 {
+  PhoshOverviewPrivate *priv = phosh_overview_get_instance_private (self);
+
+  priv->activities = g_hash_table_new (g_direct_hash, g_direct_equal);
+  priv->activity_pool = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "activity-pool",
+                                        G_OBJECT (self),
+                                        report_activity_pool,
+                                        evict_activity_pool);
+
   gtk_widget_init_template (GTK_WIDGET (self));
 }
 
@@ -23,23 +23,61 @@ enum {
 };
 static GParamSpec *props[PROP_LAST_PROP];
 
+#define PLUGIN_GROUP "Plugin"
+/* Number of draws over budget until a plugin gets flagged */
+#define MAX_DRAWS_OVER_BUDGET 3
+
 /**
  * PhoshPluginLoader:
  *
  * Loads plugins for a given extension point
  *
+ * The plugins' `.plugin` files are read into an index on first use.
+ * Modules are only loaded once a plugin gets instantiated so
+ * installed but unused plugins don't cost startup time or memory.
+ *
+ * The time spent loading, constructing, mapping and drawing each plugin
+ * is recorded. Plugins exceeding the frame budget get flagged so
+ * consumers can defer loading them.
+ *
  * Since: 0.21.0
  */
 
 struct _PhoshPluginLoader {
-  GObject parent;
+  GObject     parent;
 
-  GStrv   plugin_dirs;
-  char   *extension_point;
+  GStrv       plugin_dirs;
+  char       *extension_point;
+  /* Plugin name to module path */
+  GHashTable *index;
+  GSettings  *settings;
 };
 
+typedef struct {
+  char     *extension_point;
+  char     *name;
+  gint64    load_us;
+  gint64    construct_us;
+  gint64    map_us;
+  guint     n_draws;
+  gint64    draw_start;
+  gint64    draw_total_us;
+  gint64    draw_max_us;
+  guint     n_draws_over_budget;
+  gboolean  flagged;
+} PluginStats;
+
 G_DEFINE_TYPE (PhoshPluginLoader, phosh_plugin_loader, G_TYPE_OBJECT)
 
+/* Module path to GIOModule, shared by all loaders as types can only be registered once */
+static GHashTable *modules;
+/* Extension point and plugin name to PluginStats */
+static GHashTable *plugin_stats;
+static gint64 frame_budget_us = 16 * G_TIME_SPAN_MILLISECOND;
+static GQuark stats_quark;
+static GQuark instrumented_quark;
+
+
 static void
 phosh_plugin_loader_set_property (GObject      *object,
                                   guint         property_id,
@@ -86,6 +124,260 @@ phosh_plugin_loader_get_property (GObject    *object,
 }
 
 
+static PluginStats *
+get_plugin_stats (PhoshPluginLoader *self, const char *name)
+{
+  g_autofree char *key = g_strdup_printf ("%s/%s", self->extension_point, name);
+  PluginStats *stats;
+
+  if (plugin_stats == NULL)
+    plugin_stats = g_hash_table_new (g_str_hash, g_str_equal);
+
+  stats = g_hash_table_lookup (plugin_stats, key);
+  if (stats == NULL) {
+    /* Widgets reference their stats so these are never freed */
+    stats = g_new0 (PluginStats, 1);
+    stats->extension_point = g_strdup (self->extension_point);
+    stats->name = g_strdup (name);
+    g_hash_table_insert (plugin_stats, g_steal_pointer (&key), stats);
+  }
+
+  return stats;
+}
+
+
+static void
+flag_plugin (PluginStats *stats, const char *what, gint64 us)
+{
+  if (stats->flagged)
+    return;
+
+  g_message ("Plugin '%s' exceeded the frame budget during %s (%.1fms)",
+             stats->name, what, us / 1000.0);
+  stats->flagged = TRUE;
+}
+
+
+/*
+ * GtkWidget::map is run first so connected handlers only run after
+ * the widget got mapped. Override the class handler and chain up to
+ * time it instead.
+ */
+static void
+time_plugin_map (GtkWidget *widget)
+{
+  PluginStats *stats = g_object_get_qdata (G_OBJECT (widget), stats_quark);
+  gint64 start = g_get_monotonic_time ();
+
+  g_signal_chain_from_overridden_handler (widget);
+
+  if (stats == NULL)
+    return;
+
+  stats->map_us = g_get_monotonic_time () - start;
+  if (stats->map_us > frame_budget_us)
+    flag_plugin (stats, "map", stats->map_us);
+}
+
+
+static gboolean
+on_plugin_draw (GtkWidget *widget, cairo_t *cr, PluginStats *stats)
+{
+  stats->draw_start = g_get_monotonic_time ();
+  return GDK_EVENT_PROPAGATE;
+}
+
+
+static gboolean
+on_plugin_draw_after (GtkWidget *widget, cairo_t *cr, PluginStats *stats)
+{
+  gint64 us;
+
+  if (stats->draw_start == 0)
+    return GDK_EVENT_PROPAGATE;
+
+  us = g_get_monotonic_time () - stats->draw_start;
+  stats->draw_start = 0;
+
+  stats->n_draws++;
+  stats->draw_total_us += us;
+  stats->draw_max_us = MAX (stats->draw_max_us, us);
+
+  if (us > frame_budget_us) {
+    stats->n_draws_over_budget++;
+    if (stats->n_draws_over_budget >= MAX_DRAWS_OVER_BUDGET)
+      flag_plugin (stats, "draw", us);
+  }
+
+  return GDK_EVENT_PROPAGATE;
+}
+
+
+static void
+instrument_plugin (GtkWidget *widget, PluginStats *stats)
+{
+  GType type = G_OBJECT_TYPE (widget);
+
+  if (stats_quark == 0) {
+    stats_quark = g_quark_from_static_string ("phosh-plugin-stats");
+    instrumented_quark = g_quark_from_static_string ("phosh-plugin-instrumented");
+  }
+
+  /* Like the module the type stays around so this only happens once */
+  if (g_type_get_qdata (type, instrumented_quark) == NULL) {
+    g_signal_override_class_handler ("map", type, G_CALLBACK (time_plugin_map));
+    g_type_set_qdata (type, instrumented_quark, GINT_TO_POINTER (TRUE));
+  }
+  g_object_set_qdata (G_OBJECT (widget), stats_quark, stats);
+
+  g_signal_connect (widget, "draw", G_CALLBACK (on_plugin_draw), stats);
+  g_signal_connect_after (widget, "draw", G_CALLBACK (on_plugin_draw_after), stats);
+}
+
+
+static void
+on_frame_budget_changed (PhoshPluginLoader *self)
+{
+  frame_budget_us = g_settings_get_uint (self->settings, "frame-budget") * G_TIME_SPAN_MILLISECOND;
+}
+
+
+static const char *
+get_plugin_type (PhoshPluginLoader *self)
+{
+  if (g_str_equal (self->extension_point, PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET))
+    return "lockscreen";
+  if (g_str_equal (self->extension_point, PHOSH_EXTENSION_POINT_QUICK_SETTING_WIDGET))
+    return "quick-setting";
+
+  return NULL;
+}
+
+
+static void
+index_plugin (PhoshPluginLoader *self, const char *dir, const char *filename)
+{
+  g_autoptr (GKeyFile) keyfile = g_key_file_new ();
+  g_autoptr (GError) err = NULL;
+  g_autofree char *path = g_build_filename (dir, filename, NULL);
+  g_autofree char *id = NULL;
+  g_autofree char *module = NULL;
+  g_autofree char *basename = NULL;
+  g_autofree char *local = NULL;
+  g_auto (GStrv) types = NULL;
+  const char *type = get_plugin_type (self);
+
+  if (!g_key_file_load_from_file (keyfile, path, G_KEY_FILE_NONE, &err)) {
+    g_warning ("Failed to load plugin info '%s': %s", path, err->message);
+    return;
+  }
+
+  id = g_key_file_get_string (keyfile, PLUGIN_GROUP, "Id", NULL);
+  module = g_key_file_get_string (keyfile, PLUGIN_GROUP, "Plugin", NULL);
+  if (id == NULL || module == NULL)
+    return;
+
+  types = g_key_file_get_string_list (keyfile, PLUGIN_GROUP, "Types", NULL, NULL);
+  if (type && !(types && g_strv_contains ((const char * const *)types, type)))
+    return;
+
+  /* First plugin dir wins */
+  if (g_hash_table_contains (self->index, id))
+    return;
+
+  /* Prefer a module next to its metadata, e.g. when running from the build dir */
+  basename = g_path_get_basename (module);
+  local = g_build_filename (dir, basename, NULL);
+  if (g_file_test (local, G_FILE_TEST_EXISTS))
+    g_hash_table_insert (self->index, g_steal_pointer (&id), g_steal_pointer (&local));
+  else
+    g_hash_table_insert (self->index, g_steal_pointer (&id), g_steal_pointer (&module));
+}
+
+
+static void
+ensure_index (PhoshPluginLoader *self)
+{
+  if (self->index)
+    return;
+
+  self->index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  for (int i = 0; self->plugin_dirs && self->plugin_dirs[i]; i++) {
+    g_autoptr (GDir) dir = g_dir_open (self->plugin_dirs[i], 0, NULL);
+    const char *filename;
+
+    if (dir == NULL)
+      continue;
+
+    g_debug ("Indexing plugins in '%s' for '%s'", self->plugin_dirs[i], self->extension_point);
+    while ((filename = g_dir_read_name (dir))) {
+      if (g_str_has_suffix (filename, ".plugin"))
+        index_plugin (self, self->plugin_dirs[i], filename);
+    }
+  }
+}
+
+
+static char *
+find_module (PhoshPluginLoader *self, const char *name)
+{
+  const char *path;
+
+  ensure_index (self);
+
+  path = g_hash_table_lookup (self->index, name);
+  if (path)
+    return g_strdup (path);
+
+  /* Plugins without metadata */
+  for (int i = 0; self->plugin_dirs && self->plugin_dirs[i]; i++) {
+    g_autofree char *filename = g_strdup_printf ("libphosh-plugin-%s.%s", name, G_MODULE_SUFFIX);
+    g_autofree char *fallback = g_build_filename (self->plugin_dirs[i], filename, NULL);
+
+    if (g_file_test (fallback, G_FILE_TEST_EXISTS))
+      return g_steal_pointer (&fallback);
+  }
+
+  return NULL;
+}
+
+
+static gboolean
+load_module (PhoshPluginLoader *self, const char *name)
+{
+  g_autofree char *path = NULL;
+  GIOModule *module;
+  PluginStats *stats;
+  gint64 start;
+
+  path = find_module (self, name);
+  if (path == NULL)
+    return FALSE;
+
+  if (modules == NULL)
+    modules = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  if (g_hash_table_contains (modules, path))
+    return TRUE;
+
+  g_debug ("Loading module '%s' for plugin '%s'", path, name);
+  start = g_get_monotonic_time ();
+  module = g_io_module_new (path);
+  if (!g_type_module_use (G_TYPE_MODULE (module))) {
+    g_warning ("Failed to load module '%s'", path);
+    g_object_unref (module);
+    return FALSE;
+  }
+  stats = get_plugin_stats (self, name);
+  stats->load_us = g_get_monotonic_time () - start;
+
+  /* Like GIO we never unload modules */
+  g_hash_table_insert (modules, g_steal_pointer (&path), module);
+  return TRUE;
+}
+
+
 static void
 phosh_plugin_loader_constructed (GObject *object)
 {
@@ -103,10 +395,13 @@ phosh_plugin_loader_constructed (GObject *object)
   /* TODO: Doesn't necessarily make sense for all plugins */
   g_io_extension_point_set_required_type (ep, GTK_TYPE_WIDGET);
 
-  for (int i = 0; i < g_strv_length (self->plugin_dirs); i++) {
-    g_debug ("Will load plugins from '%s' for '%s'", self->plugin_dirs[i], self->extension_point);
-    g_io_modules_scan_all_in_directory (self->plugin_dirs[i]);
-  }
+  self->settings = g_settings_new ("sm.puri.phosh.plugins");
+  g_signal_connect_object (self->settings,
+                           "changed::frame-budget",
+                           G_CALLBACK (on_frame_budget_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  on_frame_budget_changed (self);
 }
 
 
@@ -117,6 +412,8 @@ phosh_plugin_loader_dispose (GObject *object)
 
   g_clear_pointer (&self->plugin_dirs, g_strfreev);
   g_clear_pointer (&self->extension_point, g_free);
+  g_clear_pointer (&self->index, g_hash_table_unref);
+  g_clear_object (&self->settings);
 
   G_OBJECT_CLASS (phosh_plugin_loader_parent_class)->dispose (object);
 }
@@ -171,6 +468,37 @@ phosh_plugin_loader_new (GStrv plugin_dirs, const char *extension_point)
                        NULL);
 }
 
+/**
+ * phosh_plugin_loader_get_default:
+ * @extension_point: The extension point
+ *
+ * Get the loader for plugins of the given extension point in the
+ * default plugin directory. The loader is shared so the plugin index
+ * is only built once.
+ *
+ * Returns:(transfer none): The plugin loader
+ */
+PhoshPluginLoader *
+phosh_plugin_loader_get_default (const char *extension_point)
+{
+  static GHashTable *loaders;
+  const char *plugin_dirs[] = { PHOSH_PLUGINS_DIR, NULL };
+  PhoshPluginLoader *loader;
+
+  g_return_val_if_fail (extension_point, NULL);
+
+  if (loaders == NULL)
+    loaders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  loader = g_hash_table_lookup (loaders, extension_point);
+  if (loader == NULL) {
+    loader = phosh_plugin_loader_new ((GStrv) plugin_dirs, extension_point);
+    g_hash_table_insert (loaders, g_strdup (extension_point), loader);
+  }
+
+  return loader;
+}
+
 /**
  * phosh_plugin_loader_load_plugin:
  * @self: The plugin loader
@@ -185,6 +513,9 @@ phosh_plugin_loader_load_plugin (PhoshPluginLoader *self, const char *name)
 {
   GIOExtensionPoint *ep;
   GIOExtension *extension;
+  GtkWidget *widget;
+  PluginStats *stats;
+  gint64 start;
   GType type;
 
   g_return_val_if_fail (PHOSH_IS_PLUGIN_LOADER (self), NULL);
@@ -193,12 +524,98 @@ phosh_plugin_loader_load_plugin (PhoshPluginLoader *self, const char *name)
   ep = g_io_extension_point_lookup (self->extension_point);
 
   extension = g_io_extension_point_get_extension_by_name (ep, name);
-  if (extension == NULL)
-    return NULL;
+  if (extension == NULL) {
+    if (!load_module (self, name))
+      return NULL;
+
+    extension = g_io_extension_point_get_extension_by_name (ep, name);
+    if (extension == NULL)
+      return NULL;
+  }
 
-  g_debug ("Loading plugin %s", name);
   type = g_io_extension_get_type (extension);
-  return g_object_new (type, NULL);
+  start = g_get_monotonic_time ();
+  widget = g_object_new (type, NULL);
+
+  stats = get_plugin_stats (self, name);
+  stats->construct_us = g_get_monotonic_time () - start;
+  g_debug ("Loaded plugin %s in %.1fms", name, (stats->load_us + stats->construct_us) / 1000.0);
+  if (stats->construct_us > frame_budget_us)
+    flag_plugin (stats, "construction", stats->construct_us);
+
+  instrument_plugin (widget, stats);
+
+  return widget;
+}
+
+/**
+ * phosh_plugin_loader_is_plugin_flagged:
+ * @self: The plugin loader
+ * @name: The name of the plugin
+ *
+ * Whether the plugin exceeded the frame budget in this session.
+ *
+ * Returns: %TRUE if the plugin got flagged, otherwise %FALSE
+ */
+gboolean
+phosh_plugin_loader_is_plugin_flagged (PhoshPluginLoader *self, const char *name)
+{
+  g_autofree char *key = NULL;
+  PluginStats *stats;
+
+  g_return_val_if_fail (PHOSH_IS_PLUGIN_LOADER (self), FALSE);
+  g_return_val_if_fail (name, FALSE);
+
+  if (plugin_stats == NULL)
+    return FALSE;
+
+  key = g_strdup_printf ("%s/%s", self->extension_point, name);
+  stats = g_hash_table_lookup (plugin_stats, key);
+
+  return stats ? stats->flagged : FALSE;
+}
+
+/**
+ * phosh_plugin_loader_get_plugin_stats:
+ *
+ * Get the timing information of all plugins loaded so far. Times are in
+ * microseconds.
+ *
+ * Returns:(transfer floating): The stats as `a(ssa{sv})` of extension
+ *   point, plugin name and stats
+ */
+GVariant *
+phosh_plugin_loader_get_plugin_stats (void)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  PluginStats *stats;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(ssa{sv})"));
+
+  if (plugin_stats == NULL)
+    return g_variant_builder_end (&builder);
+
+  g_hash_table_iter_init (&iter, plugin_stats);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&stats)) {
+    g_autoptr (GVariantDict) dict = g_variant_dict_new (NULL);
+
+    g_variant_dict_insert (dict, "load-time", "x", stats->load_us);
+    g_variant_dict_insert (dict, "construct-time", "x", stats->construct_us);
+    g_variant_dict_insert (dict, "map-time", "x", stats->map_us);
+    g_variant_dict_insert (dict, "draws", "u", stats->n_draws);
+    g_variant_dict_insert (dict, "draw-time-total", "x", stats->draw_total_us);
+    g_variant_dict_insert (dict, "draw-time-max", "x", stats->draw_max_us);
+    g_variant_dict_insert (dict, "draws-over-budget", "u", stats->n_draws_over_budget);
+    g_variant_dict_insert (dict, "flagged", "b", stats->flagged);
+
+    g_variant_builder_add (&builder, "(ss@a{sv})",
+                           stats->extension_point,
+                           stats->name,
+                           g_variant_dict_end (dict));
+  }
+
+  return g_variant_builder_end (&builder);
 }
 
 
@@ -21,8 +21,12 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (PhoshPluginLoader, phosh_plugin_loader, PHOSH, PLUGIN_LOADER, GObject)
 
 PhoshPluginLoader *phosh_plugin_loader_new (GStrv plugin_dirs, const char *extension_point);
+PhoshPluginLoader *phosh_plugin_loader_get_default (const char *extension_point);
 GtkWidget         *phosh_plugin_loader_load_plugin (PhoshPluginLoader *self, const char *name);
 const char        *phosh_plugin_loader_get_extension_point (PhoshPluginLoader *self);
 const char *const *phosh_plugin_loader_get_plugin_dirs (PhoshPluginLoader *self);
+gboolean           phosh_plugin_loader_is_plugin_flagged (PhoshPluginLoader *self,
+                                                          const char        *name);
+GVariant          *phosh_plugin_loader_get_plugin_stats (void);
 
 G_END_DECLS
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-property-coalescer"
+
+#include "phosh-config.h"
+
+#include "property-coalescer.h"
+#include "wakeup-scheduler.h"
+
+/**
+ * PhoshPropertyCoalescer:
+ *
+ * Coalesces property changes of DBus proxies
+ *
+ * Rather than reacting to every `g-properties-changed` signal
+ * consumers get a single [signal@PropertyCoalescer::changed] per
+ * object listing all properties that changed since the last
+ * emission. By default changes are delivered once per main loop
+ * iteration before GTK redraws. Properties that change often (like a
+ * modem's signal quality) can be rate limited via
+ * [method@PropertyCoalescer.set_interval] so they're delivered at
+ * most once per interval.
+ *
+ * While the screen is off changes are only collected. Once it turns
+ * back on each changed property is delivered once so consumers only
+ * process the final state before the first frame.
+ */
+
+enum {
+  CHANGED,
+  N_SIGNALS
+};
+static guint signals[N_SIGNALS];
+
+typedef struct {
+  gboolean pending;
+  gint64   last_emit;
+} PropertyState;
+
+struct _PhoshPropertyCoalescer {
+  GObject     parent;
+
+  /* Property name → interval in ms */
+  GHashTable *intervals;
+  /* GObject → (property name → PropertyState) */
+  GHashTable *objects;
+
+  guint       flush_id;
+  gint64      flush_time;
+};
+G_DEFINE_TYPE (PhoshPropertyCoalescer, phosh_property_coalescer, G_TYPE_OBJECT)
+
+
+static void schedule_flush (PhoshPropertyCoalescer *self);
+
+
+static gint64
+get_interval (PhoshPropertyCoalescer *self, const char *property)
+{
+  gpointer interval = g_hash_table_lookup (self->intervals, property);
+
+  return GPOINTER_TO_UINT (interval) * G_TIME_SPAN_MILLISECOND;
+}
+
+
+static GHashTable *
+get_properties (PhoshPropertyCoalescer *self, GObject *object)
+{
+  GHashTable *properties = g_hash_table_lookup (self->objects, object);
+
+  if (properties == NULL) {
+    properties = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+    g_hash_table_insert (self->objects, g_object_ref (object), properties);
+  }
+
+  return properties;
+}
+
+
+static gboolean
+on_flush (gpointer data)
+{
+  PhoshPropertyCoalescer *self = PHOSH_PROPERTY_COALESCER (data);
+
+  self->flush_id = 0;
+  phosh_property_coalescer_flush (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+schedule_flush (PhoshPropertyCoalescer *self)
+{
+  GHashTableIter objects;
+  GHashTable *properties;
+  gint64 now = g_get_monotonic_time ();
+  gint64 due = G_MAXINT64;
+
+  if (phosh_wakeup_scheduler_get_screen_off (phosh_wakeup_scheduler_get_default ())) {
+    g_clear_handle_id (&self->flush_id, g_source_remove);
+    return;
+  }
+
+  g_hash_table_iter_init (&objects, self->objects);
+  while (g_hash_table_iter_next (&objects, NULL, (gpointer *)&properties)) {
+    GHashTableIter iter;
+    const char *property;
+    PropertyState *state;
+
+    g_hash_table_iter_init (&iter, properties);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&property, (gpointer *)&state)) {
+      if (state->pending)
+        due = MIN (due, state->last_emit + get_interval (self, property));
+    }
+  }
+
+  if (due == G_MAXINT64)
+    return;
+
+  due = MAX (due, now);
+  if (self->flush_id && self->flush_time <= due)
+    return;
+
+  g_clear_handle_id (&self->flush_id, g_source_remove);
+  self->flush_time = due;
+
+  if (due == now) {
+    /* Run before GTK's redraw so all changes land in the same frame */
+    self->flush_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE + 10, on_flush, self, NULL);
+  } else {
+    self->flush_id = g_timeout_add ((due - now + G_TIME_SPAN_MILLISECOND - 1) / G_TIME_SPAN_MILLISECOND,
+                                    on_flush,
+                                    self);
+  }
+  g_source_set_name_by_id (self->flush_id, "[phosh] property coalescer flush");
+}
+
+
+static void
+on_g_properties_changed (GDBusProxy             *proxy,
+                         GVariant               *changed_properties,
+                         GStrv                   invalidated,
+                         PhoshPropertyCoalescer *self)
+{
+  const char *property;
+  GVariantIter iter;
+
+  g_variant_iter_init (&iter, changed_properties);
+  while (g_variant_iter_next (&iter, "{&sv}", &property, NULL))
+    phosh_property_coalescer_queue (self, G_OBJECT (proxy), property);
+
+  for (int i = 0; invalidated && invalidated[i]; i++)
+    phosh_property_coalescer_queue (self, G_OBJECT (proxy), invalidated[i]);
+}
+
+
+static void
+on_screen_off_changed (PhoshPropertyCoalescer *self)
+{
+  if (self->objects)
+    schedule_flush (self);
+}
+
+
+static void
+phosh_property_coalescer_dispose (GObject *object)
+{
+  PhoshPropertyCoalescer *self = PHOSH_PROPERTY_COALESCER (object);
+
+  g_clear_handle_id (&self->flush_id, g_source_remove);
+
+  if (self->objects) {
+    GHashTableIter iter;
+    GObject *watched;
+
+    g_hash_table_iter_init (&iter, self->objects);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&watched, NULL))
+      g_signal_handlers_disconnect_by_data (watched, self);
+  }
+  g_clear_pointer (&self->objects, g_hash_table_unref);
+
+  G_OBJECT_CLASS (phosh_property_coalescer_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_property_coalescer_finalize (GObject *object)
+{
+  PhoshPropertyCoalescer *self = PHOSH_PROPERTY_COALESCER (object);
+
+  g_hash_table_unref (self->intervals);
+
+  G_OBJECT_CLASS (phosh_property_coalescer_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_property_coalescer_class_init (PhoshPropertyCoalescerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = phosh_property_coalescer_dispose;
+  object_class->finalize = phosh_property_coalescer_finalize;
+
+  /**
+   * PhoshPropertyCoalescer::changed:
+   * @self: The coalescer
+   * @object: The object whose properties changed
+   * @properties: The names of the changed properties
+   *
+   * Emitted with all properties of @object that changed since the
+   * last emission and whose interval elapsed.
+   */
+  signals[CHANGED] = g_signal_new ("changed",
+                                   G_TYPE_FROM_CLASS (klass),
+                                   G_SIGNAL_RUN_LAST,
+                                   0, NULL, NULL, NULL,
+                                   G_TYPE_NONE,
+                                   2,
+                                   G_TYPE_OBJECT,
+                                   G_TYPE_STRV);
+}
+
+
+static void
+phosh_property_coalescer_init (PhoshPropertyCoalescer *self)
+{
+  self->intervals = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->objects = g_hash_table_new_full (g_direct_hash,
+                                         g_direct_equal,
+                                         g_object_unref,
+                                         (GDestroyNotify) g_hash_table_unref);
+
+  g_signal_connect_object (phosh_wakeup_scheduler_get_default (),
+                           "notify::screen-off",
+                           G_CALLBACK (on_screen_off_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+}
+
+
+PhoshPropertyCoalescer *
+phosh_property_coalescer_new (void)
+{
+  return g_object_new (PHOSH_TYPE_PROPERTY_COALESCER, NULL);
+}
+
+/**
+ * phosh_property_coalescer_set_interval:
+ * @self: The coalescer
+ * @interval: The minimum interval between two updates in milliseconds
+ * @first_property: The first property name
+ * @...: More property names, terminated by %NULL
+ *
+ * Deliver changes of the given properties at most once per @interval.
+ * The first change after a quiet period is delivered right away.
+ */
+void
+phosh_property_coalescer_set_interval (PhoshPropertyCoalescer *self,
+                                       guint                   interval,
+                                       const char             *first_property,
+                                       ...)
+{
+  const char *property;
+  va_list args;
+
+  g_return_if_fail (PHOSH_IS_PROPERTY_COALESCER (self));
+
+  va_start (args, first_property);
+  for (property = first_property; property; property = va_arg (args, const char *))
+    g_hash_table_insert (self->intervals, g_strdup (property), GUINT_TO_POINTER (interval));
+  va_end (args);
+}
+
+/**
+ * phosh_property_coalescer_watch:
+ * @self: The coalescer
+ * @proxy: The proxy to watch
+ *
+ * Track property changes of the given proxy.
+ */
+void
+phosh_property_coalescer_watch (PhoshPropertyCoalescer *self, GDBusProxy *proxy)
+{
+  g_return_if_fail (PHOSH_IS_PROPERTY_COALESCER (self));
+  g_return_if_fail (G_IS_DBUS_PROXY (proxy));
+
+  get_properties (self, G_OBJECT (proxy));
+  g_signal_connect (proxy, "g-properties-changed", G_CALLBACK (on_g_properties_changed), self);
+}
+
+/**
+ * phosh_property_coalescer_unwatch:
+ * @self: The coalescer
+ * @proxy: The proxy to stop watching
+ *
+ * Stop tracking property changes of the given proxy. Pending changes
+ * are dropped.
+ */
+void
+phosh_property_coalescer_unwatch (PhoshPropertyCoalescer *self, GDBusProxy *proxy)
+{
+  g_return_if_fail (PHOSH_IS_PROPERTY_COALESCER (self));
+  g_return_if_fail (G_IS_DBUS_PROXY (proxy));
+
+  g_signal_handlers_disconnect_by_data (proxy, self);
+  g_hash_table_remove (self->objects, proxy);
+}
+
+/**
+ * phosh_property_coalescer_queue:
+ * @self: The coalescer
+ * @object: The object
+ * @property: The property that changed
+ *
+ * Mark the given property as changed. This is useful to feed in
+ * changes that don't come from watched proxies.
+ */
+void
+phosh_property_coalescer_queue (PhoshPropertyCoalescer *self,
+                                GObject                *object,
+                                const char             *property)
+{
+  GHashTable *properties;
+  PropertyState *state;
+
+  g_return_if_fail (PHOSH_IS_PROPERTY_COALESCER (self));
+  g_return_if_fail (G_IS_OBJECT (object));
+  g_return_if_fail (property);
+
+  properties = get_properties (self, object);
+  state = g_hash_table_lookup (properties, property);
+  if (state == NULL) {
+    state = g_new0 (PropertyState, 1);
+    g_hash_table_insert (properties, g_strdup (property), state);
+  }
+
+  if (state->pending)
+    return;
+
+  state->pending = TRUE;
+  schedule_flush (self);
+}
+
+/**
+ * phosh_property_coalescer_flush:
+ * @self: The coalescer
+ *
+ * Emit all pending changes whose interval elapsed now.
+ */
+void
+phosh_property_coalescer_flush (PhoshPropertyCoalescer *self)
+{
+  g_autoptr (GPtrArray) objects = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr (GPtrArray) changes = g_ptr_array_new_with_free_func ((GDestroyNotify) g_strfreev);
+  gint64 now = g_get_monotonic_time ();
+  GHashTableIter objects_iter;
+  GObject *object;
+  GHashTable *properties;
+
+  g_return_if_fail (PHOSH_IS_PROPERTY_COALESCER (self));
+
+  g_clear_handle_id (&self->flush_id, g_source_remove);
+
+  /* Collect first as handlers might queue or unwatch */
+  g_hash_table_iter_init (&objects_iter, self->objects);
+  while (g_hash_table_iter_next (&objects_iter, (gpointer *)&object, (gpointer *)&properties)) {
+    g_autoptr (GStrvBuilder) builder = g_strv_builder_new ();
+    g_auto (GStrv) changed = NULL;
+    GHashTableIter iter;
+    const char *property;
+    PropertyState *state;
+
+    g_hash_table_iter_init (&iter, properties);
+    while (g_hash_table_iter_next (&iter, (gpointer *)&property, (gpointer *)&state)) {
+      if (!state->pending || state->last_emit + get_interval (self, property) > now)
+        continue;
+
+      state->pending = FALSE;
+      state->last_emit = now;
+      g_strv_builder_add (builder, property);
+    }
+
+    changed = g_strv_builder_end (builder);
+    if (changed[0] == NULL)
+      continue;
+
+    g_ptr_array_add (objects, g_object_ref (object));
+    g_ptr_array_add (changes, g_steal_pointer (&changed));
+  }
+
+  for (guint i = 0; i < objects->len; i++)
+    g_signal_emit (self, signals[CHANGED], 0, g_ptr_array_index (objects, i), g_ptr_array_index (changes, i));
+
+  /* Changes that are still rate limited */
+  if (self->objects)
+    schedule_flush (self);
+}
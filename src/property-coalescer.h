@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_PROPERTY_COALESCER (phosh_property_coalescer_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshPropertyCoalescer, phosh_property_coalescer, PHOSH, PROPERTY_COALESCER,
+                      GObject)
+
+PhoshPropertyCoalescer *phosh_property_coalescer_new          (void);
+void                    phosh_property_coalescer_set_interval (PhoshPropertyCoalescer *self,
+                                                               guint                   interval,
+                                                               const char             *first_property,
+                                                               ...) G_GNUC_NULL_TERMINATED;
+void                    phosh_property_coalescer_watch        (PhoshPropertyCoalescer *self,
+                                                               GDBusProxy             *proxy);
+void                    phosh_property_coalescer_unwatch      (PhoshPropertyCoalescer *self,
+                                                               GDBusProxy             *proxy);
+void                    phosh_property_coalescer_queue        (PhoshPropertyCoalescer *self,
+                                                               GObject                *object,
+                                                               const char             *property);
+void                    phosh_property_coalescer_flush        (PhoshPropertyCoalescer *self);
+
+G_END_DECLS
@@ -91,6 +91,8 @@ typedef struct _PhoshSettings
   GSettings         *plugin_settings;
   PhoshPluginLoader *plugin_loader;
   GPtrArray         *custom_quick_settings;
+  gboolean           needs_plugin_load;
+  guint              plugin_load_id;
 } PhoshSettings;
 
 
@@ -580,6 +582,14 @@ load_custom_quick_settings (PhoshSettings *self, GSettings *settings, gchar *key
   g_auto (GStrv) plugins = NULL;
   GtkWidget *widget;
 
+  /* Defer loading the plugins' modules until we're shown */
+  if (!gtk_widget_get_mapped (GTK_WIDGET (self))) {
+    self->needs_plugin_load = TRUE;
+    return;
+  }
+  self->needs_plugin_load = FALSE;
+  g_clear_handle_id (&self->plugin_load_id, g_source_remove);
+
   g_ptr_array_remove_range (self->custom_quick_settings, 0, self->custom_quick_settings->len);
   plugins = g_settings_get_strv (self->plugin_settings, "quick-settings");
 
@@ -739,7 +749,6 @@ phosh_settings_constructed (GObject *object)
 {
   PhoshSettings *self = PHOSH_SETTINGS (object);
   PhoshNotifyManager *manager;
-  const char *plugin_dirs[] = { PHOSH_PLUGINS_DIR, NULL };
 
   G_OBJECT_CLASS (phosh_settings_parent_class)->constructed (object);
 
@@ -772,8 +781,8 @@ phosh_settings_constructed (GObject *object)
                           G_BINDING_SYNC_CREATE);
 
   self->plugin_settings = g_settings_new ("sm.puri.phosh.plugins");
-  self->plugin_loader = phosh_plugin_loader_new ((GStrv) plugin_dirs,
-                                                 PHOSH_EXTENSION_POINT_QUICK_SETTING_WIDGET);
+  self->plugin_loader =
+    g_object_ref (phosh_plugin_loader_get_default (PHOSH_EXTENSION_POINT_QUICK_SETTING_WIDGET));
   self->custom_quick_settings = g_ptr_array_new_with_free_func ((GDestroyNotify) unload_custom_quick_setting);
 
   g_signal_connect_object (self->plugin_settings, "changed::quick-settings",
@@ -783,6 +792,52 @@ phosh_settings_constructed (GObject *object)
 }
 
 
+static gboolean
+on_plugin_load_idle (gpointer data)
+{
+  PhoshSettings *self = PHOSH_SETTINGS (data);
+
+  self->plugin_load_id = 0;
+  load_custom_quick_settings (self, NULL, NULL);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+has_flagged_plugins (PhoshSettings *self)
+{
+  g_auto (GStrv) plugins = g_settings_get_strv (self->plugin_settings, "quick-settings");
+
+  for (int i = 0; plugins && plugins[i]; i++) {
+    if (phosh_plugin_loader_is_plugin_flagged (self->plugin_loader, plugins[i]))
+      return TRUE;
+  }
+
+  return FALSE;
+}
+
+
+static void
+phosh_settings_map (GtkWidget *widget)
+{
+  PhoshSettings *self = PHOSH_SETTINGS (widget);
+
+  GTK_WIDGET_CLASS (phosh_settings_parent_class)->map (widget);
+
+  if (!self->needs_plugin_load || self->plugin_load_id)
+    return;
+
+  if (has_flagged_plugins (self)) {
+    /* Slow plugins shouldn't delay showing the rest of the UI */
+    self->plugin_load_id = g_idle_add_full (G_PRIORITY_LOW, on_plugin_load_idle, self, NULL);
+    g_source_set_name_by_id (self->plugin_load_id, "[phosh] settings plugin load");
+  } else {
+    load_custom_quick_settings (self, NULL, NULL);
+  }
+}
+
+
 static void
 phosh_settings_dispose (GObject *object)
 {
@@ -792,6 +847,7 @@ phosh_settings_dispose (GObject *object)
 
   g_clear_object (&self->torch_manager);
 
+  g_clear_handle_id (&self->plugin_load_id, g_source_remove);
   g_clear_object (&self->plugin_settings);
   g_clear_object (&self->plugin_loader);
   if (self->custom_quick_settings) {
@@ -826,6 +882,8 @@ phosh_settings_class_init (PhoshSettingsClass *klass)
   object_class->set_property = phosh_settings_set_property;
   object_class->get_property = phosh_settings_get_property;
 
+  widget_class->map = phosh_settings_map;
+
   g_type_ensure (PHOSH_TYPE_BT_STATUS_PAGE);
   g_type_ensure (PHOSH_TYPE_WIFI_STATUS_PAGE);
 
@@ -35,11 +35,13 @@
 #include "connectivity-info.h"
 #include "calls-manager.h"
 #include "docked-info.h"
+#include "debug-manager.h"
 #include "docked-manager.h"
 #include "emergency-calls-manager.h"
 #include "fader.h"
 #include "feedbackinfo.h"
 #include "feedback-manager.h"
+#include "frame-profiler.h"
 #include "gnome-shell-manager.h"
 #include "gtk-mount-manager.h"
 #include "hks-info.h"
@@ -52,6 +54,8 @@
 #include "location-manager.h"
 #include "lockscreen-manager.h"
 #include "media-player.h"
+#include "memory-accounting.h"
+#include "memory-pressure-monitor.h"
 #include "mode-manager.h"
 #include "monitor-manager.h"
 #include "monitor/monitor.h"
@@ -87,6 +91,7 @@
 #include "torch-info.h"
 #include "util.h"
 #include "vpn-info.h"
+#include "wakeup-scheduler.h"
 #include "wifi-info.h"
 #include "wwan-info.h"
 #include "wwan/phosh-wwan-ofono.h"
@@ -96,6 +101,9 @@
 #include "phosh-settings-enums.h"
 
 #define WWAN_BACKEND_KEY "wwan-backend"
+#define MEMORY_BUDGETS_KEY "memory-budgets"
+/* How often to check memory budgets and log memory usage in seconds */
+#define MEMORY_CHECK_INTERVAL (15 * 60)
 
 /**
  * PhoshShell:
@@ -156,9 +164,13 @@ typedef struct
   PhoshMountManager *mount_manager;
   PhoshWWan *wwan;
   PhoshTorchManager *torch_manager;
+  PhoshBatteryManager *battery_manager;
   PhoshModeManager *mode_manager;
   PhoshDockedManager *docked_manager;
   PhoshGtkMountManager *gtk_mount_manager;
+  PhoshDebugManager *debug_manager;
+  PhoshMemoryPressureMonitor *memory_pressure_monitor;
+  PhoshFrameProfiler *frame_profiler;
   PhoshHksManager *hks_manager;
   PhoshKeyboardEvents *keyboard_events;
   PhoshLocationManager *location_manager;
@@ -551,9 +563,13 @@ phosh_shell_dispose (GObject *object)
   g_clear_object (&priv->location_manager);
   g_clear_object (&priv->hks_manager);
   g_clear_object (&priv->gtk_mount_manager);
+  g_clear_object (&priv->debug_manager);
+  g_clear_object (&priv->memory_pressure_monitor);
+  phosh_memory_accounting_set_interval (phosh_memory_accounting_get_default (), 0);
   g_clear_object (&priv->docked_manager);
   g_clear_object (&priv->mode_manager);
   g_clear_object (&priv->torch_manager);
+  g_clear_object (&priv->battery_manager);
   g_clear_object (&priv->gnome_shell_manager);
   g_clear_object (&priv->wwan);
   g_clear_object (&priv->mount_manager);
@@ -575,6 +591,7 @@ phosh_shell_dispose (GObject *object)
   g_clear_object (&priv->app_tracker);
   g_clear_object (&priv->suspend_manager);
   g_clear_object (&priv->layout_manager);
+  g_clear_object (&priv->frame_profiler);
 
   /* sensors */
   g_clear_object (&priv->proximity);
@@ -726,6 +743,24 @@ on_startup_finished (PhoshShell *self)
 }
 
 
+static void
+on_memory_budgets_changed (PhoshShell *self)
+{
+  PhoshShellPrivate *priv = phosh_shell_get_instance_private (self);
+  g_autoptr (GVariant) budgets = NULL;
+
+  budgets = g_settings_get_value (priv->settings, MEMORY_BUDGETS_KEY);
+  phosh_memory_accounting_load_budgets (phosh_memory_accounting_get_default (), budgets);
+}
+
+
+static void
+on_memory_pressure (PhoshShell *self, PhoshMemoryPressure level)
+{
+  phosh_memory_accounting_shed (phosh_memory_accounting_get_default (), level);
+}
+
+
 static gboolean
 setup_idle_cb (PhoshShell *self)
 {
@@ -805,13 +840,33 @@ setup_idle_cb (PhoshShell *self)
   priv->suspend_manager = phosh_suspend_manager_new ();
   priv->emergency_calls_manager = phosh_emergency_calls_manager_new ();
   priv->power_menu_manager = phosh_power_menu_manager_new ();
+  /* The frame profiler's data is only available via the debug interface */
+  if (debug_flags & (PHOSH_SHELL_DEBUG_FLAG_DEBUG_INTERFACE | PHOSH_SHELL_DEBUG_FLAG_FRAME_PROFILER))
+    priv->debug_manager = phosh_debug_manager_new ();
+
+  g_signal_connect_swapped (priv->settings,
+                            "changed::" MEMORY_BUDGETS_KEY,
+                            G_CALLBACK (on_memory_budgets_changed),
+                            self);
+  on_memory_budgets_changed (self);
+  phosh_memory_accounting_set_interval (phosh_memory_accounting_get_default (),
+                                        MEMORY_CHECK_INTERVAL);
+  priv->memory_pressure_monitor = phosh_memory_pressure_monitor_new ();
+  g_signal_connect_swapped (priv->memory_pressure_monitor,
+                            "pressure",
+                            G_CALLBACK (on_memory_pressure),
+                            self);
 
   setup_primary_monitor_signal_handlers (self);
 
   /* Delay signaling to the compositor a bit so that idle handlers get a chance to run and
      the user can unlock right away. Ideally we'd not need this */
-  priv->startup_finished_id = g_timeout_add_seconds (1, (GSourceFunc)on_startup_finished, self);
-  g_source_set_name_by_id (priv->startup_finished_id, "[PhoshShell] startup finished");
+  priv->startup_finished_id = phosh_wakeup_scheduler_add (phosh_wakeup_scheduler_get_default (),
+                                                          "[PhoshShell] startup finished",
+                                                          1,
+                                                          PHOSH_WAKEUP_FLAG_NONE,
+                                                          (GSourceFunc) on_startup_finished,
+                                                          self);
 
   priv->startup_finished = TRUE;
   g_signal_emit (self, signals[READY], 0);
@@ -899,6 +954,37 @@ find_new_builtin_monitor (PhoshShell *self, PhoshMonitor *old)
 }
 
 
+/* Suspend UI refreshes when all outputs are off, @removed is about to go away */
+static void
+update_screen_off (PhoshShell *self, PhoshMonitor *removed)
+{
+  PhoshShellPrivate *priv = phosh_shell_get_instance_private (self);
+  gboolean screen_off = FALSE;
+
+  for (int i = 0; i < phosh_monitor_manager_get_num_monitors (priv->monitor_manager); i++) {
+    PhoshMonitor *monitor = phosh_monitor_manager_get_monitor (priv->monitor_manager, i);
+
+    if (monitor == removed || !phosh_monitor_is_configured (monitor))
+      continue;
+
+    if (phosh_monitor_get_power_save_mode (monitor) != PHOSH_MONITOR_POWER_SAVE_MODE_OFF) {
+      screen_off = FALSE;
+      break;
+    }
+    screen_off = TRUE;
+  }
+
+  phosh_wakeup_scheduler_set_screen_off (phosh_wakeup_scheduler_get_default (), screen_off);
+}
+
+
+static void
+on_monitor_power_mode_changed (PhoshShell *self, GParamSpec *pspec, PhoshMonitor *monitor)
+{
+  update_screen_off (self, NULL);
+}
+
+
 static void
 on_monitor_added (PhoshShell *self, PhoshMonitor *monitor)
 {
@@ -910,6 +996,13 @@ on_monitor_added (PhoshShell *self, PhoshMonitor *monitor)
 
   g_debug ("Monitor %p (%s) added", monitor, monitor->name);
 
+  g_signal_connect_object (monitor,
+                           "notify::power-mode",
+                           G_CALLBACK (on_monitor_power_mode_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+  update_screen_off (self, NULL);
+
   /* Set built-in monitor if not set already */
   if (!priv->builtin_monitor && phosh_monitor_is_builtin (monitor))
     phosh_shell_set_builtin_monitor (self, monitor);
@@ -939,6 +1032,9 @@ on_monitor_removed (PhoshShell *self, PhoshMonitor *monitor)
   g_return_if_fail (PHOSH_IS_MONITOR (monitor));
   priv = phosh_shell_get_instance_private (self);
 
+  g_signal_handlers_disconnect_by_func (monitor, on_monitor_power_mode_changed, self);
+  update_screen_off (self, monitor);
+
   if (priv->builtin_monitor == monitor) {
     PhoshMonitor *new_builtin;
 
@@ -1298,6 +1394,12 @@ static GDebugKey debug_keys[] =
  { .key = "fake-builtin",
    .value = PHOSH_SHELL_DEBUG_FLAG_FAKE_BUILTIN,
  },
+ { .key = "frame-profiler",
+   .value = PHOSH_SHELL_DEBUG_FLAG_FRAME_PROFILER,
+ },
+ { .key = "debug-interface",
+   .value = PHOSH_SHELL_DEBUG_FLAG_DEBUG_INTERFACE,
+ },
 };
 
 
@@ -1316,6 +1418,10 @@ phosh_shell_init (PhoshShell *self)
                                       debug_keys,
                                       G_N_ELEMENTS (debug_keys));
 
+  /* Needs to be around before the first layer surface gets mapped */
+  if (debug_flags & PHOSH_SHELL_DEBUG_FLAG_FRAME_PROFILER)
+    priv->frame_profiler = phosh_frame_profiler_new ();
+
   gtk_settings = gtk_settings_get_default ();
   g_object_set (G_OBJECT (gtk_settings), "gtk-application-prefer-dark-theme", TRUE, NULL);
 
@@ -1534,6 +1640,27 @@ phosh_shell_get_emergency_calls_manager (PhoshShell *self)
 }
 
 
+/**
+ * phosh_shell_get_frame_profiler:
+ * @self: The shell singleton
+ *
+ * Get the frame profiler. It's only available when enabled via
+ * `PHOSH_DEBUG=frame-profiler`.
+ *
+ * Returns: (transfer none)(nullable): The frame profiler
+ */
+PhoshFrameProfiler *
+phosh_shell_get_frame_profiler (PhoshShell *self)
+{
+  PhoshShellPrivate *priv;
+
+  g_return_val_if_fail (PHOSH_IS_SHELL (self), NULL);
+  priv = phosh_shell_get_instance_private (self);
+
+  return priv->frame_profiler;
+}
+
+
 /**
  * phosh_shell_get_feedback_manager:
  * @self: The shell singleton
@@ -1925,6 +2052,30 @@ phosh_shell_get_rotation_manager (PhoshShell *self)
 }
 
 
+/**
+ * phosh_shell_get_battery_manager:
+ * @self: The shell singleton
+ *
+ * Get the battery manager
+ *
+ * Returns: (transfer none): The battery manager
+ */
+PhoshBatteryManager *
+phosh_shell_get_battery_manager (PhoshShell *self)
+{
+  PhoshShellPrivate *priv;
+
+  g_return_val_if_fail (PHOSH_IS_SHELL (self), NULL);
+  priv = phosh_shell_get_instance_private (self);
+
+  if (!priv->battery_manager)
+    priv->battery_manager = phosh_battery_manager_new ();
+
+  g_return_val_if_fail (PHOSH_IS_BATTERY_MANAGER (priv->battery_manager), NULL);
+  return priv->battery_manager;
+}
+
+
 /**
  * phosh_shell_get_torch_manager:
  * @self: The shell singleton
@@ -2267,6 +2418,27 @@ phosh_shell_remove_global_keyboard_action_entries (PhoshShell *self,
 }
 
 
+/**
+ * phosh_shell_get_keyboard_events:
+ * @self: The shell singleton
+ *
+ * Get the keyboard events handling global accelerators. This is
+ * %NULL if the compositor lacks support for it.
+ *
+ * Returns: (transfer none)(nullable): The keyboard events
+ */
+PhoshKeyboardEvents *
+phosh_shell_get_keyboard_events (PhoshShell *self)
+{
+  PhoshShellPrivate *priv;
+
+  g_return_val_if_fail (PHOSH_IS_SHELL (self), NULL);
+  priv = phosh_shell_get_instance_private (self);
+
+  return priv->keyboard_events;
+}
+
+
 /**
  * phosh_shell_is_session_active
  * @self: The shell
@@ -12,13 +12,16 @@
 
 #include "app-tracker.h"
 #include "background-manager.h"
+#include "battery-manager.h"
 #include "bt-manager.h"
 #include "calls-manager.h"
 #include "docked-manager.h"
 #include "emergency-calls-manager.h"
 #include "feedback-manager.h"
+#include "frame-profiler.h"
 #include "gtk-mount-manager.h"
 #include "hks-manager.h"
+#include "keyboard-events.h"
 #include "layout-manager.h"
 #include "location-manager.h"
 #include "lockscreen-manager.h"
@@ -64,6 +67,8 @@ typedef enum {
  * @PHOSH_SHELL_DEBUG_FLAG_ALWAYS_SPLASH: always use splash (even when docked)
  * @PHOSH_SHELL_DEBUG_FLAG_FAKE_BUILTIN: When calculatiog layout treat the first
  *     virtual output like a built-in output.
+ * @PHOSH_SHELL_DEBUG_FLAG_FRAME_PROFILER: Record frame timings of layer surfaces
+ * @PHOSH_SHELL_DEBUG_FLAG_DEBUG_INTERFACE: Export the sm.puri.Phosh.Debug DBus interface
  *
  * These flags are to enable/disable debugging features.
  */
@@ -71,6 +76,8 @@ typedef enum {
   PHOSH_SHELL_DEBUG_FLAG_NONE          = 0,
   PHOSH_SHELL_DEBUG_FLAG_ALWAYS_SPLASH = 1 << 0,
   PHOSH_SHELL_DEBUG_FLAG_FAKE_BUILTIN  = 1 << 1,
+  PHOSH_SHELL_DEBUG_FLAG_FRAME_PROFILER = 1 << 2,
+  PHOSH_SHELL_DEBUG_FLAG_DEBUG_INTERFACE = 1 << 3,
 } PhoshShellDebugFlags;
 
 
@@ -95,6 +102,7 @@ PhoshBackgroundManager *phosh_shell_get_background_manager (PhoshShell *self);
 PhoshCallsManager      *phosh_shell_get_calls_manager (PhoshShell *self);
 PhoshFeedbackManager   *phosh_shell_get_feedback_manager   (PhoshShell *self);
 PhoshGtkMountManager   *phosh_shell_get_gtk_mount_manager  (PhoshShell *self);
+PhoshKeyboardEvents    *phosh_shell_get_keyboard_events    (PhoshShell *self);
 PhoshLayoutManager     *phosh_shell_get_layout_manager     (PhoshShell *self);
 PhoshLockscreenManager *phosh_shell_get_lockscreen_manager (PhoshShell *self);
 PhoshModeManager       *phosh_shell_get_mode_manager       (PhoshShell *self);
@@ -102,6 +110,7 @@ PhoshToplevelManager   *phosh_shell_get_toplevel_manager   (PhoshShell *self);
 PhoshScreenSaverManager *phosh_shell_get_screen_saver_manager (PhoshShell *self);
 PhoshScreenshotManager *phosh_shell_get_screenshot_manager (PhoshShell *self);
 /* Created on the fly */
+PhoshBatteryManager    *phosh_shell_get_battery_manager    (PhoshShell *self);
 PhoshBtManager         *phosh_shell_get_bt_manager         (PhoshShell *self);
 PhoshDockedManager     *phosh_shell_get_docked_manager     (PhoshShell *self);
 PhoshHksManager        *phosh_shell_get_hks_manager        (PhoshShell *self);
@@ -111,6 +120,8 @@ PhoshRotationManager   *phosh_shell_get_rotation_manager   (PhoshShell *self);
 PhoshTorchManager      *phosh_shell_get_torch_manager      (PhoshShell *self);
 PhoshVpnManager        *phosh_shell_get_vpn_manager        (PhoshShell *self);
 PhoshEmergencyCallsManager *phosh_shell_get_emergency_calls_manager (PhoshShell *self);
+/* Only with PHOSH_SHELL_DEBUG_FLAG_FRAME_PROFILER */
+PhoshFrameProfiler     *phosh_shell_get_frame_profiler     (PhoshShell *self);
 
 void                 phosh_shell_fade_out (PhoshShell *self, guint timeout);
 void                 phosh_shell_enable_power_save (PhoshShell *self, gboolean enable);
@@ -0,0 +1,497 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-sorted-app-list-model"
+
+#include "sorted-app-list-model.h"
+
+#include <gio/gdesktopappinfo.h>
+
+#include <string.h>
+
+/* Unused collation keys to keep around before pruning the cache */
+#define MAX_UNUSED_KEYS 32
+
+/**
+ * PhoshSortedAppListModel:
+ *
+ * A `GListModel` that sorts a list of `GAppInfo`s by name
+ *
+ * The collation key of each app's name is computed once and items are
+ * kept in a sorted array so changes in the underlying model can be
+ * applied via binary search. Items that didn't change are kept in place
+ * so `items-changed` only covers the affected positions even when the
+ * underlying model replaces all of its items. Items that changed without
+ * affecting their sort position are replaced in place.
+ */
+
+enum {
+  PROP_0,
+  PROP_MODEL,
+  PROP_LAST_PROP
+};
+static GParamSpec *props[PROP_LAST_PROP];
+
+typedef struct {
+  GAppInfo *info;
+  char     *key;
+} SortEntry;
+
+struct _PhoshSortedAppListModel {
+  GObject     parent;
+
+  GListModel *model;
+  /* SortEntry in the order of @model */
+  GPtrArray  *unsorted;
+  /* The same SortEntry, sorted by key */
+  GPtrArray  *sorted;
+  /* App name to collation key */
+  GHashTable *keys;
+};
+
+static void list_iface_init (GListModelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (PhoshSortedAppListModel, phosh_sorted_app_list_model, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, list_iface_init))
+
+
+static void
+sort_entry_free (SortEntry *entry)
+{
+  g_clear_object (&entry->info);
+  g_free (entry->key);
+  g_free (entry);
+}
+
+
+static const char *
+get_collate_key (PhoshSortedAppListModel *self, GAppInfo *info)
+{
+  const char *name = g_app_info_get_name (info) ?: "";
+  char *key;
+
+  key = g_hash_table_lookup (self->keys, name);
+  if (key == NULL) {
+    g_autofree char *folded = g_utf8_casefold (name, -1);
+
+    key = g_utf8_collate_key (folded, -1);
+    g_hash_table_insert (self->keys, g_strdup (name), key);
+  }
+
+  return key;
+}
+
+
+static SortEntry *
+sort_entry_new (PhoshSortedAppListModel *self, GAppInfo *info)
+{
+  SortEntry *entry = g_new0 (SortEntry, 1);
+
+  entry->info = g_object_ref (info);
+  entry->key = g_strdup (get_collate_key (self, info));
+
+  return entry;
+}
+
+
+/* Position of the first entry sorting after @key */
+static guint
+find_insert_pos (PhoshSortedAppListModel *self, const char *key)
+{
+  guint lo = 0, hi = self->sorted->len;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    SortEntry *entry = g_ptr_array_index (self->sorted, mid);
+
+    if (strcmp (entry->key, key) <= 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+
+static guint
+find_entry_pos (PhoshSortedAppListModel *self, SortEntry *entry)
+{
+  guint lo = 0, hi = self->sorted->len;
+
+  /* Lower bound of the entry's key… */
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    SortEntry *other = g_ptr_array_index (self->sorted, mid);
+
+    if (strcmp (other->key, entry->key) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  /* …and then the entry itself amongst entries with the same key */
+  for (; lo < self->sorted->len; lo++) {
+    if (g_ptr_array_index (self->sorted, lo) == entry)
+      return lo;
+  }
+
+  g_return_val_if_reached (G_MAXUINT);
+}
+
+
+/* Whether @info is the app of @entry at the same sort position */
+static gboolean
+can_reuse_entry (SortEntry *entry, GAppInfo *info, const char *key)
+{
+  if (!g_str_equal (entry->key, key))
+    return FALSE;
+
+  return entry->info == info || g_app_info_equal (entry->info, info);
+}
+
+
+static gboolean
+strv_equal (const char *const *a, const char *const *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return g_strv_equal (a, b);
+}
+
+
+/* Whether nothing a consumer might show or launch differs */
+static gboolean
+app_info_content_equal (GAppInfo *a, GAppInfo *b)
+{
+  if (a == b)
+    return TRUE;
+
+  if (g_strcmp0 (g_app_info_get_name (a), g_app_info_get_name (b)) ||
+      g_strcmp0 (g_app_info_get_description (a), g_app_info_get_description (b)) ||
+      g_strcmp0 (g_app_info_get_commandline (a), g_app_info_get_commandline (b)))
+    return FALSE;
+
+  if (!g_icon_equal (g_app_info_get_icon (a), g_app_info_get_icon (b)))
+    return FALSE;
+
+  if (G_IS_DESKTOP_APP_INFO (a) != G_IS_DESKTOP_APP_INFO (b))
+    return FALSE;
+
+  if (G_IS_DESKTOP_APP_INFO (a)) {
+    GDesktopAppInfo *desktop_a = G_DESKTOP_APP_INFO (a);
+    GDesktopAppInfo *desktop_b = G_DESKTOP_APP_INFO (b);
+
+    if (!strv_equal (g_desktop_app_info_get_keywords (desktop_a),
+                     g_desktop_app_info_get_keywords (desktop_b)))
+      return FALSE;
+
+    if (!strv_equal (g_desktop_app_info_list_actions (desktop_a),
+                     g_desktop_app_info_list_actions (desktop_b)))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+/* Drop collation keys of names no entry uses anymore */
+static void
+prune_keys (PhoshSortedAppListModel *self)
+{
+  if (g_hash_table_size (self->keys) <= self->sorted->len + MAX_UNUSED_KEYS)
+    return;
+
+  g_hash_table_remove_all (self->keys);
+  for (guint i = 0; i < self->sorted->len; i++) {
+    SortEntry *entry = g_ptr_array_index (self->sorted, i);
+    const char *name = g_app_info_get_name (entry->info) ?: "";
+
+    g_hash_table_replace (self->keys, g_strdup (name), g_strdup (entry->key));
+  }
+}
+
+
+static void
+on_model_items_changed (PhoshSortedAppListModel *self,
+                        guint                    position,
+                        guint                    removed,
+                        guint                    added,
+                        GListModel              *model)
+{
+  g_autoptr (GPtrArray) stale = g_ptr_array_sized_new (removed);
+  g_autoptr (GHashTable) stale_by_key = g_hash_table_new (g_str_hash, g_str_equal);
+  g_autoptr (GPtrArray) new_entries = g_ptr_array_new ();
+  g_autoptr (GPtrArray) changed_entries = g_ptr_array_new ();
+  SortEntry *entry;
+
+  /* Entries of the items removed from the underlying model */
+  for (guint i = 0; i < removed; i++) {
+    entry = g_ptr_array_index (self->unsorted, position + i);
+    g_ptr_array_add (stale, entry);
+    if (!g_hash_table_contains (stale_by_key, entry->key))
+      g_hash_table_insert (stale_by_key, entry->key, GUINT_TO_POINTER (i));
+  }
+  g_ptr_array_remove_range (self->unsorted, position, removed);
+
+  /* Reuse entries of removed items that got re-added unchanged */
+  for (guint i = 0; i < added; i++) {
+    g_autoptr (GAppInfo) info = g_list_model_get_item (model, position + i);
+    const char *key = get_collate_key (self, info);
+    gpointer idx;
+
+    entry = NULL;
+    if (g_hash_table_lookup_extended (stale_by_key, key, NULL, &idx)) {
+      SortEntry *old = g_ptr_array_index (stale, GPOINTER_TO_UINT (idx));
+
+      if (can_reuse_entry (old, info, key)) {
+        g_hash_table_remove (stale_by_key, key);
+        g_ptr_array_index (stale, GPOINTER_TO_UINT (idx)) = NULL;
+        /* Keep the old object when nothing changed so consumers can keep theirs */
+        if (!app_info_content_equal (old->info, info)) {
+          g_set_object (&old->info, info);
+          g_ptr_array_add (changed_entries, old);
+        }
+        entry = old;
+      }
+    }
+
+    if (entry == NULL) {
+      entry = sort_entry_new (self, info);
+      g_ptr_array_add (new_entries, entry);
+    }
+    g_ptr_array_insert (self->unsorted, position + i, entry);
+  }
+
+  /* Items that are gone for good */
+  for (guint i = 0; i < stale->len; i++) {
+    guint pos;
+
+    entry = g_ptr_array_index (stale, i);
+    if (entry == NULL)
+      continue;
+
+    pos = find_entry_pos (self, entry);
+    if (pos == G_MAXUINT)
+      continue;
+
+    /* Frees the entry */
+    g_ptr_array_remove_index (self->sorted, pos);
+    g_list_model_items_changed (G_LIST_MODEL (self), pos, 1, 0);
+  }
+
+  /* Items that are new or changed their sort position */
+  for (guint i = 0; i < new_entries->len; i++) {
+    guint pos;
+
+    entry = g_ptr_array_index (new_entries, i);
+    pos = find_insert_pos (self, entry->key);
+    g_ptr_array_insert (self->sorted, pos, entry);
+    g_list_model_items_changed (G_LIST_MODEL (self), pos, 0, 1);
+  }
+
+  /* Items that changed in place */
+  for (guint i = 0; i < changed_entries->len; i++) {
+    guint pos;
+
+    entry = g_ptr_array_index (changed_entries, i);
+    pos = find_entry_pos (self, entry);
+    if (pos == G_MAXUINT)
+      continue;
+
+    g_list_model_items_changed (G_LIST_MODEL (self), pos, 1, 1);
+  }
+
+  prune_keys (self);
+}
+
+
+static void
+phosh_sorted_app_list_model_set_model (PhoshSortedAppListModel *self, GListModel *model)
+{
+  guint n_items;
+
+  g_return_if_fail (g_type_is_a (g_list_model_get_item_type (model), G_TYPE_APP_INFO));
+
+  self->model = g_object_ref (model);
+  g_signal_connect_object (self->model,
+                           "items-changed",
+                           G_CALLBACK (on_model_items_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
+
+  n_items = g_list_model_get_n_items (model);
+  for (guint i = 0; i < n_items; i++) {
+    g_autoptr (GAppInfo) info = g_list_model_get_item (model, i);
+    SortEntry *entry = sort_entry_new (self, info);
+
+    g_ptr_array_add (self->unsorted, entry);
+    g_ptr_array_insert (self->sorted, find_insert_pos (self, entry->key), entry);
+  }
+}
+
+
+static void
+phosh_sorted_app_list_model_set_property (GObject      *object,
+                                          guint         property_id,
+                                          const GValue *value,
+                                          GParamSpec   *pspec)
+{
+  PhoshSortedAppListModel *self = PHOSH_SORTED_APP_LIST_MODEL (object);
+
+  switch (property_id) {
+  case PROP_MODEL:
+    phosh_sorted_app_list_model_set_model (self, g_value_get_object (value));
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+phosh_sorted_app_list_model_get_property (GObject    *object,
+                                          guint       property_id,
+                                          GValue     *value,
+                                          GParamSpec *pspec)
+{
+  PhoshSortedAppListModel *self = PHOSH_SORTED_APP_LIST_MODEL (object);
+
+  switch (property_id) {
+  case PROP_MODEL:
+    g_value_set_object (value, self->model);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+phosh_sorted_app_list_model_dispose (GObject *object)
+{
+  PhoshSortedAppListModel *self = PHOSH_SORTED_APP_LIST_MODEL (object);
+
+  if (self->model)
+    g_signal_handlers_disconnect_by_data (self->model, self);
+  g_clear_object (&self->model);
+
+  G_OBJECT_CLASS (phosh_sorted_app_list_model_parent_class)->dispose (object);
+}
+
+
+static void
+phosh_sorted_app_list_model_finalize (GObject *object)
+{
+  PhoshSortedAppListModel *self = PHOSH_SORTED_APP_LIST_MODEL (object);
+
+  /* The sorted array owns the entries */
+  g_clear_pointer (&self->unsorted, g_ptr_array_unref);
+  g_clear_pointer (&self->sorted, g_ptr_array_unref);
+  g_clear_pointer (&self->keys, g_hash_table_unref);
+
+  G_OBJECT_CLASS (phosh_sorted_app_list_model_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_sorted_app_list_model_class_init (PhoshSortedAppListModelClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->dispose = phosh_sorted_app_list_model_dispose;
+  object_class->finalize = phosh_sorted_app_list_model_finalize;
+  object_class->set_property = phosh_sorted_app_list_model_set_property;
+  object_class->get_property = phosh_sorted_app_list_model_get_property;
+
+  /**
+   * PhoshSortedAppListModel:model:
+   *
+   * The model holding the `GAppInfo`s to sort
+   */
+  props[PROP_MODEL] =
+    g_param_spec_object ("model", "", "",
+                         G_TYPE_LIST_MODEL,
+                         G_PARAM_READWRITE |
+                         G_PARAM_CONSTRUCT_ONLY |
+                         G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+}
+
+
+static GType
+list_get_item_type (GListModel *list)
+{
+  return G_TYPE_APP_INFO;
+}
+
+
+static gpointer
+list_get_item (GListModel *list, guint position)
+{
+  PhoshSortedAppListModel *self = PHOSH_SORTED_APP_LIST_MODEL (list);
+  SortEntry *entry;
+
+  if (position >= self->sorted->len)
+    return NULL;
+
+  entry = g_ptr_array_index (self->sorted, position);
+  return g_object_ref (entry->info);
+}
+
+
+static unsigned int
+list_get_n_items (GListModel *list)
+{
+  PhoshSortedAppListModel *self = PHOSH_SORTED_APP_LIST_MODEL (list);
+
+  return self->sorted->len;
+}
+
+
+static void
+list_iface_init (GListModelInterface *iface)
+{
+  iface->get_item_type = list_get_item_type;
+  iface->get_item = list_get_item;
+  iface->get_n_items = list_get_n_items;
+}
+
+
+static void
+phosh_sorted_app_list_model_init (PhoshSortedAppListModel *self)
+{
+  self->unsorted = g_ptr_array_new ();
+  self->sorted = g_ptr_array_new_with_free_func ((GDestroyNotify) sort_entry_free);
+  self->keys = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+}
+
+
+PhoshSortedAppListModel *
+phosh_sorted_app_list_model_new (GListModel *model)
+{
+  return g_object_new (PHOSH_TYPE_SORTED_APP_LIST_MODEL, "model", model, NULL);
+}
+
+/**
+ * phosh_sorted_app_list_model_get_model:
+ * @self: The sorted app list model
+ *
+ * Get the model that is being sorted.
+ *
+ * Returns:(transfer none): The underlying model
+ */
+GListModel *
+phosh_sorted_app_list_model_get_model (PhoshSortedAppListModel *self)
+{
+  g_return_val_if_fail (PHOSH_IS_SORTED_APP_LIST_MODEL (self), NULL);
+
+  return self->model;
+}
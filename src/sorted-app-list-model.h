@@ -0,0 +1,20 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_SORTED_APP_LIST_MODEL phosh_sorted_app_list_model_get_type ()
+G_DECLARE_FINAL_TYPE (PhoshSortedAppListModel, phosh_sorted_app_list_model, PHOSH,
+                      SORTED_APP_LIST_MODEL, GObject)
+
+PhoshSortedAppListModel *phosh_sorted_app_list_model_new (GListModel *model);
+GListModel              *phosh_sorted_app_list_model_get_model (PhoshSortedAppListModel *self);
+
+G_END_DECLS
@@ -24,6 +24,10 @@
  * Tracks and interacts with toplevel surfaces for window management
  * purposes using the wlr-foreign-toplevel-unstable-v1 wayland
  * protocol.
+ *
+ * The configured toplevels are available as a `GListModel`. They're
+ * additionally indexed by their handle, app-id and parent so lookups
+ * don't need to walk the whole list.
  */
 
 enum {
@@ -40,13 +44,26 @@ enum {
 };
 static guint signals[N_SIGNALS] = { 0 };
 
+/* The keys a configured toplevel is currently indexed under */
+typedef struct {
+  char     *app_id;
+} ToplevelKeys;
+
 struct _PhoshToplevelManager {
   GObject parent;
   GPtrArray *toplevels;         /* (element-type: PhoshToplevel) */
   GPtrArray *toplevels_pending; /* (element-type: PhoshToplevel) */
+
+  GHashTable *keys;             /* PhoshToplevel → ToplevelKeys */
+  GHashTable *by_handle;        /* handle → PhoshToplevel */
+  GHashTable *by_app_id;        /* app-id → GPtrArray of PhoshToplevel */
 };
 
-G_DEFINE_TYPE (PhoshToplevelManager, phosh_toplevel_manager, G_TYPE_OBJECT);
+static void phosh_toplevel_manager_list_model_iface_init (GListModelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (PhoshToplevelManager, phosh_toplevel_manager, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL,
+                                                phosh_toplevel_manager_list_model_iface_init))
 
 static void
 phosh_toplevel_get_property (GObject    *object,
@@ -66,26 +83,118 @@ phosh_toplevel_get_property (GObject    *object,
   }
 }
 
+static void
+toplevel_keys_free (ToplevelKeys *keys)
+{
+  g_free (keys->app_id);
+  g_free (keys);
+}
+
+
+static void
+index_insert (GHashTable     *index,
+              gconstpointer   key,
+              GBoxedCopyFunc  key_copy,
+              PhoshToplevel  *toplevel)
+{
+  GPtrArray *toplevels = g_hash_table_lookup (index, key);
+
+  if (toplevels == NULL) {
+    toplevels = g_ptr_array_new ();
+    g_hash_table_insert (index, key_copy ? key_copy (key) : (gpointer) key, toplevels);
+  }
+
+  g_ptr_array_add (toplevels, toplevel);
+}
+
+
+static void
+index_remove (GHashTable *index, gconstpointer key, PhoshToplevel *toplevel)
+{
+  GPtrArray *toplevels = g_hash_table_lookup (index, key);
+
+  g_return_if_fail (toplevels);
+
+  g_ptr_array_remove (toplevels, toplevel);
+  if (toplevels->len == 0)
+    g_hash_table_remove (index, key);
+}
+
+
+static void
+add_to_index (PhoshToplevelManager *self, PhoshToplevel *toplevel)
+{
+  ToplevelKeys *keys = g_new0 (ToplevelKeys, 1);
+
+  keys->app_id = g_strdup (phosh_toplevel_get_app_id (toplevel) ?: "");
+
+  g_hash_table_insert (self->by_handle, phosh_toplevel_get_handle (toplevel), toplevel);
+  index_insert (self->by_app_id, keys->app_id, (GBoxedCopyFunc) g_strdup, toplevel);
+
+  g_hash_table_insert (self->keys, toplevel, keys);
+}
+
+
+static void
+remove_from_index (PhoshToplevelManager *self, PhoshToplevel *toplevel)
+{
+  ToplevelKeys *keys = g_hash_table_lookup (self->keys, toplevel);
+
+  g_return_if_fail (keys);
+
+  g_hash_table_remove (self->by_handle, phosh_toplevel_get_handle (toplevel));
+  index_remove (self->by_app_id, keys->app_id, toplevel);
+
+  g_hash_table_remove (self->keys, toplevel);
+}
+
+
+static void
+update_index (PhoshToplevelManager *self, PhoshToplevel *toplevel)
+{
+  ToplevelKeys *keys = g_hash_table_lookup (self->keys, toplevel);
+
+  g_return_if_fail (keys);
+
+  /* The app-id can change on each configure */
+  if (g_strcmp0 (keys->app_id, phosh_toplevel_get_app_id (toplevel) ?: "") == 0)
+    return;
+
+  remove_from_index (self, toplevel);
+  add_to_index (self, toplevel);
+}
+
+
 static void
 on_toplevel_closed (PhoshToplevelManager *self, PhoshToplevel *toplevel)
 {
+  guint pos;
+
   g_return_if_fail (PHOSH_IS_TOPLEVEL_MANAGER (self));
   g_return_if_fail (PHOSH_IS_TOPLEVEL (toplevel));
   g_return_if_fail (self->toplevels);
   g_return_if_fail (self->toplevels_pending);
 
-  /* Check if toplevel exists in toplevels_pending, in that case it is
-   * not yet configured and we just remove it from toplevels_pending
-   * without touching the regular toplevels array. */
-  if (g_ptr_array_find (self->toplevels_pending, toplevel, NULL)) {
+  /* If the toplevel isn't indexed it is not yet configured and we
+   * just remove it from toplevels_pending without touching the
+   * regular toplevels array. */
+  if (!g_hash_table_contains (self->keys, toplevel)) {
     g_assert_true (g_ptr_array_remove (self->toplevels_pending, toplevel));
     g_object_unref (toplevel);
     return;
   }
 
-  g_assert_true (g_ptr_array_remove (self->toplevels, toplevel));
+  remove_from_index (self, toplevel);
+
+  /* Only needed for the model's position */
+  g_assert_true (g_ptr_array_find (self->toplevels, toplevel, &pos));
+  /* Keep the toplevel alive until listeners are notified */
+  g_ptr_array_steal_index (self->toplevels, pos);
 
+  g_list_model_items_changed (G_LIST_MODEL (self), pos, 1, 0);
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_NUM_TOPLEVELS]);
+
+  g_object_unref (toplevel);
 }
 
 
@@ -103,11 +212,14 @@ on_toplevel_configured (PhoshToplevelManager *self, GParamSpec *pspec, PhoshTopl
   if (!configured)
     return;
 
-  if (g_ptr_array_find (self->toplevels, toplevel, NULL)) {
+  if (g_hash_table_contains (self->keys, toplevel)) {
+    update_index (self, toplevel);
     g_signal_emit (self, signals[SIGNAL_TOPLEVEL_CHANGED], 0, toplevel);
   } else {
     g_assert_true (g_ptr_array_remove (self->toplevels_pending, toplevel));
     g_ptr_array_add (self->toplevels, toplevel);
+    add_to_index (self, toplevel);
+    g_list_model_items_changed (G_LIST_MODEL (self), self->toplevels->len - 1, 0, 1);
     g_signal_emit (self, signals[SIGNAL_TOPLEVEL_ADDED], 0, toplevel);
     g_object_notify_by_pspec (G_OBJECT (self), props[PROP_NUM_TOPLEVELS]);
   }
@@ -155,6 +267,11 @@ static void
 phosh_toplevel_manager_dispose (GObject *object)
 {
   PhoshToplevelManager *self = PHOSH_TOPLEVEL_MANAGER (object);
+
+  g_clear_pointer (&self->by_app_id, g_hash_table_unref);
+  g_clear_pointer (&self->by_handle, g_hash_table_unref);
+  g_clear_pointer (&self->keys, g_hash_table_unref);
+
   if (self->toplevels) {
     g_ptr_array_free (self->toplevels, TRUE);
     self->toplevels = NULL;
@@ -212,6 +329,43 @@ phosh_toplevel_manager_class_init (PhoshToplevelManagerClass *klass)
 }
 
 
+static GType
+phosh_toplevel_manager_list_model_get_item_type (GListModel *list)
+{
+  return PHOSH_TYPE_TOPLEVEL;
+}
+
+
+static gpointer
+phosh_toplevel_manager_list_model_get_item (GListModel *list, guint position)
+{
+  PhoshToplevelManager *self = PHOSH_TOPLEVEL_MANAGER (list);
+
+  if (self->toplevels == NULL || position >= self->toplevels->len)
+    return NULL;
+
+  return g_object_ref (g_ptr_array_index (self->toplevels, position));
+}
+
+
+static unsigned int
+phosh_toplevel_manager_list_model_get_n_items (GListModel *list)
+{
+  PhoshToplevelManager *self = PHOSH_TOPLEVEL_MANAGER (list);
+
+  return self->toplevels ? self->toplevels->len : 0;
+}
+
+
+static void
+phosh_toplevel_manager_list_model_iface_init (GListModelInterface *iface)
+{
+  iface->get_item_type = phosh_toplevel_manager_list_model_get_item_type;
+  iface->get_item = phosh_toplevel_manager_list_model_get_item;
+  iface->get_n_items = phosh_toplevel_manager_list_model_get_n_items;
+}
+
+
 static void
 phosh_toplevel_manager_init (PhoshToplevelManager *self)
 {
@@ -223,6 +377,12 @@ phosh_toplevel_manager_init (PhoshToplevelManager *self)
   self->toplevels = g_ptr_array_new_with_free_func ((GDestroyNotify) (g_object_unref));
   self->toplevels_pending = g_ptr_array_new ();
 
+  self->keys = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                      NULL, (GDestroyNotify) toplevel_keys_free);
+  self->by_handle = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->by_app_id = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, (GDestroyNotify) g_ptr_array_unref);
+
   if (!toplevel_manager) {
     g_critical ("Missing wlr-foreign-toplevel-management protocol extension");
     return;
@@ -289,12 +449,30 @@ phosh_toplevel_manager_get_parent (PhoshToplevelManager *self, PhoshToplevel *to
   if (parent_handle == NULL)
     return NULL;
 
-  for (int i = 0; i < self->toplevels->len; i++) {
-    PhoshToplevel *t;
+  return g_hash_table_lookup (self->by_handle, parent_handle);
+}
 
-    t = g_ptr_array_index (self->toplevels, i);
-    if (parent_handle == phosh_toplevel_get_handle (t))
-      return t;
-  }
-  return NULL;
+/**
+ * phosh_toplevel_manager_get_toplevels_for_app_id:
+ * @self: The toplevel manager
+ * @app_id: The app-id to look up
+ *
+ * Gets the configured toplevels with the given app-id
+ *
+ * Returns:(transfer container)(element-type PhoshToplevel): The toplevels
+ */
+GPtrArray *
+phosh_toplevel_manager_get_toplevels_for_app_id (PhoshToplevelManager *self, const char *app_id)
+{
+  GPtrArray *toplevels;
+
+  g_return_val_if_fail (PHOSH_IS_TOPLEVEL_MANAGER (self), NULL);
+  g_return_val_if_fail (app_id, NULL);
+
+  toplevels = g_hash_table_lookup (self->by_app_id, app_id);
+  if (toplevels == NULL)
+    return g_ptr_array_new ();
+
+  return g_ptr_array_copy (toplevels, NULL, NULL);
 }
+
@@ -24,3 +24,5 @@ PhoshToplevel        *phosh_toplevel_manager_get_toplevel        (PhoshToplevelM
 guint                 phosh_toplevel_manager_get_num_toplevels   (PhoshToplevelManager *self);
 PhoshToplevel        *phosh_toplevel_manager_get_parent          (PhoshToplevelManager *self,
                                                                   PhoshToplevel        *toplevel);
+GPtrArray            *phosh_toplevel_manager_get_toplevels_for_app_id (PhoshToplevelManager *self,
+                                                                       const char           *app_id);
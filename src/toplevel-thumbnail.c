@@ -8,6 +8,7 @@
 
 #define G_LOG_DOMAIN "phosh-toplevel-thumbnail"
 
+#include "memory-accounting.h"
 #include "phosh-wayland.h"
 #include "shell.h"
 #include "toplevel-thumbnail.h"
@@ -195,12 +196,29 @@ phosh_toplevel_thumbnail_get_property (GObject *object,
 }
 
 
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  PhoshToplevelThumbnail *self = PHOSH_TOPLEVEL_THUMBNAIL (owner);
+
+  if (self->buffer)
+    report->bytes += phosh_wl_buffer_get_size (self->buffer);
+  report->objects++;
+}
+
+
 static void
 phosh_toplevel_thumbnail_constructed (GObject *object)
 {
   PhoshToplevelThumbnail *self = PHOSH_TOPLEVEL_THUMBNAIL (object);
   zwlr_screencopy_frame_v1_add_listener (self->handle, &zwlr_screencopy_frame_listener, self);
 
+  phosh_memory_accounting_add_reporter (phosh_memory_accounting_get_default (),
+                                        "toplevel-thumbnails",
+                                        object,
+                                        report_memory,
+                                        NULL);
+
   G_OBJECT_CLASS (phosh_toplevel_thumbnail_parent_class)->constructed (object);
 }
 
@@ -11,6 +11,7 @@
 
 #include "vpn-manager.h"
 #include "shell.h"
+#include "nm-client-provider.h"
 #include "util.h"
 
 #include <NetworkManager.h>
@@ -344,7 +345,7 @@ on_nm_client_ready (GObject *obj, GAsyncResult *res, gpointer data)
   PhoshVpnManager *self;
   NMClient *client;
 
-  client = nm_client_new_finish (res, &err);
+  client = phosh_nm_client_provider_get_client_finish (PHOSH_NM_CLIENT_PROVIDER (obj), res, &err);
   if (client == NULL) {
     g_message ("Failed to init NM: %s", err->message);
     return;
@@ -373,7 +374,10 @@ phosh_vpn_manager_constructed (GObject *object)
   G_OBJECT_CLASS (phosh_vpn_manager_parent_class)->constructed (object);
 
   self->cancel = g_cancellable_new ();
-  nm_client_new_async (self->cancel, on_nm_client_ready, self);
+  phosh_nm_client_provider_get_client_async (phosh_nm_client_provider_get_default (),
+                                             self->cancel,
+                                             on_nm_client_ready,
+                                             self);
 }
 
 
@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-wakeup-scheduler"
+
+#include "phosh-config.h"
+
+#include "wakeup-scheduler.h"
+
+#include <errno.h>
+
+#ifdef __linux__
+# include <sys/prctl.h>
+#endif
+
+/* Coarser alignment for sources that aren't suspended when the screen is off */
+#define SCREEN_OFF_GRANULARITY   10 /* seconds */
+/* Timer slack while the screen is off, the kernel default is 50µs */
+#define SCREEN_OFF_TIMER_SLACK   (50 * 1000 * 1000) /* ns */
+
+/**
+ * PhoshWakeupScheduler:
+ *
+ * Coalesces the shell's non-urgent timers
+ *
+ * Periodic and one-shot timers with second granularity that aren't
+ * tied to user interaction are added to the scheduler. Like
+ * `g_timeout_add_seconds()` the scheduler aligns their wakeups to
+ * whole seconds using the same session wide offset as GLib so they
+ * fire together with each other and with other processes' timers.
+ *
+ * While the screen is off sources that only refresh the UI are
+ * suspended, all other sources are aligned to coarser boundaries and
+ * the main thread's timer slack is raised so the kernel can batch
+ * wakeups further.
+ *
+ * The number of wakeups is recorded per source name so idle wakeups
+ * can be attributed.
+ */
+
+enum {
+  PROP_0,
+  PROP_SCREEN_OFF,
+  PROP_LAST_PROP
+};
+static GParamSpec *props[PROP_LAST_PROP];
+
+typedef struct {
+  GSource               parent;
+
+  PhoshWakeupScheduler *scheduler;
+  guint                 interval;
+  PhoshWakeupFlags      flags;
+} WakeupSource;
+
+struct _PhoshWakeupScheduler {
+  GObject     parent;
+
+  GPtrArray  *sources;
+  GHashTable *wakeups;
+  gint64      perturbation;
+
+  gboolean    screen_off;
+  guint       n_screen_off_wakeups;
+};
+G_DEFINE_TYPE (PhoshWakeupScheduler, phosh_wakeup_scheduler, G_TYPE_OBJECT)
+
+
+static gint64
+align (PhoshWakeupScheduler *self, gint64 time, gint64 granularity)
+{
+  time -= self->perturbation;
+  time = ((time + granularity - 1) / granularity) * granularity;
+
+  return time + self->perturbation;
+}
+
+
+static void
+schedule (WakeupSource *source, gint64 now)
+{
+  PhoshWakeupScheduler *self = source->scheduler;
+  gint64 granularity = G_USEC_PER_SEC;
+
+  if (self->screen_off) {
+    if (source->flags & PHOSH_WAKEUP_FLAG_UI) {
+      g_source_set_ready_time ((GSource *)source, -1);
+      return;
+    }
+    granularity *= SCREEN_OFF_GRANULARITY;
+  }
+
+  g_source_set_ready_time ((GSource *)source,
+                           align (self, now + source->interval * G_USEC_PER_SEC, granularity));
+}
+
+
+static void
+count_wakeup (PhoshWakeupScheduler *self, const char *name)
+{
+  gpointer count;
+
+  count = g_hash_table_lookup (self->wakeups, name);
+  g_hash_table_insert (self->wakeups, g_strdup (name),
+                       GUINT_TO_POINTER (GPOINTER_TO_UINT (count) + 1));
+
+  if (self->screen_off)
+    self->n_screen_off_wakeups++;
+}
+
+
+static gboolean
+wakeup_source_dispatch (GSource *source, GSourceFunc callback, gpointer user_data)
+{
+  WakeupSource *wakeup_source = (WakeupSource *)source;
+  gboolean again;
+
+  if (!callback) {
+    g_warning ("Wakeup source dispatched without callback");
+    return G_SOURCE_REMOVE;
+  }
+
+  if (wakeup_source->scheduler)
+    count_wakeup (wakeup_source->scheduler, g_source_get_name (source));
+
+  again = callback (user_data);
+
+  /* Realign after the callback so the next wakeup stays on a boundary */
+  if (again && wakeup_source->scheduler)
+    schedule (wakeup_source, g_source_get_time (source));
+
+  return again;
+}
+
+
+static void
+wakeup_source_finalize (GSource *source)
+{
+  WakeupSource *wakeup_source = (WakeupSource *)source;
+
+  if (wakeup_source->scheduler)
+    g_ptr_array_remove_fast (wakeup_source->scheduler->sources, wakeup_source);
+}
+
+
+static GSourceFuncs wakeup_source_funcs = {
+  .dispatch = wakeup_source_dispatch,
+  .finalize = wakeup_source_finalize,
+};
+
+
+static void
+phosh_wakeup_scheduler_get_property (GObject    *object,
+                                     guint       property_id,
+                                     GValue     *value,
+                                     GParamSpec *pspec)
+{
+  PhoshWakeupScheduler *self = PHOSH_WAKEUP_SCHEDULER (object);
+
+  switch (property_id) {
+  case PROP_SCREEN_OFF:
+    g_value_set_boolean (value, self->screen_off);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+phosh_wakeup_scheduler_finalize (GObject *object)
+{
+  PhoshWakeupScheduler *self = PHOSH_WAKEUP_SCHEDULER (object);
+
+  /* Sources outliving the scheduler keep running unaligned */
+  for (guint i = 0; i < self->sources->len; i++) {
+    WakeupSource *source = g_ptr_array_index (self->sources, i);
+
+    source->scheduler = NULL;
+  }
+  g_clear_pointer (&self->sources, g_ptr_array_unref);
+  g_clear_pointer (&self->wakeups, g_hash_table_unref);
+
+  G_OBJECT_CLASS (phosh_wakeup_scheduler_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_wakeup_scheduler_class_init (PhoshWakeupSchedulerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->get_property = phosh_wakeup_scheduler_get_property;
+  object_class->finalize = phosh_wakeup_scheduler_finalize;
+
+  /**
+   * PhoshWakeupScheduler:screen-off:
+   *
+   * Whether all outputs are in power save mode
+   */
+  props[PROP_SCREEN_OFF] =
+    g_param_spec_boolean ("screen-off", "", "",
+                          FALSE,
+                          G_PARAM_READABLE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+}
+
+
+static void
+phosh_wakeup_scheduler_init (PhoshWakeupScheduler *self)
+{
+  const char *session_bus_address = g_getenv ("DBUS_SESSION_BUS_ADDRESS");
+
+  self->sources = g_ptr_array_new ();
+  self->wakeups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* Same offset as GLib uses for g_timeout_add_seconds () */
+  if (session_bus_address)
+    self->perturbation = ABS ((gint) g_str_hash (session_bus_address)) % G_USEC_PER_SEC;
+}
+
+/**
+ * phosh_wakeup_scheduler_get_default:
+ *
+ * Gets the wakeup scheduler singleton.
+ *
+ * Returns:(transfer none): The wakeup scheduler singleton.
+ */
+PhoshWakeupScheduler *
+phosh_wakeup_scheduler_get_default (void)
+{
+  static PhoshWakeupScheduler *instance;
+
+  if (instance == NULL) {
+    instance = g_object_new (PHOSH_TYPE_WAKEUP_SCHEDULER, NULL);
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+  return instance;
+}
+
+/**
+ * phosh_wakeup_scheduler_add:
+ * @self: The wakeup scheduler
+ * @name: The source's name, used for statistics
+ * @interval: The interval in seconds
+ * @flags: The source's flags
+ * @func: The function to call
+ * @data: Data to pass to @func
+ *
+ * Adds a timeout source to the default main context that invokes
+ * @func every @interval seconds until it returns
+ * `G_SOURCE_REMOVE`. The first invocation happens after at least
+ * @interval seconds.
+ *
+ * Returns: The source id. Use `g_source_remove()` to remove it.
+ */
+guint
+phosh_wakeup_scheduler_add (PhoshWakeupScheduler *self,
+                            const char           *name,
+                            guint                 interval,
+                            PhoshWakeupFlags      flags,
+                            GSourceFunc           func,
+                            gpointer              data)
+{
+  g_autoptr (GSource) source = NULL;
+  WakeupSource *wakeup_source;
+
+  g_return_val_if_fail (PHOSH_IS_WAKEUP_SCHEDULER (self), 0);
+  g_return_val_if_fail (name, 0);
+  g_return_val_if_fail (func, 0);
+
+  source = g_source_new (&wakeup_source_funcs, sizeof (WakeupSource));
+  wakeup_source = (WakeupSource *)source;
+  wakeup_source->scheduler = self;
+  wakeup_source->interval = interval;
+  wakeup_source->flags = flags;
+
+  g_source_set_static_name (source, g_intern_string (name));
+  g_source_set_callback (source, func, data, NULL);
+  schedule (wakeup_source, g_get_monotonic_time ());
+  g_ptr_array_add (self->sources, wakeup_source);
+
+  return g_source_attach (source, NULL);
+}
+
+/**
+ * phosh_wakeup_scheduler_set_screen_off:
+ * @self: The wakeup scheduler
+ * @screen_off: Whether all outputs are in power save mode
+ *
+ * Suspends UI sources while the screen is off. When the screen turns
+ * back on they are dispatched right away so the UI is up to date.
+ * This needs to be invoked from the main thread as the timer slack
+ * is a per thread setting.
+ */
+void
+phosh_wakeup_scheduler_set_screen_off (PhoshWakeupScheduler *self, gboolean screen_off)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  g_return_if_fail (PHOSH_IS_WAKEUP_SCHEDULER (self));
+
+  if (self->screen_off == screen_off)
+    return;
+
+  self->screen_off = screen_off;
+  g_debug ("Screen %s, %u wakeup sources", screen_off ? "off" : "on", self->sources->len);
+
+  if (!screen_off) {
+    g_debug ("%u wakeups while the screen was off", self->n_screen_off_wakeups);
+    self->n_screen_off_wakeups = 0;
+  }
+
+#ifdef __linux__
+  /* 0 resets to the default */
+  if (prctl (PR_SET_TIMERSLACK, screen_off ? SCREEN_OFF_TIMER_SLACK : 0, 0, 0, 0) < 0)
+    g_warning ("Failed to set timer slack: %s", g_strerror (errno));
+#endif
+
+  for (guint i = 0; i < self->sources->len; i++) {
+    WakeupSource *source = g_ptr_array_index (self->sources, i);
+    gint64 ready_time = g_source_get_ready_time ((GSource *)source);
+
+    if (source->flags & PHOSH_WAKEUP_FLAG_UI) {
+      if (screen_off)
+        g_source_set_ready_time ((GSource *)source, -1);
+      else
+        g_source_set_ready_time ((GSource *)source, 0);
+    } else if (screen_off && ready_time > now) {
+      g_source_set_ready_time ((GSource *)source,
+                               align (self, ready_time, SCREEN_OFF_GRANULARITY * G_USEC_PER_SEC));
+    }
+  }
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_SCREEN_OFF]);
+}
+
+
+gboolean
+phosh_wakeup_scheduler_get_screen_off (PhoshWakeupScheduler *self)
+{
+  g_return_val_if_fail (PHOSH_IS_WAKEUP_SCHEDULER (self), FALSE);
+
+  return self->screen_off;
+}
+
+/**
+ * phosh_wakeup_scheduler_get_stats:
+ * @self: The wakeup scheduler
+ *
+ * Get the number of wakeups per source name. See the
+ * `GetWakeupStats` DBus method for the format.
+ *
+ * Returns:(transfer floating): The wakeup statistics
+ */
+GVariant *
+phosh_wakeup_scheduler_get_stats (PhoshWakeupScheduler *self)
+{
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer name, count;
+
+  g_return_val_if_fail (PHOSH_IS_WAKEUP_SCHEDULER (self), NULL);
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{su}"));
+  g_hash_table_iter_init (&iter, self->wakeups);
+  while (g_hash_table_iter_next (&iter, &name, &count))
+    g_variant_builder_add (&builder, "{su}", name, GPOINTER_TO_UINT (count));
+
+  return g_variant_builder_end (&builder);
+}
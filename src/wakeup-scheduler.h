@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PhoshWakeupFlags:
+ * @PHOSH_WAKEUP_FLAG_NONE: No flags
+ * @PHOSH_WAKEUP_FLAG_UI: The source only refreshes the UI. It is
+ *   suspended while the screen is off and dispatched right away when
+ *   the screen turns back on.
+ *
+ * Flags for sources added to the [type@WakeupScheduler].
+ */
+typedef enum {
+  PHOSH_WAKEUP_FLAG_NONE = 0,
+  PHOSH_WAKEUP_FLAG_UI   = (1 << 0),
+} PhoshWakeupFlags;
+
+#define PHOSH_TYPE_WAKEUP_SCHEDULER (phosh_wakeup_scheduler_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshWakeupScheduler, phosh_wakeup_scheduler, PHOSH, WAKEUP_SCHEDULER,
+                      GObject)
+
+PhoshWakeupScheduler *phosh_wakeup_scheduler_get_default    (void);
+guint                 phosh_wakeup_scheduler_add            (PhoshWakeupScheduler *self,
+                                                             const char           *name,
+                                                             guint                 interval,
+                                                             PhoshWakeupFlags      flags,
+                                                             GSourceFunc           func,
+                                                             gpointer              data);
+void                  phosh_wakeup_scheduler_set_screen_off (PhoshWakeupScheduler *self,
+                                                             gboolean              screen_off);
+gboolean              phosh_wakeup_scheduler_get_screen_off (PhoshWakeupScheduler *self);
+GVariant             *phosh_wakeup_scheduler_get_stats      (PhoshWakeupScheduler *self);
+
+G_END_DECLS
@@ -7,6 +7,7 @@
 #include <locale.h>
 #include <glib/gi18n.h>
 
+#include "wakeup-scheduler.h"
 #include "wall-clock.h"
 
 enum {
@@ -21,11 +22,19 @@ static GParamSpec *props[LAST_PROP];
  * PhoshWallClock:
  *
  * Wall clock used for fetching date and time
+ *
+ * The underlying clocks tick every minute (or second). They're
+ * dropped while the screen is off and recreated on wake. Meanwhile
+ * the last clock strings are returned.
  */
 
 typedef struct _PhoshWallClockPrivate {
   GnomeWallClock *time;
   GnomeWallClock *date_time;
+
+  /* Last clock strings, used while the clocks are dropped */
+  char           *last_time;
+  char           *last_date_time;
 } PhoshWallClockPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhoshWallClock, phosh_wall_clock, G_TYPE_OBJECT)
@@ -47,6 +56,56 @@ on_time_changed (PhoshWallClock *self, GParamSpec *pspec, GnomeWallClock *clock)
 }
 
 
+static void
+create_clocks (PhoshWallClock *self)
+{
+  PhoshWallClockPrivate *priv = phosh_wall_clock_get_instance_private (self);
+
+  if (priv->time)
+    return;
+
+  priv->date_time = gnome_wall_clock_new ();
+  priv->time = g_object_new (GNOME_TYPE_WALL_CLOCK, "time-only", TRUE, NULL);
+
+  /* Somewhat icky, we need a distinct handler for each clock because one can
+   * update before the other, and we don't know which one the caller wants to
+   * read from.
+   */
+  g_signal_connect_object (priv->date_time, "notify::clock", G_CALLBACK (on_date_time_changed),
+                           self, G_CONNECT_SWAPPED);
+  g_signal_connect_object (priv->time, "notify::clock", G_CALLBACK (on_time_changed),
+                           self, G_CONNECT_SWAPPED);
+}
+
+
+static void
+on_screen_off_changed (PhoshWallClock *self, GParamSpec *pspec, PhoshWakeupScheduler *scheduler)
+{
+  PhoshWallClockPrivate *priv = phosh_wall_clock_get_instance_private (self);
+
+  if (phosh_wakeup_scheduler_get_screen_off (scheduler)) {
+    if (priv->time == NULL)
+      return;
+
+    g_free (priv->last_date_time);
+    priv->last_date_time = g_strdup (gnome_wall_clock_get_clock (priv->date_time));
+    g_free (priv->last_time);
+    priv->last_time = g_strdup (gnome_wall_clock_get_clock (priv->time));
+
+    g_clear_object (&priv->date_time);
+    g_clear_object (&priv->time);
+    return;
+  }
+
+  /* Time moved on while the clocks were gone */
+  create_clocks (self);
+  g_clear_pointer (&priv->last_date_time, g_free);
+  g_clear_pointer (&priv->last_time, g_free);
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_DATE_TIME]);
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_TIME]);
+}
+
+
 static void
 phosh_wall_clock_get_property (GObject    *object,
                                guint       property_id,
@@ -77,6 +136,8 @@ phosh_wall_clock_dispose (GObject *object)
 
   g_clear_object (&priv->date_time);
   g_clear_object (&priv->time);
+  g_clear_pointer (&priv->last_date_time, g_free);
+  g_clear_pointer (&priv->last_time, g_free);
 
   G_OBJECT_CLASS (phosh_wall_clock_parent_class)->dispose (object);
 }
@@ -85,9 +146,15 @@ phosh_wall_clock_dispose (GObject *object)
 static const char *
 get_clock_impl (PhoshWallClock *self, gboolean time_only)
 {
-  PhoshWallClockPrivate *priv;
+  PhoshWallClockPrivate *priv = phosh_wall_clock_get_instance_private (self);
+
+  /* Nobody sees the clock while the screen is off, the last value suffices */
+  if (priv->time == NULL) {
+    const char *last = time_only ? priv->last_time : priv->last_date_time;
+
+    return last ?: "";
+  }
 
-  priv = phosh_wall_clock_get_instance_private (self);
   return gnome_wall_clock_get_clock (time_only ? priv->time : priv->date_time);
 }
 
@@ -136,19 +203,13 @@ phosh_wall_clock_class_init (PhoshWallClockClass *klass)
 static void
 phosh_wall_clock_init (PhoshWallClock *self)
 {
-  PhoshWallClockPrivate *priv = phosh_wall_clock_get_instance_private (self);
-
-  priv->date_time = gnome_wall_clock_new ();
-  priv->time = g_object_new (GNOME_TYPE_WALL_CLOCK, "time-only", TRUE, NULL);
+  create_clocks (self);
 
-  /* Somewhat icky, we need a distinct handler for each clock because one can
-   * update before the other, and we don't know which one the caller wants to
-   * read from.
-   */
-  g_signal_connect_object (priv->date_time, "notify::clock", G_CALLBACK (on_date_time_changed),
-                           self, G_CONNECT_SWAPPED);
-  g_signal_connect_object (priv->time, "notify::clock", G_CALLBACK (on_time_changed),
-                           self, G_CONNECT_SWAPPED);
+  g_signal_connect_object (phosh_wakeup_scheduler_get_default (),
+                           "notify::screen-off",
+                           G_CALLBACK (on_screen_off_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
 }
 
 
@@ -291,11 +352,22 @@ phosh_wall_clock_string_for_datetime (PhoshWallClock      *self,
                                       GDesktopClockFormat  clock_format,
                                       gboolean             show_full_date)
 {
-  PhoshWallClockPrivate *priv = phosh_wall_clock_get_instance_private (self);
+  PhoshWallClockPrivate *priv;
+  GnomeWallClock *clock;
+  char *str;
 
   g_return_val_if_fail (PHOSH_IS_WALL_CLOCK (self), NULL);
   priv = phosh_wall_clock_get_instance_private (self);
 
-  return gnome_wall_clock_string_for_datetime (priv->time, datetime, clock_format,
-                                               FALSE, show_full_date, FALSE);
+  /* Screen is off, use a short lived clock rather than a ticking one */
+  if (priv->time)
+    clock = g_object_ref (priv->time);
+  else
+    clock = g_object_new (GNOME_TYPE_WALL_CLOCK, "time-only", TRUE, NULL);
+
+  str = gnome_wall_clock_string_for_datetime (clock, datetime, clock_format,
+                                              FALSE, show_full_date, FALSE);
+  g_object_unref (clock);
+
+  return str;
 }
@@ -22,7 +22,8 @@
  * A box of widgets for the lock screen
  *
  * The widget box is displayed on the lock screen
- * and displays a list of loadable widgets.
+ * and displays a list of loadable widgets. The widgets
+ * are only loaded once the box is shown.
  */
 
 enum {
@@ -41,6 +42,8 @@ struct _PhoshWidgetBox {
 
   GStrv                 plugin_dirs;
   GStrv                 plugins;
+  gboolean              needs_load;
+  guint                 load_id;
 };
 G_DEFINE_TYPE (PhoshWidgetBox, phosh_widget_box, GTK_TYPE_BOX)
 
@@ -69,6 +72,8 @@ phosh_widget_box_load_widgets (PhoshWidgetBox *self)
   if (self->plugin_loader == NULL)
     return;
 
+  self->needs_load = FALSE;
+  g_clear_handle_id (&self->load_id, g_source_remove);
   children = gtk_container_get_children (GTK_CONTAINER (self->carousel));
   for (GList *elem = children; elem; elem = elem->next)
     gtk_container_remove (GTK_CONTAINER (self->carousel), GTK_WIDGET (elem->data));
@@ -141,12 +146,68 @@ phosh_widget_box_constructed (GObject *object)
 
   G_OBJECT_CLASS (phosh_widget_box_parent_class)->constructed (object);
 
-  if (self->plugin_dirs == NULL)
+  if (self->plugin_dirs == NULL) {
     self->plugin_dirs = g_strdupv ((GStrv)plugin_dirs);
+    self->plugin_loader =
+      g_object_ref (phosh_plugin_loader_get_default (PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET));
+  } else {
+    self->plugin_loader = phosh_plugin_loader_new (self->plugin_dirs,
+                                                   PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET);
+  }
+}
+
+
+static gboolean
+on_load_idle (gpointer data)
+{
+  PhoshWidgetBox *self = PHOSH_WIDGET_BOX (data);
+
+  self->load_id = 0;
+  phosh_widget_box_load_widgets (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static gboolean
+has_flagged_plugins (PhoshWidgetBox *self)
+{
+  for (int i = 0; self->plugins && self->plugins[i]; i++) {
+    if (phosh_plugin_loader_is_plugin_flagged (self->plugin_loader, self->plugins[i]))
+      return TRUE;
+  }
+
+  return FALSE;
+}
 
-  self->plugin_loader = phosh_plugin_loader_new (self->plugin_dirs,
-                                                 PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET);
 
+static void
+phosh_widget_box_map (GtkWidget *widget)
+{
+  PhoshWidgetBox *self = PHOSH_WIDGET_BOX (widget);
+
+  if (self->needs_load && self->load_id == 0) {
+    if (has_flagged_plugins (self)) {
+      /* Slow plugins shouldn't delay showing the rest of the UI */
+      self->load_id = g_idle_add_full (G_PRIORITY_LOW, on_load_idle, self, NULL);
+      g_source_set_name_by_id (self->load_id, "[phosh] widget box load");
+    } else {
+      phosh_widget_box_load_widgets (self);
+    }
+  }
+
+  GTK_WIDGET_CLASS (phosh_widget_box_parent_class)->map (widget);
+}
+
+
+static void
+phosh_widget_box_dispose (GObject *object)
+{
+  PhoshWidgetBox *self = PHOSH_WIDGET_BOX (object);
+
+  g_clear_handle_id (&self->load_id, g_source_remove);
+
+  G_OBJECT_CLASS (phosh_widget_box_parent_class)->dispose (object);
 }
 
 
@@ -172,8 +233,11 @@ phosh_widget_box_class_init (PhoshWidgetBoxClass *klass)
   object_class->get_property = phosh_widget_box_get_property;
   object_class->set_property = phosh_widget_box_set_property;
   object_class->constructed = phosh_widget_box_constructed;
+  object_class->dispose = phosh_widget_box_dispose;
   object_class->finalize = phosh_widget_box_finalize;
 
+  widget_class->map = phosh_widget_box_map;
+
   props[PROP_PLUGIN_DIRS] =
     g_param_spec_boxed ("plugin-dirs", "", "",
                         G_TYPE_STRV,
@@ -218,7 +282,10 @@ phosh_widget_box_set_plugins (PhoshWidgetBox *self, GStrv plugins)
   g_clear_pointer (&self->plugins, g_strfreev);
   self->plugins = g_strdupv (plugins);
 
-  phosh_widget_box_load_widgets (self);
+  /* Defer loading the plugins' modules until we're shown */
+  self->needs_load = TRUE;
+  if (gtk_widget_get_mapped (GTK_WIDGET (self)))
+    phosh_widget_box_load_widgets (self);
 }
 
 
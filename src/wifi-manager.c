@@ -10,6 +10,7 @@
 #include "phosh-config.h"
 
 #include "wifi-manager.h"
+#include "nm-client-provider.h"
 #include "util.h"
 
 #include <NetworkManager.h>
@@ -986,7 +987,7 @@ on_nm_client_ready (GObject *obj, GAsyncResult *res, gpointer data)
   PhoshWifiManager *self;
   NMClient *client;
 
-  client = nm_client_new_finish (res, &err);
+  client = phosh_nm_client_provider_get_client_finish (PHOSH_NM_CLIENT_PROVIDER (obj), res, &err);
   if (client == NULL) {
     g_message ("Failed to init NM: %s", err->message);
     return;
@@ -1019,7 +1020,10 @@ phosh_wifi_manager_constructed (GObject *object)
   self->networks = g_list_store_new (PHOSH_TYPE_WIFI_NETWORK);
 
   self->cancel = g_cancellable_new ();
-  nm_client_new_async (self->cancel, on_nm_client_ready, self);
+  phosh_nm_client_provider_get_client_async (phosh_nm_client_provider_get_default (),
+                                             self->cancel,
+                                             on_nm_client_ready,
+                                             self);
 
   G_OBJECT_CLASS (phosh_wifi_manager_parent_class)->constructed (object);
 }
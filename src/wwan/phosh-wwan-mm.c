@@ -13,6 +13,7 @@
 
 #include "phosh-wwan-iface.h"
 #include "phosh-wwan-mm.h"
+#include "property-coalescer.h"
 #include "util.h"
 
 #include <libmm-glib.h>
@@ -20,6 +21,9 @@
 
 #define BUS_NAME "org.freedesktop.ModemManager1"
 
+/* Radio related properties can change many times a second in bad coverage */
+#define RADIO_PROPS_INTERVAL 1000 /* ms */
+
 /**
  * PhoshWWanMM:
  *
@@ -48,6 +52,7 @@ typedef struct _PhoshWWanMM {
   MmGdbusModem3gpp               *proxy_3gpp;
   MMManager                      *manager;
   GCancellable                   *cancel;
+  PhoshPropertyCoalescer         *coalescer;
 
   char                           *object_path;
   guint                           signal_quality;
@@ -209,16 +214,11 @@ phosh_wwan_mm_update_enabled (PhoshWWanMM *self)
 
 
 static void
-on_modem_props_changed (MmGdbusModem *proxy,
-                        GVariant     *changed_properties,
-                        GStrv         invaliated,
-                        PhoshWWanMM  *self)
+on_modem_props_changed (PhoshWWanMM *self, GStrv properties)
 {
-  char *property;
-  GVariantIter i;
+  for (int i = 0; properties[i]; i++) {
+    const char *property = properties[i];
 
-  g_variant_iter_init (&i, changed_properties);
-  while (g_variant_iter_next (&i, "{&sv}", &property, NULL)) {
     g_debug ("WWAN property %s changed", property);
     if (g_strcmp0 (property, "AccessTechnologies") == 0) {
       phosh_wwan_mm_update_access_tec (self);
@@ -236,24 +236,30 @@ on_modem_props_changed (MmGdbusModem *proxy,
 }
 
 static void
-on_3gpp_props_changed (MmGdbusModem *proxy,
-                       GVariant     *changed_properties,
-                       GStrv         invaliated,
-                       PhoshWWanMM  *self)
-{
-  char *property;
-  GVariantIter i;
-
-  g_variant_iter_init (&i, changed_properties);
-  while (g_variant_iter_next (&i, "{&sv}", &property, NULL)) {
-    g_debug ("WWAN 3gpp property %s changed", property);
-    if (g_strcmp0 (property, "OperatorName") == 0) {
+on_3gpp_props_changed (PhoshWWanMM *self, GStrv properties)
+{
+  for (int i = 0; properties[i]; i++) {
+    g_debug ("WWAN 3gpp property %s changed", properties[i]);
+    if (g_strcmp0 (properties[i], "OperatorName") == 0) {
       phosh_wwan_mm_update_operator (self);
     }
   }
 }
 
 
+static void
+on_props_changed (PhoshWWanMM            *self,
+                  GObject                *object,
+                  GStrv                   properties,
+                  PhoshPropertyCoalescer *coalescer)
+{
+  if (object == G_OBJECT (self->proxy_modem))
+    on_modem_props_changed (self, properties);
+  else if (object == G_OBJECT (self->proxy_3gpp))
+    on_3gpp_props_changed (self, properties);
+}
+
+
 static void
 phosh_wwan_mm_get_property (GObject    *object,
                             guint       property_id,
@@ -295,11 +301,11 @@ static void
 phosh_wwan_mm_destroy_modem (PhoshWWanMM *self)
 {
   if (self->proxy_modem)
-    g_signal_handlers_disconnect_by_data (self->proxy_modem, self);
+    phosh_property_coalescer_unwatch (self->coalescer, G_DBUS_PROXY (self->proxy_modem));
   g_clear_object (&self->proxy_modem);
 
   if (self->proxy_3gpp)
-    g_signal_handlers_disconnect_by_data (self->proxy_3gpp, self);
+    phosh_property_coalescer_unwatch (self->coalescer, G_DBUS_PROXY (self->proxy_3gpp));
   g_clear_object (&self->proxy_3gpp);
 
   g_clear_pointer (&self->object_path, g_free);
@@ -337,10 +343,7 @@ on_3gpp_proxy_new_for_bus_finish (GObject *source_object, GAsyncResult *res, Pho
     g_object_unref (self);
   }
 
-  g_signal_connect (self->proxy_3gpp,
-                    "g-properties-changed",
-                    G_CALLBACK (on_3gpp_props_changed),
-                    self);
+  phosh_property_coalescer_watch (self->coalescer, G_DBUS_PROXY (self->proxy_3gpp));
   phosh_wwan_mm_update_operator (self);
   g_object_unref (self);
 }
@@ -357,10 +360,7 @@ on_modem_proxy_new_for_bus_finish (GObject *source_object, GAsyncResult *res, Ph
     g_object_unref (self);
   }
 
-  g_signal_connect (self->proxy_modem,
-                    "g-properties-changed",
-                    G_CALLBACK (on_modem_props_changed),
-                    self);
+  phosh_property_coalescer_watch (self->coalescer, G_DBUS_PROXY (self->proxy_modem));
   phosh_wwan_mm_update_signal_quality (self);
   phosh_wwan_mm_update_access_tec (self);
   phosh_wwan_mm_update_lock_status (self);
@@ -474,6 +474,11 @@ phosh_wwan_mm_dispose (GObject *object)
     g_clear_object (&self->manager);
   }
 
+  if (self->coalescer) {
+    g_signal_handlers_disconnect_by_data (self->coalescer, self);
+    g_clear_object (&self->coalescer);
+  }
+
   G_OBJECT_CLASS (phosh_wwan_mm_parent_class)->dispose (object);
 }
 
@@ -638,6 +643,14 @@ phosh_wwan_mm_init (PhoshWWanMM *self)
 {
   self->cancel = g_cancellable_new ();
 
+  self->coalescer = phosh_property_coalescer_new ();
+  phosh_property_coalescer_set_interval (self->coalescer,
+                                         RADIO_PROPS_INTERVAL,
+                                         "SignalQuality",
+                                         "AccessTechnologies",
+                                         NULL);
+  g_signal_connect_swapped (self->coalescer, "changed", G_CALLBACK (on_props_changed), self);
+
   g_bus_get (G_BUS_TYPE_SYSTEM,
              self->cancel,
              (GAsyncReadyCallback)on_bus_get_ready,
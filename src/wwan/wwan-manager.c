@@ -12,6 +12,7 @@
 
 #include "phosh-wwan-iface.h"
 #include "wwan-manager.h"
+#include "nm-client-provider.h"
 #include "util.h"
 
 #include <NetworkManager.h>
@@ -283,7 +284,7 @@ on_nm_client_ready (GObject *obj, GAsyncResult *res, gpointer data)
   PhoshWWanManagerPrivate *priv;
   NMClient *nmclient;
 
-  nmclient = nm_client_new_finish (res, &err);
+  nmclient = phosh_nm_client_provider_get_client_finish (PHOSH_NM_CLIENT_PROVIDER (obj), res, &err);
   if (nmclient == NULL) {
     phosh_async_error_warn (err, "Failed to init NM");
     return;
@@ -315,7 +316,10 @@ phosh_wwan_manager_constructed (GObject *object)
   G_OBJECT_CLASS (phosh_wwan_manager_parent_class)->constructed (object);
 
   priv->cancel = g_cancellable_new ();
-  nm_client_new_async (priv->cancel, on_nm_client_ready, self);
+  phosh_nm_client_provider_get_client_async (phosh_nm_client_provider_get_default (),
+                                             priv->cancel,
+                                             on_nm_client_ready,
+                                             self);
 }
 
 static void
@@ -21,7 +21,41 @@ struct _PhoshToplevelManager {
   GObject parent;
 };
 
-G_DEFINE_TYPE (PhoshToplevelManager, phosh_toplevel_manager, G_TYPE_OBJECT);
+static void phosh_toplevel_manager_list_model_iface_init (GListModelInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (PhoshToplevelManager, phosh_toplevel_manager, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL,
+                                                phosh_toplevel_manager_list_model_iface_init))
+
+
+static GType
+phosh_toplevel_manager_list_model_get_item_type (GListModel *list)
+{
+  return PHOSH_TYPE_TOPLEVEL;
+}
+
+
+static gpointer
+phosh_toplevel_manager_list_model_get_item (GListModel *list, guint position)
+{
+  return NULL;
+}
+
+
+static unsigned int
+phosh_toplevel_manager_list_model_get_n_items (GListModel *list)
+{
+  return 0;
+}
+
+
+static void
+phosh_toplevel_manager_list_model_iface_init (GListModelInterface *iface)
+{
+  iface->get_item_type = phosh_toplevel_manager_list_model_get_item_type;
+  iface->get_item = phosh_toplevel_manager_list_model_get_item;
+  iface->get_n_items = phosh_toplevel_manager_list_model_get_n_items;
+}
 
 
 static void
@@ -69,3 +103,10 @@ phosh_toplevel_manager_get_parent (PhoshToplevelManager *self, PhoshToplevel *to
 {
   return NULL;
 }
+
+
+GPtrArray *
+phosh_toplevel_manager_get_toplevels_for_app_id (PhoshToplevelManager *self, const char *app_id)
+{
+  return g_ptr_array_new ();
+}
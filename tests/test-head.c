@@ -184,6 +184,81 @@ test_phosh_head_scale_fractional (void)
 }
 
 
+static void
+test_phosh_head_scale_cached (void)
+{
+  PhoshHeadMode mode = fourk_mode;
+  g_autofree float *expected = NULL;
+  const float *scales;
+  int num, expected_num;
+
+  expected = phosh_head_calculate_supported_mode_scales (NULL, &mode, &expected_num, TRUE);
+  scales = phosh_head_mode_get_supported_scales (&mode, &num);
+  g_assert_cmpint (num, ==, expected_num);
+  for (int i = 0; i < num; i++)
+    g_assert_true (G_APPROX_VALUE (scales[i], expected[i], FLT_EPSILON));
+
+  /* Subsequent calls use the cached table */
+  g_assert_true (phosh_head_mode_get_supported_scales (&mode, &num) == scales);
+
+  g_free (mode.supported_scales);
+}
+
+
+static void
+test_phosh_head_modes_to_variant (void)
+{
+  PhoshHeadMode current = { .width = 720, .height = 1440, .refresh = 60000, .name = "720x1440" };
+  PhoshHeadMode other = { .width = 1024, .height = 768, .refresh = 50000, .preferred = TRUE,
+                          .name = "1024x768" };
+  PhoshHeadMode unnamed = small_mode;
+  g_autoptr (GPtrArray) modes = g_ptr_array_new ();
+  g_autoptr (GVariant) variant = NULL;
+  g_autoptr (GVariant) scales = NULL;
+  g_autoptr (GVariant) properties = NULL;
+  const char *name;
+  gboolean is_current, is_preferred;
+  double refresh;
+  int width, height;
+
+  g_ptr_array_add (modes, &current);
+  g_ptr_array_add (modes, &unnamed);
+  g_ptr_array_add (modes, &other);
+
+  g_test_expect_message (NULL, G_LOG_LEVEL_WARNING, "*unnamend mode*");
+  variant = g_variant_ref_sink (phosh_head_modes_to_variant (modes, &current));
+  g_test_assert_expected_messages ();
+
+  g_assert_cmpstr (g_variant_get_type_string (variant), ==, "a(siiddada{sv})");
+  g_assert_cmpint (g_variant_n_children (variant), ==, 2);
+
+  g_variant_get_child (variant, 0, "(&siidd@ad@a{sv})", &name, &width, &height, &refresh,
+                       NULL, &scales, &properties);
+  g_assert_cmpstr (name, ==, "720x1440");
+  g_assert_cmpint (width, ==, 720);
+  g_assert_cmpint (height, ==, 1440);
+  g_assert_true (G_APPROX_VALUE (refresh, 60.0, DBL_EPSILON));
+  g_assert_cmpint (g_variant_n_children (scales), ==, current.n_supported_scales);
+  g_assert_true (g_variant_lookup (properties, "is-current", "b", &is_current));
+  g_assert_true (is_current);
+  g_assert_true (g_variant_lookup (properties, "is-preferred", "b", &is_preferred));
+  g_assert_false (is_preferred);
+  g_clear_pointer (&scales, g_variant_unref);
+  g_clear_pointer (&properties, g_variant_unref);
+
+  g_variant_get_child (variant, 1, "(&siidd@ad@a{sv})", &name, &width, &height, &refresh,
+                       NULL, &scales, &properties);
+  g_assert_cmpstr (name, ==, "1024x768");
+  g_assert_true (g_variant_lookup (properties, "is-current", "b", &is_current));
+  g_assert_false (is_current);
+  g_assert_true (g_variant_lookup (properties, "is-preferred", "b", &is_preferred));
+  g_assert_true (is_preferred);
+
+  g_free (current.supported_scales);
+  g_free (other.supported_scales);
+}
+
+
 int
 main (int   argc,
       char *argv[])
@@ -193,6 +268,8 @@ main (int   argc,
   g_test_add_func("/phosh/head/layout/set_transform", test_phosh_head_set_transform);
   g_test_add_func("/phosh/head/scale/integer", test_phosh_head_scale_integer);
   g_test_add_func("/phosh/head/scale/fractional", test_phosh_head_scale_fractional);
+  g_test_add_func("/phosh/head/scale/cached", test_phosh_head_scale_cached);
+  g_test_add_func("/phosh/head/modes-to-variant", test_phosh_head_modes_to_variant);
 
   return g_test_run();
 }
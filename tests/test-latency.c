@@ -0,0 +1,747 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * End to end latency of common interactions: Input is injected via a
+ * virtual keyboard, DBus or the shell's managers and we measure the
+ * time until the shell state changed and until the next frame got
+ * committed afterwards. Results are written as JSON report.
+ */
+
+#include "phosh-config.h"
+
+#include "app-tracker.h"
+#include "lockscreen-manager.h"
+#include "notify-dbus.h"
+#include "shell.h"
+#include "splash.h"
+#include "toplevel-manager.h"
+#include "notifications/notify-manager.h"
+
+#include "testlib-full-shell.h"
+#include "testlib-wait-for-shell-state.h"
+
+#include <gio/gdesktopappinfo.h>
+
+#include <signal.h>
+
+#define POP_TIMEOUT 50000000
+#define WAIT_TIMEOUT 30000
+/* Time to let animations finish between two runs */
+#define SETTLE_TIMEOUT 500
+
+#define N_RUNS 5
+#define N_TOPLEVELS 4
+#define N_NOTIFICATIONS 500
+
+#define APP_ID "mobi.phosh.LatencyTest"
+
+static char *data_home;
+
+typedef enum {
+  EVENT_FRAME,
+  EVENT_STATE,
+  EVENT_TOPLEVELS,
+  EVENT_NOTIFICATION,
+  EVENT_SPLASH,
+  EVENT_LAST,
+} EventType;
+
+typedef struct {
+  EventType type;
+  gint64    time;
+  /* Frame duration in µs, shell state or number of toplevels */
+  int       value;
+} Event;
+
+typedef struct _LatencyWatcher LatencyWatcher;
+
+typedef struct {
+  LatencyWatcher *watcher;
+  GtkWidget      *surface;
+  GdkFrameClock  *frame_clock;
+  gint64          frame_start;
+} WatchedClock;
+
+/*
+ * Collects frames and shell events in the shell thread and hands them
+ * to the test thread.
+ */
+struct _LatencyWatcher {
+  PhoshShell  *shell;
+  GAsyncQueue *events;
+  GAsyncQueue *done;
+
+  /* Only touched in the shell thread */
+  gulong       map_hook_id;
+  GPtrArray   *clocks;
+  guint        n_notifications;
+
+  /* Only touched in the test thread */
+  Event        seen[EVENT_LAST];
+  guint        n_frames;
+  gint64       max_frame_us;
+};
+
+typedef struct {
+  char   *name;
+  GArray *state_us;
+  GArray *frame_us;
+  guint   n_frames;
+  gint64  max_frame_us;
+} Scenario;
+
+
+static void
+watched_clock_free (WatchedClock *clock)
+{
+  g_signal_handlers_disconnect_by_data (clock->frame_clock, clock);
+  g_signal_handlers_disconnect_by_data (clock->surface, clock);
+  g_object_unref (clock->frame_clock);
+  g_free (clock);
+}
+
+
+static void
+push_event (LatencyWatcher *self, EventType type, gint64 time, int value)
+{
+  Event *event = g_new0 (Event, 1);
+
+  event->type = type;
+  event->time = time;
+  event->value = value;
+  g_async_queue_push (self->events, event);
+}
+
+
+static void
+on_before_paint (GdkFrameClock *frame_clock, WatchedClock *clock)
+{
+  clock->frame_start = g_get_monotonic_time ();
+}
+
+
+static void
+on_after_paint (GdkFrameClock *frame_clock, WatchedClock *clock)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (clock->frame_start == 0)
+    return;
+
+  /* GTK commits the surface right before emitting after-paint */
+  push_event (clock->watcher, EVENT_FRAME, now, now - clock->frame_start);
+  clock->frame_start = 0;
+}
+
+
+static void
+on_surface_unrealize (GtkWidget *surface, WatchedClock *clock)
+{
+  g_ptr_array_remove (clock->watcher->clocks, clock);
+}
+
+
+static void
+watch_surface (LatencyWatcher *self, GtkWidget *surface)
+{
+  GdkFrameClock *frame_clock;
+  WatchedClock *clock;
+
+  if (!gtk_widget_is_toplevel (surface))
+    return;
+
+  frame_clock = gtk_widget_get_frame_clock (surface);
+  if (frame_clock == NULL)
+    return;
+
+  for (guint i = 0; i < self->clocks->len; i++) {
+    clock = g_ptr_array_index (self->clocks, i);
+    if (clock->frame_clock == frame_clock)
+      return;
+  }
+
+  clock = g_new0 (WatchedClock, 1);
+  clock->watcher = self;
+  clock->surface = surface;
+  clock->frame_clock = g_object_ref (frame_clock);
+  g_ptr_array_add (self->clocks, clock);
+
+  g_signal_connect (surface, "unrealize", G_CALLBACK (on_surface_unrealize), clock);
+  g_object_connect (frame_clock,
+                    "signal::before-paint", G_CALLBACK (on_before_paint), clock,
+                    "signal::after-paint", G_CALLBACK (on_after_paint), clock,
+                    NULL);
+}
+
+
+static gboolean
+on_widget_map_emission (GSignalInvocationHint *ihint,
+                        guint                  n_param_values,
+                        const GValue          *param_values,
+                        gpointer               user_data)
+{
+  LatencyWatcher *self = user_data;
+  GtkWidget *widget = g_value_get_object (&param_values[0]);
+
+  watch_surface (self, widget);
+
+  if (PHOSH_IS_SPLASH (widget))
+    push_event (self, EVENT_SPLASH, g_get_monotonic_time (), 0);
+
+  return TRUE;
+}
+
+
+static void
+on_shell_state_changed (LatencyWatcher *self)
+{
+  push_event (self, EVENT_STATE, g_get_monotonic_time (), phosh_shell_get_state (self->shell));
+}
+
+
+static void
+on_num_toplevels_changed (LatencyWatcher *self, GParamSpec *pspec, PhoshToplevelManager *manager)
+{
+  push_event (self,
+              EVENT_TOPLEVELS,
+              g_get_monotonic_time (),
+              phosh_toplevel_manager_get_num_toplevels (manager));
+}
+
+
+static void
+on_new_notification (LatencyWatcher *self)
+{
+  self->n_notifications++;
+  push_event (self, EVENT_NOTIFICATION, g_get_monotonic_time (), self->n_notifications);
+}
+
+
+static void
+on_watcher_start (gpointer data)
+{
+  LatencyWatcher *self = data;
+  g_autoptr (GList) toplevels = gtk_window_list_toplevels ();
+
+  for (GList *l = toplevels; l; l = l->next) {
+    if (gtk_widget_get_realized (l->data))
+      watch_surface (self, l->data);
+  }
+
+  self->map_hook_id = g_signal_add_emission_hook (g_signal_lookup ("map", GTK_TYPE_WIDGET),
+                                                  0,
+                                                  on_widget_map_emission,
+                                                  self,
+                                                  NULL);
+
+  g_signal_connect_swapped (self->shell, "notify::shell-state",
+                            G_CALLBACK (on_shell_state_changed), self);
+  g_signal_connect_swapped (phosh_shell_get_toplevel_manager (self->shell), "notify::num-toplevels",
+                            G_CALLBACK (on_num_toplevels_changed), self);
+  g_signal_connect_swapped (phosh_notify_manager_get_default (), "new-notification",
+                            G_CALLBACK (on_new_notification), self);
+
+  g_async_queue_push (self->done, (gpointer)TRUE);
+}
+
+
+static void
+on_watcher_stop (gpointer data)
+{
+  LatencyWatcher *self = data;
+
+  g_signal_remove_emission_hook (g_signal_lookup ("map", GTK_TYPE_WIDGET), self->map_hook_id);
+  g_signal_handlers_disconnect_by_data (self->shell, self);
+  g_signal_handlers_disconnect_by_data (phosh_shell_get_toplevel_manager (self->shell), self);
+  g_signal_handlers_disconnect_by_data (phosh_notify_manager_get_default (), self);
+  g_clear_pointer (&self->clocks, g_ptr_array_unref);
+
+  g_async_queue_push (self->done, (gpointer)TRUE);
+}
+
+
+static LatencyWatcher *
+latency_watcher_new (PhoshShell *shell)
+{
+  LatencyWatcher *self = g_new0 (LatencyWatcher, 1);
+
+  self->shell = shell;
+  self->events = g_async_queue_new_full (g_free);
+  self->done = g_async_queue_new ();
+  self->clocks = g_ptr_array_new_with_free_func ((GDestroyNotify) watched_clock_free);
+
+  /* Signal handlers need to be set up in the shell's thread */
+  g_idle_add_once (on_watcher_start, self);
+  g_assert_nonnull (g_async_queue_timeout_pop (self->done, POP_TIMEOUT));
+
+  return self;
+}
+
+
+static void
+latency_watcher_free (LatencyWatcher *self)
+{
+  g_idle_add_once (on_watcher_stop, self);
+  g_assert_nonnull (g_async_queue_timeout_pop (self->done, POP_TIMEOUT));
+
+  g_async_queue_unref (self->events);
+  g_async_queue_unref (self->done);
+  g_free (self);
+}
+
+
+static void
+latency_watcher_settle (LatencyWatcher *self)
+{
+  Event *event;
+
+  g_usleep (SETTLE_TIMEOUT * 1000);
+
+  while ((event = g_async_queue_try_pop (self->events)))
+    g_free (event);
+
+  self->n_frames = 0;
+  self->max_frame_us = 0;
+}
+
+
+static gboolean
+event_matches (const Event *event, EventType type, int mask, int value, gint64 after)
+{
+  return event->type == type && event->time >= after && (event->value & mask) == value;
+}
+
+/*
+ * Wait for an event of the given type that happened after @after and
+ * whose value masked with @mask equals @value. Returns the time the
+ * event happened.
+ */
+static gint64
+latency_watcher_wait (LatencyWatcher *self, EventType type, int mask, int value, gint64 after)
+{
+  gint64 deadline = g_get_monotonic_time () + WAIT_TIMEOUT * G_TIME_SPAN_MILLISECOND;
+
+  /* Might have been consumed while waiting for something else */
+  if (event_matches (&self->seen[type], type, mask, value, after))
+    return self->seen[type].time;
+
+  while (TRUE) {
+    g_autofree Event *event = NULL;
+    gint64 timeout = deadline - g_get_monotonic_time ();
+
+    if (timeout > 0)
+      event = g_async_queue_timeout_pop (self->events, timeout);
+
+    if (event == NULL)
+      g_error ("Timed out waiting for event %d with value %d", type, value);
+
+    self->seen[event->type] = *event;
+
+    if (event->type == EVENT_FRAME && event->time >= after) {
+      self->n_frames++;
+      self->max_frame_us = MAX (self->max_frame_us, event->value);
+    }
+
+    if (event_matches (event, type, mask, value, after))
+      return event->time;
+  }
+}
+
+
+static Scenario *
+scenario_new (const char *name)
+{
+  Scenario *scenario = g_new0 (Scenario, 1);
+
+  scenario->name = g_strdup (name);
+  scenario->state_us = g_array_new (FALSE, FALSE, sizeof (gint64));
+  scenario->frame_us = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+  return scenario;
+}
+
+
+static void
+scenario_free (Scenario *scenario)
+{
+  g_array_unref (scenario->state_us);
+  g_array_unref (scenario->frame_us);
+  g_free (scenario->name);
+  g_free (scenario);
+}
+
+
+static Scenario *
+add_scenario (GPtrArray *scenarios, const char *name)
+{
+  Scenario *scenario = scenario_new (name);
+
+  g_ptr_array_add (scenarios, scenario);
+  return scenario;
+}
+
+/*
+ * Record one run: @start is when input was injected, @changed when
+ * the shell reacted. The committed frame is the first one that
+ * finished after the change.
+ */
+static void
+scenario_record (Scenario *scenario, LatencyWatcher *watcher, gint64 start, gint64 changed)
+{
+  gint64 frame, state_us, frame_us;
+
+  frame = latency_watcher_wait (watcher, EVENT_FRAME, 0, 0, changed);
+
+  state_us = changed - start;
+  frame_us = frame - start;
+  g_array_append_val (scenario->state_us, state_us);
+  g_array_append_val (scenario->frame_us, frame_us);
+
+  scenario->n_frames += watcher->n_frames;
+  scenario->max_frame_us = MAX (scenario->max_frame_us, watcher->max_frame_us);
+
+  g_test_message ("%s: state %.2f ms, frame %.2f ms",
+                  scenario->name, state_us / 1000.0, frame_us / 1000.0);
+}
+
+
+static gint
+compare_times (gconstpointer a, gconstpointer b)
+{
+  gint64 ta = *(const gint64 *)a;
+  gint64 tb = *(const gint64 *)b;
+
+  return (ta > tb) - (ta < tb);
+}
+
+
+static void
+append_times (GString *json, const char *key, GArray *times)
+{
+  gint64 min, median, max;
+
+  g_array_sort (times, compare_times);
+  min = g_array_index (times, gint64, 0);
+  median = g_array_index (times, gint64, times->len / 2);
+  max = g_array_index (times, gint64, times->len - 1);
+
+  g_string_append_printf (json,
+                          "      \"%s\": { \"min\": %.3f, \"median\": %.3f, \"max\": %.3f },\n",
+                          key, min / 1000.0, median / 1000.0, max / 1000.0);
+}
+
+
+static void
+write_report (GPtrArray *scenarios)
+{
+  g_autoptr (GString) json = g_string_new ("{\n  \"scenarios\": [\n");
+  g_autoptr (GError) err = NULL;
+  g_autofree char *filename = NULL;
+  const char *report;
+
+  for (guint i = 0; i < scenarios->len; i++) {
+    Scenario *scenario = g_ptr_array_index (scenarios, i);
+
+    g_assert_cmpint (scenario->state_us->len, >, 0);
+
+    g_string_append_printf (json, "    {\n      \"name\": \"%s\",\n      \"runs\": %u,\n",
+                            scenario->name, scenario->state_us->len);
+    append_times (json, "input-to-state-ms", scenario->state_us);
+    append_times (json, "input-to-frame-ms", scenario->frame_us);
+    g_string_append_printf (json,
+                            "      \"frames\": %u,\n      \"max-frame-ms\": %.3f\n    }%s\n",
+                            scenario->n_frames,
+                            scenario->max_frame_us / 1000.0,
+                            i + 1 < scenarios->len ? "," : "");
+  }
+  g_string_append (json, "  ]\n}\n");
+
+  report = g_getenv ("PHOSH_TEST_LATENCY_REPORT");
+  if (report == NULL) {
+    filename = g_build_filename (TEST_OUTPUT_DIR, "latency-report.json", NULL);
+    report = filename;
+  }
+
+  g_file_set_contents (report, json->str, json->len, &err);
+  g_assert_no_error (err);
+  g_test_message ("Latency report at %s", report);
+}
+
+
+static void
+toggle_with_key (LatencyWatcher                 *watcher,
+                 Scenario                       *scenario,
+                 struct zwp_virtual_keyboard_v1 *keyboard,
+                 GTimer                         *timer,
+                 guint                           key,
+                 PhoshShellStateFlags            state,
+                 gboolean                        enabled)
+{
+  gint64 start, changed;
+
+  latency_watcher_settle (watcher);
+
+  start = g_get_monotonic_time ();
+  phosh_test_keyboard_press_modifiers (keyboard, KEY_LEFTMETA);
+  phosh_test_keyboard_press_keys (keyboard, timer, key, NULL);
+  phosh_test_keyboard_release_modifiers (keyboard);
+
+  changed = latency_watcher_wait (watcher, EVENT_STATE, state, enabled ? state : 0, start);
+  scenario_record (scenario, watcher, start, changed);
+}
+
+
+static void
+run_overview (LatencyWatcher                 *watcher,
+              GPtrArray                      *scenarios,
+              struct zwp_virtual_keyboard_v1 *keyboard,
+              GTimer                         *timer,
+              PhoshTestWaitForShellState     *waiter)
+{
+  const char *argv[] = { TEST_TOOLS "/app-buttons", NULL };
+  Scenario *open = add_scenario (scenarios, "overview-open");
+  Scenario *close = add_scenario (scenarios, "overview-close");
+  GPid pids[N_TOPLEVELS];
+  gint64 start;
+
+  /* Fill the overview with toplevels */
+  start = g_get_monotonic_time ();
+  for (int i = 0; i < N_TOPLEVELS; i++) {
+    g_autoptr (GError) err = NULL;
+
+    g_spawn_async (NULL, (char **)argv, NULL, G_SPAWN_DEFAULT, NULL, NULL, &pids[i], &err);
+    g_assert_no_error (err);
+  }
+  latency_watcher_wait (watcher, EVENT_TOPLEVELS, -1, N_TOPLEVELS, start);
+  phosh_test_wait_for_shell_state_wait (waiter, PHOSH_STATE_OVERVIEW, FALSE, WAIT_TIMEOUT);
+
+  for (int i = 0; i < N_RUNS; i++) {
+    toggle_with_key (watcher, open, keyboard, timer, KEY_A, PHOSH_STATE_OVERVIEW, TRUE);
+    toggle_with_key (watcher, close, keyboard, timer, KEY_A, PHOSH_STATE_OVERVIEW, FALSE);
+  }
+
+  start = g_get_monotonic_time ();
+  for (int i = 0; i < N_TOPLEVELS; i++) {
+    kill (pids[i], SIGTERM);
+    g_spawn_close_pid (pids[i]);
+  }
+  latency_watcher_wait (watcher, EVENT_TOPLEVELS, -1, 0, start);
+}
+
+
+static void
+run_settings (LatencyWatcher                 *watcher,
+              GPtrArray                      *scenarios,
+              struct zwp_virtual_keyboard_v1 *keyboard,
+              GTimer                         *timer)
+{
+  Scenario *open = add_scenario (scenarios, "quick-settings-open");
+  Scenario *close = add_scenario (scenarios, "quick-settings-close");
+
+  for (int i = 0; i < N_RUNS; i++) {
+    toggle_with_key (watcher, open, keyboard, timer, KEY_M, PHOSH_STATE_SETTINGS, TRUE);
+    toggle_with_key (watcher, close, keyboard, timer, KEY_M, PHOSH_STATE_SETTINGS, FALSE);
+  }
+}
+
+
+static void
+on_lock (gpointer data)
+{
+  PhoshLockscreenManager *manager;
+
+  manager = phosh_shell_get_lockscreen_manager (phosh_shell_get_default ());
+  phosh_lockscreen_manager_set_locked (manager, GPOINTER_TO_INT (data));
+}
+
+
+static void
+run_lock (LatencyWatcher *watcher, GPtrArray *scenarios)
+{
+  Scenario *lock = add_scenario (scenarios, "lock");
+  Scenario *unlock = add_scenario (scenarios, "unlock");
+
+  for (int i = 0; i < N_RUNS; i++) {
+    gint64 start, changed;
+
+    /* Lock via the manager as the ScreenSaver's Lock() also blanks the
+     * screen so no frames would get committed */
+    latency_watcher_settle (watcher);
+    start = g_get_monotonic_time ();
+    g_idle_add_once (on_lock, GINT_TO_POINTER (TRUE));
+    changed = latency_watcher_wait (watcher, EVENT_STATE, PHOSH_STATE_LOCKED, PHOSH_STATE_LOCKED,
+                                    start);
+    scenario_record (lock, watcher, start, changed);
+
+    latency_watcher_settle (watcher);
+    start = g_get_monotonic_time ();
+    g_idle_add_once (on_lock, GINT_TO_POINTER (FALSE));
+    changed = latency_watcher_wait (watcher, EVENT_STATE, PHOSH_STATE_LOCKED, 0, start);
+    scenario_record (unlock, watcher, start, changed);
+  }
+}
+
+
+static void
+run_notifications (LatencyWatcher *watcher, GPtrArray *scenarios)
+{
+  g_autoptr (PhoshNotifyDBusNotifications) proxy = NULL;
+  g_autoptr (GError) err = NULL;
+  Scenario *scenario = add_scenario (scenarios, "notifications");
+  const char *const *actions = (const char *[]){ NULL };
+  gint64 start, changed;
+  guint first = watcher->seen[EVENT_NOTIFICATION].value;
+
+  proxy = phosh_notify_dbus_notifications_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
+                                                                  G_DBUS_PROXY_FLAGS_NONE,
+                                                                  "org.freedesktop.Notifications",
+                                                                  "/org/freedesktop/Notifications",
+                                                                  NULL,
+                                                                  &err);
+  g_assert_no_error (err);
+
+  latency_watcher_settle (watcher);
+  start = g_get_monotonic_time ();
+  /* Don't wait for replies so notifications arrive as a burst */
+  for (int i = 0; i < N_NOTIFICATIONS; i++) {
+    g_autofree char *summary = g_strdup_printf ("Notification %d", i);
+
+    phosh_notify_dbus_notifications_call_notify (proxy,
+                                                 "com.example.latency",
+                                                 0,
+                                                 "",
+                                                 summary,
+                                                 "Measuring latency",
+                                                 actions,
+                                                 g_variant_new ("a{sv}", NULL),
+                                                 0,
+                                                 NULL,
+                                                 NULL,
+                                                 NULL);
+  }
+
+  changed = latency_watcher_wait (watcher, EVENT_NOTIFICATION, -1, first + N_NOTIFICATIONS, start);
+  scenario_record (scenario, watcher, start, changed);
+}
+
+
+static void
+on_launch_app (gpointer data)
+{
+  g_autoptr (GDesktopAppInfo) info = g_desktop_app_info_new (APP_ID ".desktop");
+  PhoshAppTracker *tracker = phosh_shell_get_app_tracker (phosh_shell_get_default ());
+
+  g_assert_nonnull (info);
+  phosh_app_tracker_launch_app_info (tracker, G_APP_INFO (info));
+}
+
+
+static void
+run_app_launch (LatencyWatcher *watcher, GPtrArray *scenarios, PhoshShell *shell)
+{
+  Scenario *first_frame = add_scenario (scenarios, "app-first-frame");
+  gint64 start, changed;
+
+  latency_watcher_settle (watcher);
+  start = g_get_monotonic_time ();
+  g_idle_add_once (on_launch_app, NULL);
+
+  if (phosh_shell_get_show_splash (shell)) {
+    Scenario *splash = add_scenario (scenarios, "app-splash");
+
+    changed = latency_watcher_wait (watcher, EVENT_SPLASH, 0, 0, start);
+    scenario_record (splash, watcher, start, changed);
+  }
+
+  /* The compositor announces the toplevel once the app committed its first frame */
+  changed = latency_watcher_wait (watcher, EVENT_TOPLEVELS, -1, 1, start);
+  scenario_record (first_frame, watcher, start, changed);
+}
+
+
+static void
+test_latency (PhoshTestFullShellFixture *fixture, gconstpointer unused)
+{
+  struct zwp_virtual_keyboard_v1 *keyboard;
+  g_autoptr (GTimer) timer = g_timer_new ();
+  g_autoptr (PhoshTestWaitForShellState) waiter = NULL;
+  g_autoptr (GPtrArray) scenarios = g_ptr_array_new_with_free_func ((GDestroyNotify) scenario_free);
+  PhoshShell *shell;
+  LatencyWatcher *watcher;
+
+  /* Wait until compositor and shell are up */
+  g_assert_nonnull (g_async_queue_timeout_pop (fixture->queue, POP_TIMEOUT));
+
+  shell = phosh_shell_get_default ();
+  waiter = phosh_test_wait_for_shell_state_new (shell);
+  phosh_test_wait_for_shell_state_wait (waiter, PHOSH_STATE_SETTINGS, FALSE, WAIT_TIMEOUT);
+
+  keyboard = phosh_test_keyboard_new (phosh_wayland_get_default ());
+  watcher = latency_watcher_new (shell);
+
+  run_overview (watcher, scenarios, keyboard, timer, waiter);
+  run_settings (watcher, scenarios, keyboard, timer);
+  run_lock (watcher, scenarios);
+  run_notifications (watcher, scenarios);
+  run_app_launch (watcher, scenarios, shell);
+
+  latency_watcher_free (watcher);
+
+  write_report (scenarios);
+}
+
+
+static void
+create_desktop_file (void)
+{
+  g_autoptr (GError) err = NULL;
+  g_autofree char *dir = NULL;
+  g_autofree char *filename = NULL;
+  g_autofree char *contents = NULL;
+
+  data_home = g_dir_make_tmp ("phosh-test-latency.XXXXXX", &err);
+  g_assert_no_error (err);
+
+  dir = g_build_filename (data_home, "applications", NULL);
+  g_assert_cmpint (g_mkdir_with_parents (dir, 0755), ==, 0);
+
+  filename = g_build_filename (dir, APP_ID ".desktop", NULL);
+  contents = g_strdup_printf ("[Desktop Entry]\n"
+                              "Type=Application\n"
+                              "Name=Latency Test\n"
+                              "Exec=%s/app-buttons\n"
+                              "StartupNotify=true\n",
+                              TEST_TOOLS);
+  g_file_set_contents (filename, contents, -1, &err);
+  g_assert_no_error (err);
+
+  g_setenv ("XDG_DATA_HOME", data_home, TRUE);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_autoptr (PhoshTestFullShellFixtureCfg) cfg = NULL;
+  g_autoptr (GFile) file = NULL;
+  int ret;
+
+  g_test_init (&argc, &argv, NULL);
+
+  create_desktop_file ();
+  cfg = phosh_test_full_shell_fixture_cfg_new (NULL);
+
+  PHOSH_FULL_SHELL_TEST_ADD ("/phosh/latency", cfg, test_latency);
+
+  ret = g_test_run ();
+
+  file = g_file_new_for_path (data_home);
+  phosh_test_remove_tree (file);
+  g_free (data_home);
+
+  return ret;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "memory-accounting.h"
+
+#include <gio/gio.h>
+
+#define HELD_DATA "held"
+
+
+static void
+report_memory (GObject *owner, PhoshMemoryReport *report)
+{
+  report->bytes += GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA));
+  report->objects++;
+}
+
+
+static void
+evict_memory (GObject *owner, PhoshMemoryPressure pressure)
+{
+  guint held = GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA));
+
+  /* Give back half on low pressure, everything otherwise */
+  held = pressure == PHOSH_MEMORY_PRESSURE_LOW ? held / 2 : 0;
+  g_object_set_data (owner, HELD_DATA, GUINT_TO_POINTER (held));
+}
+
+
+static GVariant *
+lookup_stats (PhoshMemoryAccounting *accounting, const char *name)
+{
+  g_autoptr (GVariant) stats = g_variant_ref_sink (phosh_memory_accounting_get_stats (accounting));
+  GVariantIter iter;
+  const char *subsystem;
+  GVariant *dict;
+
+  g_variant_iter_init (&iter, stats);
+  while (g_variant_iter_next (&iter, "(&s@a{sv})", &subsystem, &dict)) {
+    if (g_str_equal (subsystem, name))
+      return dict;
+    g_variant_unref (dict);
+  }
+
+  return NULL;
+}
+
+
+static void
+test_phosh_memory_accounting_report (void)
+{
+  g_autoptr (PhoshMemoryAccounting) accounting = g_object_new (PHOSH_TYPE_MEMORY_ACCOUNTING, NULL);
+  g_autoptr (GObject) first = g_object_new (G_TYPE_OBJECT, NULL);
+  GObject *second = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GVariant) dict = NULL;
+  guint64 bytes;
+  guint32 objects;
+
+  g_object_set_data (first, HELD_DATA, GUINT_TO_POINTER (100));
+  g_object_set_data (second, HELD_DATA, GUINT_TO_POINTER (23));
+  phosh_memory_accounting_add_reporter (accounting, "test", first, report_memory, NULL);
+  phosh_memory_accounting_add_reporter (accounting, "test", second, report_memory, NULL);
+
+  /* Reporters with the same name are summed up */
+  dict = lookup_stats (accounting, "test");
+  g_assert_nonnull (dict);
+  g_assert_true (g_variant_lookup (dict, "bytes", "t", &bytes));
+  g_assert_true (g_variant_lookup (dict, "objects", "u", &objects));
+  g_assert_cmpuint (bytes, ==, 123);
+  g_assert_cmpuint (objects, ==, 2);
+  g_clear_pointer (&dict, g_variant_unref);
+
+  /* Reporters go away with their owner */
+  g_assert_finalize_object (second);
+  dict = lookup_stats (accounting, "test");
+  g_assert_true (g_variant_lookup (dict, "bytes", "t", &bytes));
+  g_assert_true (g_variant_lookup (dict, "objects", "u", &objects));
+  g_assert_cmpuint (bytes, ==, 100);
+  g_assert_cmpuint (objects, ==, 1);
+}
+
+
+static void
+test_phosh_memory_accounting_budget (void)
+{
+  g_autoptr (PhoshMemoryAccounting) accounting = g_object_new (PHOSH_TYPE_MEMORY_ACCOUNTING, NULL);
+  g_autoptr (GObject) owner = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GVariant) dict = NULL;
+  guint64 bytes, budget;
+  guint32 evictions;
+
+  g_object_set_data (owner, HELD_DATA, GUINT_TO_POINTER (2048));
+  phosh_memory_accounting_add_reporter (accounting, "test", owner, report_memory, evict_memory);
+
+  /* Within budget */
+  phosh_memory_accounting_set_budget (accounting, "test", 4096);
+  phosh_memory_accounting_check (accounting);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA)), ==, 2048);
+
+  /* Over budget */
+  phosh_memory_accounting_set_budget (accounting, "test", 1024);
+  phosh_memory_accounting_check (accounting);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA)), ==, 0);
+
+  dict = lookup_stats (accounting, "test");
+  g_assert_true (g_variant_lookup (dict, "bytes", "t", &bytes));
+  g_assert_true (g_variant_lookup (dict, "budget", "t", &budget));
+  g_assert_true (g_variant_lookup (dict, "evictions", "u", &evictions));
+  g_assert_cmpuint (bytes, ==, 0);
+  g_assert_cmpuint (budget, ==, 1024);
+  g_assert_cmpuint (evictions, ==, 1);
+  g_clear_pointer (&dict, g_variant_unref);
+
+  /* No budget, no eviction */
+  g_object_set_data (owner, HELD_DATA, GUINT_TO_POINTER (2048));
+  phosh_memory_accounting_clear_budgets (accounting);
+  phosh_memory_accounting_check (accounting);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA)), ==, 2048);
+}
+
+
+static void
+test_phosh_memory_accounting_load_budgets (void)
+{
+  g_autoptr (PhoshMemoryAccounting) accounting = g_object_new (PHOSH_TYPE_MEMORY_ACCOUNTING, NULL);
+  g_autoptr (GSettings) settings = g_settings_new ("sm.puri.phosh");
+  g_autoptr (GObject) owner = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GVariant) budgets = NULL;
+  g_autoptr (GVariant) dict = NULL;
+  guint64 budget;
+
+  phosh_memory_accounting_add_reporter (accounting, "test", owner, report_memory, evict_memory);
+  phosh_memory_accounting_add_reporter (accounting, "other", owner, report_memory, NULL);
+  phosh_memory_accounting_set_budget (accounting, "other", 4096);
+
+  g_assert_true (g_settings_set_value (settings, "memory-budgets",
+                                       g_variant_new_parsed ("{'test': uint32 2}")));
+  budgets = g_settings_get_value (settings, "memory-budgets");
+  phosh_memory_accounting_load_budgets (accounting, budgets);
+
+  /* Budgets are in KiB */
+  dict = lookup_stats (accounting, "test");
+  g_assert_true (g_variant_lookup (dict, "budget", "t", &budget));
+  g_assert_cmpuint (budget, ==, 2048);
+  g_clear_pointer (&dict, g_variant_unref);
+
+  /* Budgets not in the setting are dropped */
+  dict = lookup_stats (accounting, "other");
+  g_assert_true (g_variant_lookup (dict, "budget", "t", &budget));
+  g_assert_cmpuint (budget, ==, 0);
+
+  g_settings_reset (settings, "memory-budgets");
+}
+
+
+static void
+test_phosh_memory_accounting_shed (void)
+{
+  g_autoptr (PhoshMemoryAccounting) accounting = g_object_new (PHOSH_TYPE_MEMORY_ACCOUNTING, NULL);
+  g_autoptr (GObject) owner = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GObject) other = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GVariant) dict = NULL;
+  guint32 evictions;
+
+  g_object_set_data (owner, HELD_DATA, GUINT_TO_POINTER (2048));
+  g_object_set_data (other, HELD_DATA, GUINT_TO_POINTER (100));
+  phosh_memory_accounting_add_reporter (accounting, "test", owner, report_memory, evict_memory);
+  phosh_memory_accounting_add_reporter (accounting, "other", other, report_memory, NULL);
+
+  /* Shedding doesn't need a budget */
+  phosh_memory_accounting_shed (accounting, PHOSH_MEMORY_PRESSURE_LOW);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA)), ==, 1024);
+
+  phosh_memory_accounting_shed (accounting, PHOSH_MEMORY_PRESSURE_CRITICAL);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (owner, HELD_DATA)), ==, 0);
+
+  dict = lookup_stats (accounting, "test");
+  g_assert_true (g_variant_lookup (dict, "evictions", "u", &evictions));
+  g_assert_cmpuint (evictions, ==, 2);
+  g_clear_pointer (&dict, g_variant_unref);
+
+  /* Subsystems that can't evict are left alone */
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_object_get_data (other, HELD_DATA)), ==, 100);
+  dict = lookup_stats (accounting, "other");
+  g_assert_true (g_variant_lookup (dict, "evictions", "u", &evictions));
+  g_assert_cmpuint (evictions, ==, 0);
+}
+
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/memory-accounting/report", test_phosh_memory_accounting_report);
+  g_test_add_func ("/phosh/memory-accounting/budget", test_phosh_memory_accounting_budget);
+  g_test_add_func ("/phosh/memory-accounting/load-budgets",
+                   test_phosh_memory_accounting_load_budgets);
+  g_test_add_func ("/phosh/memory-accounting/shed", test_phosh_memory_accounting_shed);
+
+  return g_test_run ();
+}
@@ -9,6 +9,8 @@
 #include "phosh-config.h"
 #include "plugin-loader.h"
 
+#include <glib/gstdio.h>
+
 static void
 test_plugin_loader_new (void)
 {
@@ -45,6 +47,8 @@ test_plugin_loader_load (void)
   PhoshPluginLoader *plugin_loader;
 #ifndef PHOSH_USES_ASAN
   GtkWidget *widget;
+  g_autoptr (GVariant) stats = NULL;
+  const char *extension_point, *name;
 #endif
   const char *dirs[] = { TEST_BUILD_DIR "/plugins/calendar", NULL };
 
@@ -56,12 +60,72 @@ test_plugin_loader_load (void)
   g_assert_true (GTK_IS_WIDGET (widget));
   g_object_ref_sink (widget);
 
+  stats = g_variant_ref_sink (phosh_plugin_loader_get_plugin_stats ());
+  g_assert_cmpint (g_variant_n_children (stats), ==, 1);
+  g_variant_get_child (stats, 0, "(&s&s@a{sv})", &extension_point, &name, NULL);
+  g_assert_cmpstr (extension_point, ==, PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET);
+  g_assert_cmpstr (name, ==, "calendar");
+
   gtk_widget_destroy (widget);
 #endif
   g_assert_finalize_object (plugin_loader);
 }
 
 
+static void
+test_plugin_loader_default (void)
+{
+  PhoshPluginLoader *lockscreen_loader, *qs_loader;
+
+  lockscreen_loader = phosh_plugin_loader_get_default (PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET);
+  g_assert_true (PHOSH_IS_PLUGIN_LOADER (lockscreen_loader));
+  g_assert_true (lockscreen_loader ==
+                 phosh_plugin_loader_get_default (PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET));
+
+  qs_loader = phosh_plugin_loader_get_default (PHOSH_EXTENSION_POINT_QUICK_SETTING_WIDGET);
+  g_assert_true (PHOSH_IS_PLUGIN_LOADER (qs_loader));
+  g_assert_true (lockscreen_loader != qs_loader);
+  g_assert_cmpstr (phosh_plugin_loader_get_extension_point (qs_loader), ==,
+                   PHOSH_EXTENSION_POINT_QUICK_SETTING_WIDGET);
+}
+
+
+static void
+test_plugin_loader_load_missing (void)
+{
+  PhoshPluginLoader *plugin_loader;
+  g_autoptr (GError) err = NULL;
+  g_autofree char *tmpdir = NULL;
+  g_autofree char *path = NULL;
+  g_autofree char *contents = NULL;
+  const char *dirs[] = { NULL, NULL };
+
+  /* Metadata of an existing module that isn't a lockscreen widget */
+  tmpdir = g_dir_make_tmp ("phosh-test-plugin-loader.XXXXXX", &err);
+  g_assert_no_error (err);
+  contents = g_strdup_printf ("[Plugin]\n"
+                              "Id=calendar\n"
+                              "Types=quick-setting;\n"
+                              "Plugin=%s/plugins/calendar/libphosh-plugin-calendar.%s\n",
+                              TEST_BUILD_DIR, G_MODULE_SUFFIX);
+  path = g_build_filename (tmpdir, "calendar.plugin", NULL);
+  g_file_set_contents (path, contents, -1, &err);
+  g_assert_no_error (err);
+  dirs[0] = tmpdir;
+
+  plugin_loader = phosh_plugin_loader_new ((GStrv)dirs, PHOSH_EXTENSION_POINT_LOCKSCREEN_WIDGET);
+  /* Indexed for another extension point so the module must not be loaded */
+  g_assert_null (phosh_plugin_loader_load_plugin (plugin_loader, "calendar"));
+  /* Neither in the index nor in the plugin dir */
+  g_assert_null (phosh_plugin_loader_load_plugin (plugin_loader, "doesnotexist"));
+
+  g_assert_finalize_object (plugin_loader);
+
+  g_unlink (path);
+  g_rmdir (tmpdir);
+}
+
+
 int
 main (int   argc,
       char *argv[])
@@ -69,7 +133,10 @@ main (int   argc,
   gtk_test_init (&argc, &argv, NULL);
 
   g_test_add_func("/phosh/plugin-loader/new", test_plugin_loader_new);
+  /* Runs before 'load' as it needs the calendar plugin to not be registered yet */
+  g_test_add_func("/phosh/plugin-loader/load_missing", test_plugin_loader_load_missing);
   g_test_add_func("/phosh/plugin-loader/load", test_plugin_loader_load);
+  g_test_add_func("/phosh/plugin-loader/default", test_plugin_loader_default);
 
   return g_test_run();
 }
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "property-coalescer.h"
+#include "wakeup-scheduler.h"
+
+
+typedef struct {
+  GMainLoop *loop;
+  GObject   *object;
+  guint      n_changed;
+  GStrv      properties;
+} ChangedData;
+
+
+static void
+on_changed (PhoshPropertyCoalescer *coalescer,
+            GObject                *object,
+            GStrv                   properties,
+            ChangedData            *data)
+{
+  g_assert_true (object == data->object);
+
+  data->n_changed++;
+  g_strfreev (data->properties);
+  data->properties = g_strdupv (properties);
+
+  if (data->loop)
+    g_main_loop_quit (data->loop);
+}
+
+
+static void
+test_phosh_property_coalescer_coalesce (void)
+{
+  g_autoptr (PhoshPropertyCoalescer) coalescer = phosh_property_coalescer_new ();
+  g_autoptr (GObject) object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  ChangedData data = { .loop = loop, .object = object };
+
+  g_signal_connect (coalescer, "changed", G_CALLBACK (on_changed), &data);
+
+  phosh_property_coalescer_queue (coalescer, object, "Foo");
+  phosh_property_coalescer_queue (coalescer, object, "Bar");
+  phosh_property_coalescer_queue (coalescer, object, "Foo");
+  g_assert_cmpint (data.n_changed, ==, 0);
+
+  g_main_loop_run (loop);
+  g_assert_cmpint (data.n_changed, ==, 1);
+  g_assert_cmpint (g_strv_length (data.properties), ==, 2);
+  g_assert_true (g_strv_contains ((const char * const *)data.properties, "Foo"));
+  g_assert_true (g_strv_contains ((const char * const *)data.properties, "Bar"));
+
+  g_strfreev (data.properties);
+}
+
+
+static void
+test_phosh_property_coalescer_interval (void)
+{
+  g_autoptr (PhoshPropertyCoalescer) coalescer = phosh_property_coalescer_new ();
+  g_autoptr (GObject) object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  ChangedData data = { .object = object };
+  gint64 start;
+
+  phosh_property_coalescer_set_interval (coalescer, 100, "SignalQuality", NULL);
+  g_signal_connect (coalescer, "changed", G_CALLBACK (on_changed), &data);
+
+  /* First change goes out right away */
+  phosh_property_coalescer_queue (coalescer, object, "SignalQuality");
+  phosh_property_coalescer_flush (coalescer);
+  g_assert_cmpint (data.n_changed, ==, 1);
+
+  /* Subsequent ones are rate limited… */
+  start = g_get_monotonic_time ();
+  phosh_property_coalescer_queue (coalescer, object, "SignalQuality");
+  phosh_property_coalescer_queue (coalescer, object, "State");
+  phosh_property_coalescer_flush (coalescer);
+  g_assert_cmpint (data.n_changed, ==, 2);
+  g_assert_cmpstrv (data.properties, ((const char *[]){ "State", NULL }));
+
+  /* …until the interval passed */
+  data.loop = loop;
+  g_main_loop_run (loop);
+  g_assert_cmpint (data.n_changed, ==, 3);
+  g_assert_cmpstrv (data.properties, ((const char *[]){ "SignalQuality", NULL }));
+  g_assert_cmpint (g_get_monotonic_time () - start, >=, 90 * G_TIME_SPAN_MILLISECOND);
+
+  g_strfreev (data.properties);
+}
+
+
+static void
+test_phosh_property_coalescer_screen_off (void)
+{
+  PhoshWakeupScheduler *scheduler = phosh_wakeup_scheduler_get_default ();
+  g_autoptr (PhoshPropertyCoalescer) coalescer = phosh_property_coalescer_new ();
+  g_autoptr (GObject) object = g_object_new (G_TYPE_OBJECT, NULL);
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  ChangedData data = { .loop = loop, .object = object };
+
+  g_signal_connect (coalescer, "changed", G_CALLBACK (on_changed), &data);
+
+  /* Changes are held back while the screen is off… */
+  phosh_wakeup_scheduler_set_screen_off (scheduler, TRUE);
+  phosh_property_coalescer_queue (coalescer, object, "Foo");
+  phosh_property_coalescer_queue (coalescer, object, "Bar");
+  phosh_property_coalescer_queue (coalescer, object, "Foo");
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (data.n_changed, ==, 0);
+
+  /* …and delivered once when it turns on */
+  phosh_wakeup_scheduler_set_screen_off (scheduler, FALSE);
+  g_main_loop_run (loop);
+  g_assert_cmpint (data.n_changed, ==, 1);
+  g_assert_cmpint (g_strv_length (data.properties), ==, 2);
+
+  g_strfreev (data.properties);
+}
+
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/property-coalescer/coalesce", test_phosh_property_coalescer_coalesce);
+  g_test_add_func ("/phosh/property-coalescer/interval", test_phosh_property_coalescer_interval);
+  g_test_add_func ("/phosh/property-coalescer/screen-off", test_phosh_property_coalescer_screen_off);
+
+  return g_test_run ();
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "sorted-app-list-model.h"
+
+#include <gio/gdesktopappinfo.h>
+
+
+static void
+on_items_changed (GListModel *model,
+                  guint       position,
+                  guint       removed,
+                  guint       added,
+                  guint      *n_changes)
+{
+  (*n_changes) += removed + added;
+}
+
+
+static void
+test_phosh_sorted_app_list_model_sort (void)
+{
+  g_autoptr (GListStore) store = g_list_store_new (G_TYPE_APP_INFO);
+  g_autoptr (PhoshSortedAppListModel) sorted = NULL;
+  g_autoptr (GAppInfo) first = NULL;
+  g_autoptr (GAppInfo) second = NULL;
+  g_autoptr (GAppInfo) item = NULL;
+
+  first = G_APP_INFO (g_desktop_app_info_new ("demo.app.First.desktop"));
+  g_assert_nonnull (first);
+  second = G_APP_INFO (g_desktop_app_info_new ("demo.app.Second.desktop"));
+  g_assert_nonnull (second);
+
+  g_list_store_append (store, first);
+  sorted = phosh_sorted_app_list_model_new (G_LIST_MODEL (store));
+  g_assert_true (phosh_sorted_app_list_model_get_model (sorted) == G_LIST_MODEL (store));
+  g_assert_true (g_list_model_get_item_type (G_LIST_MODEL (sorted)) == G_TYPE_APP_INFO);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (sorted)), ==, 1);
+
+  /* "Med" sorts before "Terminal" */
+  g_list_store_append (store, second);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (sorted)), ==, 2);
+  item = g_list_model_get_item (G_LIST_MODEL (sorted), 0);
+  g_assert_true (item == second);
+  g_clear_object (&item);
+  item = g_list_model_get_item (G_LIST_MODEL (sorted), 1);
+  g_assert_true (item == first);
+  g_clear_object (&item);
+
+  g_assert_null (g_list_model_get_item (G_LIST_MODEL (sorted), 2));
+
+  g_list_store_remove (store, 1);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (sorted)), ==, 1);
+  item = g_list_model_get_item (G_LIST_MODEL (sorted), 0);
+  g_assert_true (item == first);
+}
+
+
+static void
+test_phosh_sorted_app_list_model_minimal_changes (void)
+{
+  g_autoptr (GListStore) store = g_list_store_new (G_TYPE_APP_INFO);
+  g_autoptr (PhoshSortedAppListModel) sorted = NULL;
+  g_autoptr (GAppInfo) first = NULL;
+  g_autoptr (GAppInfo) first_again = NULL;
+  g_autoptr (GAppInfo) second = NULL;
+  g_autoptr (GAppInfo) item = NULL;
+  GAppInfo *items[2];
+  guint n_changes = 0;
+
+  first = G_APP_INFO (g_desktop_app_info_new ("demo.app.First.desktop"));
+  second = G_APP_INFO (g_desktop_app_info_new ("demo.app.Second.desktop"));
+
+  g_list_store_append (store, first);
+  g_list_store_append (store, second);
+  sorted = phosh_sorted_app_list_model_new (G_LIST_MODEL (store));
+  g_signal_connect (sorted, "items-changed", G_CALLBACK (on_items_changed), &n_changes);
+
+  /* Replacing all items with equal ones doesn't cause any changes */
+  first_again = G_APP_INFO (g_desktop_app_info_new ("demo.app.First.desktop"));
+  items[0] = second;
+  items[1] = first_again;
+  g_list_store_splice (store, 0, 2, (gpointer *)items, 2);
+  g_assert_cmpint (n_changes, ==, 0);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (sorted)), ==, 2);
+  /* …and keeps the items consumers already know about */
+  item = g_list_model_get_item (G_LIST_MODEL (sorted), 1);
+  g_assert_true (item == first);
+  g_clear_object (&item);
+
+  /* Only the removed item is affected */
+  g_list_store_splice (store, 0, 2, (gpointer *)items, 1);
+  g_assert_cmpint (n_changes, ==, 1);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (sorted)), ==, 1);
+}
+
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/sorted-app-list-model/sort", test_phosh_sorted_app_list_model_sort);
+  g_test_add_func ("/phosh/sorted-app-list-model/minimal_changes",
+                   test_phosh_sorted_app_list_model_minimal_changes);
+
+  return g_test_run ();
+}
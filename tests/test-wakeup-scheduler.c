@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "wakeup-scheduler.h"
+
+
+static gboolean
+on_wakeup (gpointer data)
+{
+  guint *count = data;
+
+  (*count)++;
+  return G_SOURCE_CONTINUE;
+}
+
+
+static gint64
+get_ready_time (guint id)
+{
+  return g_source_get_ready_time (g_main_context_find_source_by_id (NULL, id));
+}
+
+
+static void
+test_phosh_wakeup_scheduler_align (void)
+{
+  g_autoptr (PhoshWakeupScheduler) scheduler = g_object_new (PHOSH_TYPE_WAKEUP_SCHEDULER, NULL);
+  gint64 now = g_get_monotonic_time ();
+  guint count = 0, id1, id2;
+
+  id1 = phosh_wakeup_scheduler_add (scheduler, "first", 1, PHOSH_WAKEUP_FLAG_NONE,
+                                    on_wakeup, &count);
+  g_usleep (G_USEC_PER_SEC / 4);
+  id2 = phosh_wakeup_scheduler_add (scheduler, "second", 3, PHOSH_WAKEUP_FLAG_NONE,
+                                    on_wakeup, &count);
+
+  /* Wakeups are at least interval seconds away and share a boundary */
+  g_assert_cmpint (get_ready_time (id1), >=, now + G_USEC_PER_SEC);
+  g_assert_cmpint (get_ready_time (id2), >=, now + 3 * G_USEC_PER_SEC);
+  g_assert_cmpint (get_ready_time (id1) % G_USEC_PER_SEC, ==,
+                   get_ready_time (id2) % G_USEC_PER_SEC);
+
+  g_source_remove (id1);
+  g_source_remove (id2);
+}
+
+
+static void
+test_phosh_wakeup_scheduler_screen_off (void)
+{
+  g_autoptr (PhoshWakeupScheduler) scheduler = g_object_new (PHOSH_TYPE_WAKEUP_SCHEDULER, NULL);
+  g_autoptr (GVariant) stats = NULL;
+  guint ui_count = 0, count = 0, ui_id, id, wakeups;
+  gint64 ready_time;
+
+  ui_id = phosh_wakeup_scheduler_add (scheduler, "ui", 60, PHOSH_WAKEUP_FLAG_UI,
+                                      on_wakeup, &ui_count);
+  id = phosh_wakeup_scheduler_add (scheduler, "other", 60, PHOSH_WAKEUP_FLAG_NONE,
+                                   on_wakeup, &count);
+  ready_time = get_ready_time (id);
+
+  /* UI sources are suspended, others are coalesced further */
+  phosh_wakeup_scheduler_set_screen_off (scheduler, TRUE);
+  g_assert_true (phosh_wakeup_scheduler_get_screen_off (scheduler));
+  g_assert_cmpint (get_ready_time (ui_id), ==, -1);
+  g_assert_cmpint (get_ready_time (id), >=, ready_time);
+  g_assert_cmpint (get_ready_time (id), <, ready_time + 10 * G_USEC_PER_SEC);
+
+  /* UI sources catch up when the screen turns on */
+  phosh_wakeup_scheduler_set_screen_off (scheduler, FALSE);
+  while (ui_count == 0)
+    g_main_context_iteration (NULL, TRUE);
+  g_assert_cmpuint (count, ==, 0);
+  g_assert_cmpint (get_ready_time (ui_id), >=, g_get_monotonic_time () + 59 * G_USEC_PER_SEC);
+
+  stats = g_variant_ref_sink (phosh_wakeup_scheduler_get_stats (scheduler));
+  g_assert_true (g_variant_lookup (stats, "ui", "u", &wakeups));
+  g_assert_cmpuint (wakeups, ==, 1);
+  g_assert_false (g_variant_lookup (stats, "other", "u", &wakeups));
+
+  g_source_remove (ui_id);
+  g_source_remove (id);
+}
+
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/wakeup-scheduler/align", test_phosh_wakeup_scheduler_align);
+  g_test_add_func ("/phosh/wakeup-scheduler/screen-off", test_phosh_wakeup_scheduler_screen_off);
+
+  return g_test_run ();
+}